@@ -0,0 +1,288 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime, pthread_barrier, getopt
+
+/* system headers */
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* local headers */
+#include "../text_logger_lib/text_logger.h"
+
+/*
+ * Defines
+ */
+
+#define DEFAULT_MESSAGE_COUNT    (100000) // per thread
+#define DEFAULT_LOG_PATH         "./textlog_bench.log"
+#define ARRAY_LENGTH(array)      (sizeof(array) / sizeof((array)[0]))
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of one benchmark configuration.
+ */
+typedef struct {
+   TextLoggerModeType mode;
+   int threadCount;
+   int messageSize;
+   int bufferSize;
+} BenchCaseType;
+
+/**
+ * @brief This is the structure type of the state shared by the threads of one run.
+ */
+typedef struct {
+   LoggerContextType* pLoggerContext;
+   const char* pMessage; // messageSize characters, null-terminated
+   int messageCount; // per thread
+   uint64_t* pLatencyNs; // messageCount entries per thread
+   pthread_barrier_t startBarrier;
+   int errorCount;
+   pthread_mutex_t errorLock;
+} BenchRunType;
+
+/**
+ * @brief This is the structure type of the arguments of one logging thread.
+ */
+typedef struct {
+   BenchRunType* pRun;
+   int threadIndex;
+} BenchThreadType;
+
+/*
+ * Static
+ */
+
+static const int sMessageSizes[] = { 16, 64, 256, 1024 };
+static const int sBufferSizes[] = { 4 * 1024, 64 * 1024 };
+static const int sThreadCounts[] = { 1, 4 };
+static const TextLoggerModeType sModes[] = { TEXTLOGGER_MODE_SYNC, TEXTLOGGER_MODE_ASYNC, TEXTLOGGER_MODE_PER_THREAD };
+static const char* spModeNames[] = { "sync", "async", "per_thread" };
+static const char* spBackendNames[] = { "stdio", "io_uring", "mmap" };
+static const char* spCompressionNames[] = { "none", "lz4" };
+static char spErrMsg[] = "\n[ERR LIMIT]";
+
+/*
+ * Codes
+ */
+
+/**
+ * Returns a monotonic time in nanoseconds.
+ *
+ * @return current time.
+ */
+static uint64_t Bench_NowNs(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * Orders latencies for qsort.
+ */
+static int Bench_CompareLatency(const void* pLeft, const void* pRight)
+{
+   uint64_t left = *(const uint64_t*) pLeft;
+   uint64_t right = *(const uint64_t*) pRight;
+   return (left > right) - (left < right);
+}
+
+/**
+ * Logging thread: logs messageCount messages, timing each call.
+ *
+ * @param [in,out] pArg Pointer to BenchThreadType.
+ * @return NULL.
+ */
+static void* Bench_LogThread(void* pArg)
+{
+   BenchThreadType* pThread = (BenchThreadType*) pArg;
+   BenchRunType* pRun = pThread->pRun;
+   uint64_t* pLatencyNs = pRun->pLatencyNs + (size_t) pThread->threadIndex * pRun->messageCount;
+   int errorCount = 0;
+
+   pthread_barrier_wait(&pRun->startBarrier);
+   for (int index = 0; index < pRun->messageCount; index++) {
+      uint64_t startNs = Bench_NowNs();
+      TextLoggerStatusType status = TextLogger_LogInfo(pRun->pLoggerContext, pRun->pMessage);
+      pLatencyNs[index] = Bench_NowNs() - startNs;
+      if (TEXTLOGGER_SUCCESS != status) {
+         errorCount++;
+      }
+   }
+
+   pthread_mutex_lock(&pRun->errorLock);
+   pRun->errorCount += errorCount;
+   pthread_mutex_unlock(&pRun->errorLock);
+   return NULL;
+}
+
+/**
+ * Runs one configuration and prints its result line.
+ * Throughput covers logging until TextLogger_Destroy returns, so queued records are included.
+ *
+ * @param [in] pCase Configuration to run.
+ * @param [in] messageCount Messages logged by each thread.
+ * @param [in] flushBufferCount Value of TextLoggerConfigType.flushBufferCount.
+ * @param [in] writeBackend Value of TextLoggerConfigType.writeBackend.
+ * @param [in] gatherMinTextSize Value of TextLoggerConfigType.gatherMinTextSize.
+ * @param [in] compression Value of TextLoggerConfigType.compression.
+ * @param [in] pLogPath Log file, removed before and after the run.
+ * @return 0 if the run completed.
+ * @return 1 if the context could not be created or a call failed.
+ */
+static int Bench_Run(const BenchCaseType* pCase, int messageCount, int flushBufferCount, TextLoggerWriteBackendType writeBackend, int gatherMinTextSize,
+                     TextLoggerCompressionType compression, char* pLogPath)
+{
+   BenchRunType run;
+   size_t latencyCount = (size_t) messageCount * pCase->threadCount;
+   char* pMessage = (char*) malloc(pCase->messageSize + 1);
+   run.pLatencyNs = (uint64_t*) malloc(latencyCount * sizeof(uint64_t));
+   pthread_t* pThreads = (pthread_t*) malloc(pCase->threadCount * sizeof(pthread_t));
+   BenchThreadType* pThreadArgs = (BenchThreadType*) malloc(pCase->threadCount * sizeof(BenchThreadType));
+   if (NULL == pMessage || NULL == run.pLatencyNs || NULL == pThreads || NULL == pThreadArgs) {
+      free(pMessage);
+      free(run.pLatencyNs);
+      free(pThreads);
+      free(pThreadArgs);
+      return 1;
+   }
+   memset(pMessage, 'x', pCase->messageSize);
+   pMessage[pCase->messageSize] = '\0';
+
+   remove(pLogPath);
+   TextLoggerConfigType config;
+   TextLogger_InitConfig(&config, pLogPath, spErrMsg, LOG_LEVEL_VERBOSE, pCase->bufferSize, INT_MAX);
+   config.mode = pCase->mode;
+   config.flushBufferCount = flushBufferCount;
+   config.writeBackend = writeBackend;
+   config.gatherMinTextSize = gatherMinTextSize;
+   config.compression = compression;
+   config.asyncMaxTextSize = pCase->messageSize; // no truncation, same output in every mode
+   run.pLoggerContext = TextLogger_CreateWithConfig(&config);
+   if (NULL == run.pLoggerContext) {
+      fprintf(stderr, "textlog_bench: cannot create logger for %s\n", pLogPath);
+      free(pMessage);
+      free(run.pLatencyNs);
+      free(pThreads);
+      free(pThreadArgs);
+      return 1;
+   }
+   run.pMessage = pMessage;
+   run.messageCount = messageCount;
+   run.errorCount = 0;
+   pthread_mutex_init(&run.errorLock, NULL);
+   pthread_barrier_init(&run.startBarrier, NULL, pCase->threadCount + 1);
+
+   for (int index = 0; index < pCase->threadCount; index++) {
+      pThreadArgs[index].pRun = &run;
+      pThreadArgs[index].threadIndex = index;
+      pthread_create(&pThreads[index], NULL, Bench_LogThread, &pThreadArgs[index]);
+   }
+   pthread_barrier_wait(&run.startBarrier);
+   uint64_t startNs = Bench_NowNs();
+   for (int index = 0; index < pCase->threadCount; index++) {
+      pthread_join(pThreads[index], NULL);
+   }
+   if (TEXTLOGGER_SUCCESS != TextLogger_Destroy(run.pLoggerContext)) {
+      run.errorCount++;
+   }
+   double seconds = (double) (Bench_NowNs() - startNs) / 1e9;
+   remove(pLogPath);
+
+   qsort(run.pLatencyNs, latencyCount, sizeof(uint64_t), Bench_CompareLatency);
+   printf("%s,%d,%d,%d,%d,%s,%d,%s,%zu,%.6f,%.0f,%llu,%llu,%llu,%d\n",
+          spModeNames[pCase->mode], pCase->threadCount, pCase->messageSize, pCase->bufferSize, flushBufferCount, spBackendNames[writeBackend], gatherMinTextSize,
+          spCompressionNames[compression],
+          latencyCount, seconds, (double) latencyCount / seconds,
+          (unsigned long long) run.pLatencyNs[latencyCount / 2],
+          (unsigned long long) run.pLatencyNs[latencyCount * 99 / 100],
+          (unsigned long long) run.pLatencyNs[latencyCount * 999 / 1000],
+          run.errorCount);
+   fflush(stdout);
+
+   pthread_barrier_destroy(&run.startBarrier);
+   pthread_mutex_destroy(&run.errorLock);
+   free(pMessage);
+   free(run.pLatencyNs);
+   free(pThreads);
+   free(pThreadArgs);
+   return (0 == run.errorCount) ? 0 : 1;
+}
+
+/**
+ * main runs every combination of mode, thread count, message size and buffer size
+ * and prints one CSV line per combination. TEXTLOGGER_MODE_SYNC is single-threaded only.
+ *
+ * usage: textlog_bench [-n messages per thread] [-b flush buffer count] [-u | -m] [-g gather min text size] [-z] [-o log file]
+ * -u writes through the io_uring backend, which needs a flush buffer count above 1.
+ * -m formats records straight into the mapped file, with a single buffer.
+ * -g writes messages at least that long from the caller's memory in sync mode, see TextLoggerConfigType.gatherMinTextSize.
+ * -z compresses every flushed buffer with LZ4, with the stdio backend and a single buffer.
+ *
+ * @return 0 if every run completed.
+ * @return 1 if a run failed.
+ * @return -1 if the arguments are invalid.
+ */
+int main(int argc, char* argv[])
+{
+   int messageCount = DEFAULT_MESSAGE_COUNT;
+   int flushBufferCount = 1;
+   TextLoggerWriteBackendType writeBackend = TEXTLOGGER_BACKEND_STDIO;
+   int gatherMinTextSize = 0;
+   TextLoggerCompressionType compression = TEXTLOGGER_COMPRESSION_NONE;
+   char* pLogPath = DEFAULT_LOG_PATH;
+   int option;
+   while (-1 != (option = getopt(argc, argv, "n:b:umg:zo:"))) {
+      if ('n' == option) {
+         messageCount = atoi(optarg);
+      } else if ('b' == option) {
+         flushBufferCount = atoi(optarg);
+      } else if ('u' == option) {
+         writeBackend = TEXTLOGGER_BACKEND_IO_URING;
+      } else if ('m' == option) {
+         writeBackend = TEXTLOGGER_BACKEND_MMAP;
+      } else if ('g' == option) {
+         gatherMinTextSize = atoi(optarg);
+      } else if ('z' == option) {
+         compression = TEXTLOGGER_COMPRESSION_LZ4;
+      } else if ('o' == option) {
+         pLogPath = optarg;
+      } else {
+         messageCount = 0;
+      }
+   }
+   if (0 >= messageCount || 0 >= flushBufferCount || 0 > gatherMinTextSize || optind != argc ||
+       (TEXTLOGGER_BACKEND_IO_URING == writeBackend && 1 == flushBufferCount) ||
+       (TEXTLOGGER_BACKEND_MMAP == writeBackend && 1 != flushBufferCount) ||
+       (TEXTLOGGER_COMPRESSION_LZ4 == compression && (TEXTLOGGER_BACKEND_STDIO != writeBackend || 1 != flushBufferCount))) {
+      fprintf(stderr, "usage: %s [-n messages per thread] [-b flush buffer count] [-u | -m] [-g gather min text size] [-z] [-o log file]\n", argv[0]);
+      return -1;
+   }
+
+   int result = 0;
+   printf("mode,threads,message_size,buffer_size,flush_buffers,backend,gather_min,compression,messages,seconds,messages_per_sec,p50_ns,p99_ns,p999_ns,errors\n");
+   for (size_t modeIndex = 0; modeIndex < ARRAY_LENGTH(sModes); modeIndex++) {
+      for (size_t threadIndex = 0; threadIndex < ARRAY_LENGTH(sThreadCounts); threadIndex++) {
+         if (TEXTLOGGER_MODE_SYNC == sModes[modeIndex] && 1 != sThreadCounts[threadIndex]) {
+            continue; // a sync context is not shared between threads
+         }
+         for (size_t sizeIndex = 0; sizeIndex < ARRAY_LENGTH(sMessageSizes); sizeIndex++) {
+            for (size_t bufferIndex = 0; bufferIndex < ARRAY_LENGTH(sBufferSizes); bufferIndex++) {
+               BenchCaseType benchCase = { sModes[modeIndex], sThreadCounts[threadIndex], sMessageSizes[sizeIndex], sBufferSizes[bufferIndex] };
+               result |= Bench_Run(&benchCase, messageCount, flushBufferCount, writeBackend, gatherMinTextSize, compression, pLogPath);
+            }
+         }
+      }
+   }
+
+   return result;
+}
@@ -0,0 +1,188 @@
+#define _POSIX_C_SOURCE 200809L // pthread
+
+/* system headers */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* local headers */
+#include "../text_logger_lib/text_logger.h"
+
+/*
+ * Defines
+ */
+
+#define TEST_LOG_PATH            "./textlog_async_test.log"
+#define SHED_QUEUE_CAPACITY      (1024)
+#define SHED_THREAD_COUNT        (4)
+#define SHED_FLUSH_INTERVAL      (32) // records a thread logs between flushes, so the queue never holds more than SHED_THREAD_COUNT times this
+#define SHED_MESSAGE_COUNT       (50000) // per thread
+#define TRUNCATE_MAX_TEXT_SIZE   (64)
+#define TRUNCATE_TEXT_LENGTH     (100) // longer than TRUNCATE_MAX_TEXT_SIZE
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the arguments of one logging thread.
+ */
+typedef struct {
+   LoggerContextType* pLoggerContext;
+   int threadIndex;
+   int droppedCount;
+} TestThreadType;
+
+/*
+ * Static
+ */
+
+static char spErrMsg[] = "\n[ERR LIMIT]";
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Logs verbose records, flushing often enough to keep the queue far below
+ * the half full level from which TEXTLOGGER_FULL_DROP_BY_LEVEL sheds them.
+ *
+ * @param [in,out] pArg Pointer to thread arguments.
+ * @return NULL.
+ */
+static void* Test_ShedThread(void* pArg)
+{
+   TestThreadType* pThread = (TestThreadType*) pArg;
+   for (int i = 0; i < SHED_MESSAGE_COUNT; i++) {
+      if (TEXTLOGGER_ERR_QUEUE_FULL == TextLogger_LogfVerbose(pThread->pLoggerContext, "thread %d record %d", pThread->threadIndex, i)) {
+         pThread->droppedCount++;
+      }
+      if (0 == (i + 1) % SHED_FLUSH_INTERVAL) {
+         TextLogger_FlushTextToFileStream(pThread->pLoggerContext);
+      }
+   }
+   return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Checks that TEXTLOGGER_FULL_DROP_BY_LEVEL drops no record while the
+ * writer keeps the queue below half of its capacity. Producers racing the
+ * writer used to see a wrapped-around queue length now and then, so this
+ * is more likely to catch a regression with several cores.
+ *
+ * @return true if the check passes.
+ */
+static bool Test_ShedsNothingBelowHalf(void)
+{
+   TextLoggerConfigType config;
+   TextLogger_InitConfig(&config, TEST_LOG_PATH, spErrMsg, LOG_LEVEL_VERBOSE, 64 * 1024, 1 << 30);
+   config.mode = TEXTLOGGER_MODE_ASYNC;
+   config.asyncQueueCapacity = SHED_QUEUE_CAPACITY;
+   config.asyncFullPolicy = TEXTLOGGER_FULL_DROP_BY_LEVEL;
+   remove(TEST_LOG_PATH);
+   LoggerContextType* pLoggerContext = TextLogger_CreateWithConfig(&config);
+   if (NULL == pLoggerContext) {
+      printf("FAIL shed: cannot create context\n");
+      return false;
+   }
+
+   pthread_t pThreads[SHED_THREAD_COUNT];
+   TestThreadType pArgs[SHED_THREAD_COUNT];
+   for (int i = 0; i < SHED_THREAD_COUNT; i++) {
+      pArgs[i].pLoggerContext = pLoggerContext;
+      pArgs[i].threadIndex = i;
+      pArgs[i].droppedCount = 0;
+      pthread_create(&pThreads[i], NULL, Test_ShedThread, &pArgs[i]);
+   }
+   int droppedCount = 0;
+   for (int i = 0; i < SHED_THREAD_COUNT; i++) {
+      pthread_join(pThreads[i], NULL);
+      droppedCount += pArgs[i].droppedCount;
+   }
+   TextLoggerStatusType status = TextLogger_Destroy(pLoggerContext);
+
+   if (0 != droppedCount || TEXTLOGGER_SUCCESS != status) {
+      printf("FAIL shed: %d verbose records dropped below half capacity, destroy status %d\n", droppedCount, (int) status);
+      return false;
+   }
+   printf("ok shed\n");
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Checks that an over-long message is cut to asyncMaxTextSize the same way
+ * whether the writer formats its captured arguments, the caller formats it
+ * because its arguments do not fit in the slot, or it is logged as plain text.
+ *
+ * @return true if the check passes.
+ */
+static bool Test_TruncatesAlike(void)
+{
+   TextLoggerConfigType config;
+   TextLogger_InitConfig(&config, TEST_LOG_PATH, spErrMsg, LOG_LEVEL_VERBOSE, 64 * 1024, 1 << 30);
+   config.mode = TEXTLOGGER_MODE_ASYNC;
+   config.asyncMaxTextSize = TRUNCATE_MAX_TEXT_SIZE;
+   remove(TEST_LOG_PATH);
+   LoggerContextType* pLoggerContext = TextLogger_CreateWithConfig(&config);
+   if (NULL == pLoggerContext) {
+      printf("FAIL truncate: cannot create context\n");
+      return false;
+   }
+
+   // the same text, formatted from a captured argument, from a string too long to capture, and as it is
+   char pText[TRUNCATE_TEXT_LENGTH + 1];
+   snprintf(pText, sizeof(pText), "%0*d", TRUNCATE_TEXT_LENGTH, 7);
+   TextLogger_LogfInfo(pLoggerContext, "%0*d", TRUNCATE_TEXT_LENGTH, 7);
+   TextLogger_LogfInfo(pLoggerContext, "%s", pText);
+   TextLogger_LogInfo(pLoggerContext, pText);
+   TextLoggerStatusType status = TextLogger_Destroy(pLoggerContext);
+
+   // compare the messages after "[I]: "
+   char pLines[3][TRUNCATE_TEXT_LENGTH + 64];
+   int lineCount = 0;
+   FILE* pFile = fopen(TEST_LOG_PATH, "r");
+   while (NULL != pFile && lineCount < 3 && NULL != fgets(pLines[lineCount], sizeof(pLines[lineCount]), pFile)) {
+      lineCount++;
+   }
+   if (NULL != pFile) {
+      fclose(pFile);
+   }
+   bool isPassed = (TEXTLOGGER_SUCCESS == status && 3 == lineCount);
+   for (int i = 0; isPassed && i < lineCount; i++) {
+      const char* pMessage = strstr(pLines[i], "]: ");
+      isPassed = (NULL != pMessage && strlen(pMessage + 3) == TRUNCATE_MAX_TEXT_SIZE + 1 && // and '\n'
+                  0 == strncmp(pMessage + 3, pText, TRUNCATE_MAX_TEXT_SIZE));
+   }
+
+   if (!isPassed) {
+      printf("FAIL truncate: messages are not all cut to %d bytes, destroy status %d\n", TRUNCATE_MAX_TEXT_SIZE, (int) status);
+      for (int i = 0; i < lineCount; i++) {
+         printf("  %s", pLines[i]);
+      }
+      return false;
+   }
+   printf("ok truncate\n");
+   return true;
+}
+
+/**
+ * main runs the checks of the async queue, writing ./textlog_async_test.log.
+ *
+ * @return 0 if every check passes.
+ * @return 1 otherwise.
+ */
+int main(void)
+{
+   bool isPassed = Test_ShedsNothingBelowHalf();
+   isPassed = Test_TruncatesAlike() && isPassed;
+   remove(TEST_LOG_PATH);
+   return isPassed ? 0 : 1;
+}
@@ -1,4 +1,8 @@
+#define _POSIX_C_SOURCE 200809L // localtime_r
+
 /* system headers */
+#include <limits.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -7,6 +11,9 @@
 
 /* local headers */
 #include "text_logger.h"
+#include "text_logger_binary.h"
+#include "text_logger_internal.h"
+#include "text_logger_lz.h"
 
 /*
  * Defines
@@ -19,45 +26,250 @@
 #define DBGPRINTF(x)
 #endif
 
-#define MAX_STR_SIZE             (128)
-#define LOG_EXTRA_STR_LENGTH     (6) // LOG_EXTRA_STR_LENGTH accounts for adding "[E]: \n" with the log message
+#define MAX_LOGF_STR_SIZE        (1024) // longer printf-style messages are truncated
+
+/*
+ * Static
+ */
+
+// record tags indexed by LogLevelType, each LOG_TAG_STR_LENGTH characters
+static const char spLogLevelTags[][LOG_TAG_STR_LENGTH + 1] = { "", "[E]: ", "[W]: ", "[I]: ", "[D]: ", "[V]: " };
 
 /*
- * Structures
+ * Code
  */
 
 /**
- * @brief This is the structure type of a logger context.
+ * @internal
  *
- * User needs to provide strings containing
- * 1) Full path to file and
- * 2) Error message for if max file size has been reached.
+ * Opens log file in append mode and reads its current size.
  *
- * User needs to also specify
- * 1) minimum log level to filter log messages,
- * 2) max buffer size to store messages before flushing, and
- * 3) max file size allowed to contain all log messages.
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if error occurs when opening the file.
  */
-struct LoggerContext{
-   FILE* pLogFile;
-   char* pTextBuffer;
-   char* pFilePath;
-   char* pErrMsg;
-   int logLevel; // refer to LogLevelType for list of log levels
-   int maxBufferByteSize;
-   int maxFileSize;
-   int currBytePos; // starts 0
-   int totalBytesStored; // starts at 0
-   bool fileLimitIsReached; // starts at false
-};
+static TextLoggerStatusType TextLogger_OpenAppendFile(LoggerContextType* pLoggerContext)
+{
+   // Open file in append mode - binary, readable too when it gets mapped or its blocks are checked
+   bool fileIsRead = (NULL != pLoggerContext->pMmap || NULL != pLoggerContext->pCompress);
+   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, fileIsRead ? "a+b" : "ab");
+   if (NULL == pLoggerContext->pLogFile) {
+      // Failed to open the file
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
 
-/*
- * Code
- */
+   // pTextBuffer already batches writes, so skip stdio's own buffer
+   setvbuf(pLoggerContext->pLogFile, NULL, _IONBF, 0);
+   pLoggerContext->fileOpenTime = time(NULL);
+
+   // Get current file size (only once, the offset is tracked afterwards)
+   fseek(pLoggerContext->pLogFile, 0L, SEEK_END);
+   pLoggerContext->currFileSize = ftell(pLoggerContext->pLogFile);
+   if (0 > pLoggerContext->currFileSize) {
+      fclose(pLoggerContext->pLogFile);
+      pLoggerContext->pLogFile = NULL;
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // compressed file starts with its own magic, the contents follow in blocks
+   bool fileIsNew = (0 == pLoggerContext->currFileSize);
+   if (NULL != pLoggerContext->pCompress && TEXTLOGGER_SUCCESS != TextLogger_CompressOpenFile(pLoggerContext)) {
+      fclose(pLoggerContext->pLogFile);
+      pLoggerContext->pLogFile = NULL;
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // new binary file starts with its magic so textlog_decode can recognize it
+   if (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format && fileIsNew) {
+      bool magicIsWritten;
+      if (NULL != pLoggerContext->pCompress) {
+         magicIsWritten = (TEXTLOGGER_SUCCESS == TextLogger_CompressWrite(pLoggerContext, TEXTLOGGER_BINARY_MAGIC, TEXTLOGGER_BINARY_MAGIC_LENGTH));
+      } else {
+         size_t bytesWritten = fwrite(TEXTLOGGER_BINARY_MAGIC, sizeof(char), TEXTLOGGER_BINARY_MAGIC_LENGTH, pLoggerContext->pLogFile);
+         pLoggerContext->currFileSize += bytesWritten;
+         magicIsWritten = (TEXTLOGGER_BINARY_MAGIC_LENGTH == bytesWritten);
+      }
+      if (!magicIsWritten) {
+         fclose(pLoggerContext->pLogFile);
+         pLoggerContext->pLogFile = NULL;
+         return TEXTLOGGER_ERR_FILE_ERROR;
+      }
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_OpenFile(LoggerContextType* pLoggerContext)
+{
+   // circular files are written in place instead of appended to
+   TextLoggerStatusType status;
+   if (pLoggerContext->circularFile) {
+      status = TextLogger_CircularOpenFile(pLoggerContext);
+   } else {
+      status = TextLogger_OpenAppendFile(pLoggerContext);
+   }
+
+   // records are formatted straight into the mapped file
+   if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pMmap) {
+      status = TextLogger_MmapOpenFile(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         TextLogger_MmapCloseFile(pLoggerContext);
+         fclose(pLoggerContext->pLogFile);
+         pLoggerContext->pLogFile = NULL;
+      }
+   }
+
+   // syncs and flush thread writes now go to the new file
+   if (TEXTLOGGER_SUCCESS == status) {
+      TextLogger_DurableSetFile(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pCrash) {
+      TextLogger_CrashSetFile(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pFlusher) {
+      status = TextLogger_FlusherSetFile(pLoggerContext);
+   }
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_CloseFile(LoggerContextType* pLoggerContext)
+{
+   if (NULL == pLoggerContext->pLogFile) {
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   // unmap and trim the preallocated tail first, or end a compressed file with its index
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   if (NULL != pLoggerContext->pMmap) {
+      status = TextLogger_MmapCloseFile(pLoggerContext);
+   } else if (NULL != pLoggerContext->pCompress) {
+      status = TextLogger_CompressCloseFile(pLoggerContext);
+   }
+
+   if (0 != fclose(pLoggerContext->pLogFile) && TEXTLOGGER_SUCCESS == status) {
+      status = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pLoggerContext->pLogFile = NULL;
+
+   return status;
+}
+
+void TextLogger_InitConfig(TextLoggerConfigType* pConfig, char* pFilePath, char* pErrMsg, int logLevel, int maxBufferByteSize, int maxFileSize)
+{
+   if (NULL == pConfig) {
+      return;
+   }
+
+   pConfig->pFilePath = pFilePath;
+   pConfig->pErrMsg = pErrMsg;
+   pConfig->logLevel = logLevel;
+   pConfig->maxBufferByteSize = maxBufferByteSize;
+   pConfig->maxFileSize = maxFileSize;
+   pConfig->mode = TEXTLOGGER_MODE_SYNC;
+   pConfig->asyncQueueCapacity = 1024;
+   pConfig->asyncMaxTextSize = 256;
+   pConfig->asyncFullPolicy = TEXTLOGGER_FULL_BLOCK;
+   pConfig->format = TEXTLOGGER_FORMAT_TEXT;
+   pConfig->rotationMaxFiles = 0;
+   pConfig->rotationIntervalSec = 0;
+   pConfig->circularFile = false;
+   pConfig->flushBufferCount = 1;
+   pConfig->writeBackend = TEXTLOGGER_BACKEND_STDIO;
+   pConfig->mmapChunkSize = 1024 * 1024;
+   pConfig->durability = TEXTLOGGER_DURABILITY_NONE;
+   pConfig->groupCommitWindowMs = 10;
+   pConfig->gatherMinTextSize = 0;
+   pConfig->compression = TEXTLOGGER_COMPRESSION_NONE;
+   pConfig->rotationCompressThreads = 0;
+   pConfig->flightRecorderSize = 0;
+   pConfig->crashDump = false;
+   pConfig->pBufferFilePath = NULL;
+   pConfig->pDaemonDirPath = NULL;
+   pConfig->daemonRingSize = 1024 * 1024;
+}
 
 LoggerContextType* TextLogger_Create(char* pFilePath, char* pErrMsg, int logLevel, int maxBufferByteSize, int maxFileSize)
 {
-   if (NULL == pFilePath || NULL == pErrMsg) {
+   TextLoggerConfigType config;
+   TextLogger_InitConfig(&config, pFilePath, pErrMsg, logLevel, maxBufferByteSize, maxFileSize);
+   return TextLogger_CreateWithConfig(&config);
+}
+
+LoggerContextType* TextLogger_CreateWithConfig(const TextLoggerConfigType* pConfig)
+{
+   if (NULL == pConfig || NULL == pConfig->pFilePath || NULL == pConfig->pErrMsg) {
+      return NULL;
+   }
+   char* pFilePath = pConfig->pFilePath;
+   char* pErrMsg = pConfig->pErrMsg;
+   int maxBufferByteSize = pConfig->maxBufferByteSize;
+
+   if (1 > pConfig->flushBufferCount) {
+      return NULL;
+   }
+
+   // io_uring writes from the flush thread at tracked offsets, a circular file writes its own header in place
+   if (TEXTLOGGER_BACKEND_IO_URING == pConfig->writeBackend && (1 >= pConfig->flushBufferCount || pConfig->circularFile)) {
+      return NULL;
+   }
+
+   // a mapped file is its own buffer, and trailing zero bytes are only told apart from text records
+   if (TEXTLOGGER_BACKEND_MMAP == pConfig->writeBackend &&
+       (1 != pConfig->flushBufferCount || pConfig->circularFile || TEXTLOGGER_FORMAT_TEXT != pConfig->format)) {
+      return NULL;
+   }
+   if (TEXTLOGGER_BACKEND_STDIO > pConfig->writeBackend || TEXTLOGGER_BACKEND_MMAP < pConfig->writeBackend) {
+      return NULL;
+   }
+
+   if (0 > pConfig->gatherMinTextSize) {
+      return NULL;
+   }
+
+   // blocks are appended one flushed buffer at a time by the caller's or the writer thread
+   if (TEXTLOGGER_COMPRESSION_LZ4 == pConfig->compression &&
+       (TEXTLOGGER_BACKEND_STDIO != pConfig->writeBackend || 1 != pConfig->flushBufferCount || pConfig->circularFile ||
+        0 >= maxBufferByteSize || TEXTLOGGER_LZ_MAX_BLOCK_SIZE < maxBufferByteSize)) {
+      return NULL;
+   }
+   if (TEXTLOGGER_COMPRESSION_NONE > pConfig->compression || TEXTLOGGER_COMPRESSION_LZ4 < pConfig->compression) {
+      return NULL;
+   }
+
+   // rotated files are compressed as a whole, files compressed while logging already are
+   if (0 > pConfig->rotationCompressThreads ||
+       (0 < pConfig->rotationCompressThreads && (0 >= pConfig->rotationMaxFiles || TEXTLOGGER_COMPRESSION_NONE != pConfig->compression))) {
+      return NULL;
+   }
+
+   // the ring must hold a few records of any length, they are cut to half of it
+   if (0 > pConfig->flightRecorderSize || (0 < pConfig->flightRecorderSize && MAX_STR_SIZE > pConfig->flightRecorderSize)) {
+      return NULL;
+   }
+
+   // the handler appends the one buffer being filled to the file, records of other buffers are not in order with it
+   if (pConfig->crashDump && (TEXTLOGGER_BACKEND_STDIO != pConfig->writeBackend || 1 != pConfig->flushBufferCount ||
+       TEXTLOGGER_MODE_PER_THREAD == pConfig->mode || pConfig->circularFile)) {
+      return NULL;
+   }
+
+   // the mapped buffer file is the one pTextBuffer, filled by one thread
+   if (NULL != pConfig->pBufferFilePath && (TEXTLOGGER_BACKEND_STDIO != pConfig->writeBackend || 1 != pConfig->flushBufferCount ||
+       TEXTLOGGER_MODE_PER_THREAD == pConfig->mode || 0 >= maxBufferByteSize)) {
+      return NULL;
+   }
+
+   // the daemon's context writes through stdio with one buffer, and has nothing in the caller's memory to dump or map
+   if (TEXTLOGGER_MODE_DAEMON == pConfig->mode &&
+       (NULL == pConfig->pDaemonDirPath || 4096 > pConfig->daemonRingSize || TEXTLOGGER_BACKEND_STDIO != pConfig->writeBackend ||
+        1 != pConfig->flushBufferCount || pConfig->crashDump || NULL != pConfig->pBufferFilePath ||
+        (TEXTLOGGER_FULL_BLOCK != pConfig->asyncFullPolicy && TEXTLOGGER_FULL_DROP_NEWEST != pConfig->asyncFullPolicy))) {
+      return NULL;
+   }
+
+   // circular files overwrite text in place: binary records cannot be resynchronized after a cut, and they are never rotated
+   if (pConfig->circularFile && (TEXTLOGGER_FORMAT_TEXT != pConfig->format || 0 < pConfig->rotationMaxFiles)) {
       return NULL;
    }
 
@@ -68,16 +280,69 @@ LoggerContextType* TextLogger_Create(char* pFilePath, char* pErrMsg, int logLeve
    }
 
    // initialize parameters
-   pLoggerContext->maxFileSize = maxFileSize - (strlen(pErrMsg) + 1); // reserve fixed amount of space in the file for error message
+   pLoggerContext->format = pConfig->format;
+   pLoggerContext->rotationMaxFiles = pConfig->rotationMaxFiles;
+   pLoggerContext->rotationIntervalSec = pConfig->rotationIntervalSec;
+   pLoggerContext->circularFile = pConfig->circularFile;
+   pLoggerContext->circularWriteHead = 0;
+   pLoggerContext->circularHasWrapped = false;
+   pLoggerContext->fileSizeIsLimited = (0 >= pConfig->rotationMaxFiles && !pConfig->circularFile);
+   if (pLoggerContext->circularFile) {
+      pLoggerContext->maxFileSize = pConfig->maxFileSize - CIRCULAR_HEADER_SIZE; // a circular file is never full, no error message
+   } else {
+      pLoggerContext->maxFileSize = pConfig->maxFileSize - (strlen(pErrMsg) + 1); // reserve fixed amount of space in the file for error message
+   }
+   if (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) {
+      pLoggerContext->maxFileSize -= TEXTLOGGER_BINARY_MAX_HEADER_LENGTH; // error message is wrapped in a raw text record
+   }
+   if (TEXTLOGGER_COMPRESSION_LZ4 == pConfig->compression) {
+      // error message and its binary header are written in blocks of their own, each with an index entry
+      int errMsgBlockCount = 1 + (int) (strlen(pErrMsg) / maxBufferByteSize) + ((TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) ? 1 : 0);
+      pLoggerContext->maxFileSize -= errMsgBlockCount * (TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + TEXTLOGGER_LZ_INDEX_ENTRY_SIZE);
+   }
    if (0 >= pLoggerContext->maxFileSize) {
       free(pLoggerContext);
       return NULL; // maxFileSize is too small
    }
-   pLoggerContext->logLevel = logLevel;
+   // with a flight recorder every level is let through, the ones below logLevel only reach the ring
+   pLoggerContext->filter.logLevel = (0 < pConfig->flightRecorderSize) ? LOG_LEVEL_VERBOSE : pConfig->logLevel;
+   pLoggerContext->fileLogLevel = pConfig->logLevel;
    pLoggerContext->maxBufferByteSize = maxBufferByteSize;
    pLoggerContext->currBytePos = 0;
    pLoggerContext->totalBytesStored = 0;
    pLoggerContext->fileLimitIsReached = false;
+   pLoggerContext->mode = pConfig->mode;
+   pLoggerContext->pAsync = NULL;
+   pLoggerContext->pPerThread = NULL;
+   pLoggerContext->pFlusher = NULL;
+   pLoggerContext->pDurable = NULL;
+   pLoggerContext->pMmap = NULL;
+   pLoggerContext->pGather = NULL;
+   pLoggerContext->gatherMinTextSize = pConfig->gatherMinTextSize;
+   pLoggerContext->pCompress = NULL;
+   pLoggerContext->pArchive = NULL;
+   pLoggerContext->pRecorder = NULL;
+   pLoggerContext->pCrash = NULL;
+   pLoggerContext->pPersist = NULL;
+   pLoggerContext->pDaemon = NULL;
+   pLoggerContext->durability = pConfig->durability;
+   pLoggerContext->cachedTimeStamp = (time_t) -1; // formatted on first use
+   pLoggerContext->cachedMinuteStart = (time_t) -1;
+   pLoggerContext->lastBinaryTimeStamp = 0;
+
+   // records only cross the ring, the daemon opens the file with the same options
+   if (TEXTLOGGER_MODE_DAEMON == pLoggerContext->mode) {
+      pLoggerContext->pLogFile = NULL;
+      pLoggerContext->pTextBuffer = NULL;
+      pLoggerContext->pFilePath = NULL;
+      pLoggerContext->pErrMsg = NULL;
+      if (TEXTLOGGER_SUCCESS != TextLogger_DaemonStart(pLoggerContext, pConfig)) {
+         free(pLoggerContext);
+         pLoggerContext = NULL;
+         return NULL;
+      }
+      return pLoggerContext;
+   }
 
    // dynamically allocate & init file path
    pLoggerContext->pFilePath = (char*) malloc(strlen(pFilePath) + 1); // +1 for the null terminator
@@ -86,257 +351,1130 @@ LoggerContextType* TextLogger_Create(char* pFilePath, char* pErrMsg, int logLeve
       pLoggerContext = NULL;
       return NULL;
    }
-   strcpy(pLoggerContext->pFilePath, pFilePath);
-
-   // dynamically allocate text buffer
-   pLoggerContext->pTextBuffer = (char*) malloc(sizeof(char) * maxBufferByteSize);
-   if (NULL == pLoggerContext->pTextBuffer) {
-      free(pLoggerContext->pFilePath);
-      free(pLoggerContext);
-      pLoggerContext = NULL;
-      return NULL;
+   strcpy(pLoggerContext->pFilePath, pFilePath);
+
+   // dynamically allocate text buffer, or map it from a file that outlives the process
+   if (NULL != pConfig->pBufferFilePath) {
+      if (TEXTLOGGER_SUCCESS != TextLogger_PersistStart(pLoggerContext, pConfig)) {
+         free(pLoggerContext->pFilePath);
+         free(pLoggerContext);
+         pLoggerContext = NULL;
+         return NULL;
+      }
+   } else {
+      pLoggerContext->pTextBuffer = (char*) malloc(sizeof(char) * maxBufferByteSize);
+      if (NULL == pLoggerContext->pTextBuffer) {
+         free(pLoggerContext->pFilePath);
+         free(pLoggerContext);
+         pLoggerContext = NULL;
+         return NULL;
+      }
+   }
+
+   // dynamically allocate & init error msg
+   pLoggerContext->pErrMsg = (char*) malloc(sizeof(char) * (strlen(pErrMsg) + 1));
+   if (NULL == pLoggerContext->pErrMsg) {
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+   strcpy(pLoggerContext->pErrMsg, pErrMsg);
+
+   // sync state follows the log file from the start
+   if (TEXTLOGGER_SUCCESS != TextLogger_DurableStart(pLoggerContext, pConfig)) {
+      free(pLoggerContext->pErrMsg);
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+
+   // mapped file replaces the buffer once it is open
+   if (TEXTLOGGER_BACKEND_MMAP == pConfig->writeBackend && TEXTLOGGER_SUCCESS != TextLogger_MmapStart(pLoggerContext, pConfig)) {
+      TextLogger_DurableStop(pLoggerContext);
+      free(pLoggerContext->pErrMsg);
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+
+   // compressor checks the file as it is opened
+   if (TEXTLOGGER_COMPRESSION_LZ4 == pConfig->compression && TEXTLOGGER_SUCCESS != TextLogger_CompressStart(pLoggerContext)) {
+      TextLogger_DurableStop(pLoggerContext);
+      free(pLoggerContext->pErrMsg);
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+
+   // open log file once for the lifetime of the context
+   pLoggerContext->pLogFile = NULL;
+   if (TEXTLOGGER_SUCCESS != TextLogger_OpenFile(pLoggerContext)) {
+      if (NULL != pLoggerContext->pCompress) {
+         TextLogger_CompressStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pMmap) {
+         TextLogger_MmapStop(pLoggerContext);
+      }
+      TextLogger_DurableStop(pLoggerContext);
+      free(pLoggerContext->pErrMsg);
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+
+   // records a killed process left in the buffer file come before any new one
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   if (0 < pLoggerContext->currBytePos && TEXTLOGGER_ERR_FILE_ERROR == TextLogger_FlushBuffer(pLoggerContext)) {
+      status = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // start flush thread, then writer thread or thread buffer registry
+   if (TEXTLOGGER_SUCCESS == status && 0 < pConfig->flightRecorderSize) {
+      status = TextLogger_RecorderStart(pLoggerContext, pConfig);
+   }
+   if (TEXTLOGGER_SUCCESS == status && pConfig->crashDump) {
+      status = TextLogger_CrashStart(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS == status && 1 < pConfig->flushBufferCount) {
+      status = TextLogger_FlusherStart(pLoggerContext, pConfig);
+   }
+   if (TEXTLOGGER_SUCCESS == status && 0 < pConfig->rotationCompressThreads) {
+      status = TextLogger_ArchiveStart(pLoggerContext, pConfig);
+   }
+
+   // messages are only referenced while the caller waits for the write, and a header must fit in pTextBuffer
+   if (TEXTLOGGER_SUCCESS == status && TEXTLOGGER_MODE_SYNC == pLoggerContext->mode && TEXTLOGGER_BACKEND_STDIO == pConfig->writeBackend &&
+       1 == pConfig->flushBufferCount && !pLoggerContext->circularFile && NULL == pLoggerContext->pCompress && NULL == pLoggerContext->pPersist &&
+       TIMESTAMP_STR_LENGTH + LOG_EXTRA_STR_LENGTH < maxBufferByteSize && TEXTLOGGER_BINARY_MAX_HEADER_LENGTH < maxBufferByteSize) {
+      status = TextLogger_GatherStart(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS == status && TEXTLOGGER_MODE_ASYNC == pLoggerContext->mode) {
+      status = TextLogger_AsyncStart(pLoggerContext, pConfig);
+   } else if (TEXTLOGGER_SUCCESS == status && TEXTLOGGER_MODE_PER_THREAD == pLoggerContext->mode) {
+      status = TextLogger_PerThreadStart(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS != status) {
+      if (NULL != pLoggerContext->pGather) {
+         TextLogger_GatherStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pFlusher) {
+         TextLogger_FlusherStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pCrash) {
+         TextLogger_CrashStop(pLoggerContext);
+      }
+      TextLogger_CloseFile(pLoggerContext);
+      if (NULL != pLoggerContext->pArchive) {
+         TextLogger_ArchiveStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pRecorder) {
+         TextLogger_RecorderStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pCompress) {
+         TextLogger_CompressStop(pLoggerContext);
+      }
+      if (NULL != pLoggerContext->pMmap) {
+         TextLogger_MmapStop(pLoggerContext);
+      }
+      TextLogger_DurableStop(pLoggerContext);
+      free(pLoggerContext->pErrMsg);
+      free(pLoggerContext->pFilePath);
+      if (NULL != pLoggerContext->pPersist) {
+         TextLogger_PersistStop(pLoggerContext);
+      }
+      free(pLoggerContext->pTextBuffer);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return NULL;
+   }
+
+   return pLoggerContext;
+}
+
+TextLoggerStatusType TextLogger_Destroy(LoggerContextType* pLoggerContext)
+{
+   if (NULL == pLoggerContext) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // wait for the daemon to write the ring, it removes the ring file once closed
+   if (NULL != pLoggerContext->pDaemon) {
+      TextLoggerStatusType daemonStatus = TextLogger_DaemonStop(pLoggerContext);
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+      return daemonStatus;
+   }
+
+   // drain queued records and stop writer thread
+   if (NULL != pLoggerContext->pAsync) {
+      TextLogger_AsyncStop(pLoggerContext);
+   }
+
+   // merge thread buffers and free them
+   if (NULL != pLoggerContext->pPerThread) {
+      TextLogger_PerThreadStop(pLoggerContext);
+   }
+
+   // Flush any remaining text to file
+   TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+   if (NULL != pLoggerContext->pGather) {
+      TextLogger_GatherStop(pLoggerContext);
+   }
+
+   // records only kept in memory are dropped, no error asked for them
+   if (NULL != pLoggerContext->pRecorder) {
+      TextLogger_RecorderStop(pLoggerContext);
+   }
+
+   // wait for buffers in flight and stop flush thread
+   if (NULL != pLoggerContext->pFlusher) {
+      TextLoggerStatusType flusherStatus = TextLogger_FlusherStop(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = flusherStatus;
+      }
+   }
+
+   // nothing is left to dump, the context is about to be freed
+   if (NULL != pLoggerContext->pCrash) {
+      TextLogger_CrashStop(pLoggerContext);
+   }
+
+   // close log file
+   TextLoggerStatusType closeStatus = TextLogger_CloseFile(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS == status) {
+      status = closeStatus;
+   }
+   if (NULL != pLoggerContext->pCompress) {
+      TextLogger_CompressStop(pLoggerContext);
+   }
+   if (NULL != pLoggerContext->pMmap) {
+      TextLogger_MmapStop(pLoggerContext);
+   }
+
+   // rotated files still queued are compressed before the threads stop
+   if (NULL != pLoggerContext->pArchive) {
+      TextLogger_ArchiveStop(pLoggerContext);
+   }
+
+   // sync what was written, the sync state has its own descriptor, and stop sync thread
+   if (NULL != pLoggerContext->pDurable) {
+      TextLoggerStatusType durableStatus = TextLogger_DurableStop(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = durableStatus;
+      }
+   }
+
+   // free allocated memory for pLoggerContext->pErrMsg
+   if (NULL != pLoggerContext->pErrMsg) {
+      free(pLoggerContext->pErrMsg);
+      pLoggerContext->pErrMsg = NULL;
+   }
+
+   // free allocated memory for pLoggerContext->pFilePath
+   if (NULL != pLoggerContext->pFilePath) {
+      free(pLoggerContext->pFilePath);
+      pLoggerContext->pFilePath = NULL;
+   }
+
+   // free allocated memory for pLoggerContext->pTextBuffer, a buffer file is kept for the next context
+   if (NULL != pLoggerContext->pPersist) {
+      TextLogger_PersistStop(pLoggerContext);
+   }
+   if (NULL != pLoggerContext->pTextBuffer) {
+      free(pLoggerContext->pTextBuffer);
+      pLoggerContext->pTextBuffer = NULL;
+   }
+
+   // free allocated memory for pLoggerContext
+   if (NULL != pLoggerContext) {
+      free(pLoggerContext);
+      pLoggerContext = NULL;
+   }
+
+   return status;
+}
+
+/**
+ * @internal
+ *
+ * Checks if buffer needs to be flushed to file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context
+ * @param [in] lengthOfTextToAdd Length of text to compare with the available space in file or current buffer
+ * @return true if buffer needs to be flushed.
+ */
+static bool TextLogger_FlushBufferIsNeeded(LoggerContextType* pLoggerContext, int lengthOfTextToAdd)
+{
+   // check if maxFileSize is about to be reached (unless files are rotated or circular) or if maxBufferByteSize is about to be reached
+   if ((pLoggerContext->fileSizeIsLimited && (pLoggerContext->maxFileSize - pLoggerContext->totalBytesStored) <= lengthOfTextToAdd) ||
+      (pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos) <= lengthOfTextToAdd) {
+      return true;
+   }
+   return false;
+}
+
+/**
+ * @internal
+ *
+ * Writes a zero-padded decimal number.
+ *
+ * @param [out] pDest Pointer to first digit.
+ * @param [in] value Number to write.
+ * @param [in] digits Number of digits to write.
+ */
+static void TextLogger_FormatDigits(char* pDest, int value, int digits)
+{
+   for (int digit = digits - 1; digit >= 0; digit--) {
+      pDest[digit] = (char) ('0' + (value % 10));
+      value /= 10;
+   }
+}
+
+/**
+ * @internal
+ *
+ * Updates the cached "[YYYY-MM-DD | HH:MM:SS] " prefix to the given time.
+ * Only the seconds digits are rewritten while the minute stays the same,
+ * the full date and time is formatted again otherwise.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] timeStamp Time to format.
+ */
+static void TextLogger_UpdateTimeStampCache(LoggerContextType* pLoggerContext, time_t timeStamp)
+{
+   if (timeStamp == pLoggerContext->cachedTimeStamp) {
+      return;
+   }
+
+   // timezone offsets are whole minutes, so the minute only rolls over when the second counter wraps
+   time_t secondsIntoMinute = timeStamp - pLoggerContext->cachedMinuteStart;
+   if (0 <= secondsIntoMinute && 60 > secondsIntoMinute) {
+      TextLogger_FormatDigits(pLoggerContext->pCachedTimeStamp + 20, (int) secondsIntoMinute, 2);
+      pLoggerContext->cachedTimeStamp = timeStamp;
+      return;
+   }
+
+   // get date and time as a string (localtime is not reentrant)
+   struct tm timeinfo;
+#ifdef _WIN32
+   localtime_s(&timeinfo, &timeStamp);
+#else
+   localtime_r(&timeStamp, &timeinfo);
+#endif
+   char* pTimeBuffer = pLoggerContext->pCachedTimeStamp;
+   memcpy(pTimeBuffer, "[0000-00-00 | 00:00:00] ", TIMESTAMP_STR_LENGTH + 1);
+   TextLogger_FormatDigits(pTimeBuffer + 1, (timeinfo.tm_year) + 1900, 4); // tm_year is years since 1900
+   TextLogger_FormatDigits(pTimeBuffer + 6, (timeinfo.tm_mon) + 1, 2); // tm_mon values are from 0-11
+   TextLogger_FormatDigits(pTimeBuffer + 9, timeinfo.tm_mday, 2);
+   TextLogger_FormatDigits(pTimeBuffer + 14, timeinfo.tm_hour, 2);
+   TextLogger_FormatDigits(pTimeBuffer + 17, timeinfo.tm_min, 2);
+   TextLogger_FormatDigits(pTimeBuffer + 20, timeinfo.tm_sec, 2);
+
+   pLoggerContext->cachedTimeStamp = timeStamp;
+   pLoggerContext->cachedMinuteStart = (timeinfo.tm_sec < 60) ? (timeStamp - timeinfo.tm_sec) : timeStamp; // leap second: reformat next time
+}
+
+/**
+ * @internal
+ *
+ * Writes given date and time to buffer.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] timeStamp Time to write.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_WriteTimeStampToBuffer(LoggerContextType* pLoggerContext, time_t timeStamp)
+{
+   TextLogger_UpdateTimeStampCache(pLoggerContext, timeStamp);
+
+   // check if pTextBuffer must be flushed
+   if (TextLogger_FlushBufferIsNeeded(pLoggerContext, TIMESTAMP_STR_LENGTH)) {
+      TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   // write to buffer, truncated like snprintf would if the buffer is tiny
+   int bytesWritten = TIMESTAMP_STR_LENGTH;
+   if (bytesWritten > pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos - 1) {
+      bytesWritten = pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos - 1;
+   }
+   memcpy(pLoggerContext->pTextBuffer + pLoggerContext->currBytePos, pLoggerContext->pCachedTimeStamp, bytesWritten);
+   // move currBytePos forward
+   pLoggerContext->currBytePos += bytesWritten;
+   pLoggerContext->totalBytesStored += bytesWritten;
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_LogTimeStamp(LoggerContextType* pLoggerContext)
+{
+   if (NULL == pLoggerContext) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // buffer is shared between threads in other modes
+   if (TEXTLOGGER_MODE_SYNC != pLoggerContext->mode) {
+      return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+   }
+
+   // timestamps are part of every record in binary format
+   if (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) {
+      return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+   }
+
+   TextLoggerStatusType status = TextLogger_WriteTimeStampToBuffer(pLoggerContext, time(NULL));
+   if (NULL != pLoggerContext->pPersist) {
+      TextLogger_PersistSetWriteHead(pLoggerContext);
+   }
+   return status;
+}
+
+/**
+ * @internal
+ *
+ * Writes bytes at the end of the log file, or over the oldest bytes of a circular file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_WriteBytesToFile(LoggerContextType* pLoggerContext, const char* pData, int length)
+{
+   if (NULL == pLoggerContext->pLogFile) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // copied straight into the mapped file
+   if (NULL != pLoggerContext->pMmap) {
+      return TextLogger_MmapWrite(pLoggerContext, pData, length);
+   }
+
+   // overwrite the oldest bytes, file size does not change
+   if (pLoggerContext->circularFile) {
+      TextLogger_DurableAddWritten(pLoggerContext, length);
+      return TextLogger_CircularWrite(pLoggerContext, pData, length);
+   }
+
+   // compressed in blocks of at most one buffer
+   if (NULL != pLoggerContext->pCompress) {
+      return TextLogger_CompressWrite(pLoggerContext, pData, length);
+   }
+
+   size_t bytesWritten = fwrite(pData, sizeof(char), length, pLoggerContext->pLogFile);
+   pLoggerContext->currFileSize += bytesWritten;
+   TextLogger_DurableAddWritten(pLoggerContext, bytesWritten);
+   if (bytesWritten != (size_t) length) {
+      // Failed to write all data to the file
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Writes a record whose header and message together do not fit in pTextBuffer.
+ * Buffered records are flushed first, then the record goes straight to the file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pHeader Bytes written before the message.
+ * @param [in] headerLength Length of pHeader.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message.
+ * @param [in] pTrailer Bytes written after the message.
+ * @param [in] trailerLength Length of pTrailer.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_WriteLargeRecord(LoggerContextType* pLoggerContext, const char* pHeader, int headerLength,
+                                                        const char* pLogText, int textLength, const char* pTrailer, int trailerLength,
+                                                        LogLevelType logLevel, time_t timeStamp)
+{
+   TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pFlusher) {
+      status = TextLogger_FlusherWait(pLoggerContext); // keep file order
+   }
+   if (TEXTLOGGER_SUCCESS != status) {
+      return status;
+   }
+
+   // a record that overshoots maxFileSize is dropped whole, like an overshooting buffer
+   long int recordLength = (long int) headerLength + textLength + trailerLength;
+   long int indexLength = (NULL != pLoggerContext->pCompress) ? TextLogger_CompressIndexSize(pLoggerContext) : 0;
+   if (pLoggerContext->fileSizeIsLimited && pLoggerContext->currFileSize + indexLength + recordLength > pLoggerContext->maxFileSize) {
+      if (NULL != pLoggerContext->pCompress) {
+         pLoggerContext->totalBytesStored = pLoggerContext->maxFileSize; // compressed size is not known upfront, the file ends here with the error message
+      } else {
+         pLoggerContext->fileLimitIsReached = true;
+      }
+      return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE;
+   }
+   pLoggerContext->totalBytesStored += recordLength;
+   if (NULL != pLoggerContext->pCompress) {
+      TextLogger_CompressAddRecord(pLoggerContext, logLevel, timeStamp); // indexed with the block holding the header
+   }
+
+   status = TextLogger_WriteBytesToFile(pLoggerContext, pHeader, headerLength);
+   if (TEXTLOGGER_SUCCESS == status) {
+      status = TextLogger_WriteBytesToFile(pLoggerContext, pLogText, textLength);
+   }
+   if (TEXTLOGGER_SUCCESS == status) {
+      status = TextLogger_WriteBytesToFile(pLoggerContext, pTrailer, trailerLength);
+   }
+   return status;
+}
+
+/**
+ * @internal
+ *
+ * Encodes the tag, timestamp and length of a TEXTLOGGER_FORMAT_BINARY record.
+ * The first record of a buffer carries an absolute timestamp, the others a delta.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [out] pDest Destination, TEXTLOGGER_BINARY_MAX_HEADER_LENGTH bytes.
+ * @param [in] textLength Length of log message.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return length of the header.
+ */
+static size_t TextLogger_EncodeBinaryHeader(LoggerContextType* pLoggerContext, unsigned char* pDest, int textLength, LogLevelType logLevel, time_t timeStamp)
+{
+   size_t headerLength = 1;
+   if (0 == pLoggerContext->currBytePos) {
+      pDest[0] = (unsigned char) (logLevel | TEXTLOGGER_BINARY_ABSOLUTE_TIME);
+      headerLength += TextLogger_BinaryPutVarint(pDest + headerLength, (uint64_t) timeStamp);
+   } else {
+      pDest[0] = (unsigned char) logLevel;
+      int64_t delta = (int64_t) timeStamp - (int64_t) pLoggerContext->lastBinaryTimeStamp;
+      headerLength += TextLogger_BinaryPutVarint(pDest + headerLength, TextLogger_BinaryZigzagEncode(delta));
+   }
+   pLoggerContext->lastBinaryTimeStamp = timeStamp;
+   headerLength += TextLogger_BinaryPutVarint(pDest + headerLength, (uint64_t) textLength);
+   return headerLength;
+}
+
+/**
+ * @internal
+ *
+ * Writes the header and trailer of a record to pTextBuffer and gathers the
+ * message in between instead of copying it, see text_logger_gather.c.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message, valid until the gathered messages are written.
+ * @param [in] textLength Length of log message.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_GatherRecord(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel, time_t timeStamp)
+{
+   bool isBinary = (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format);
+   int headerMaxLength = isBinary ? TEXTLOGGER_BINARY_MAX_HEADER_LENGTH : TIMESTAMP_STR_LENGTH + LOG_TAG_STR_LENGTH;
+   int trailerLength = isBinary ? 0 : 1;
+
+   // writes the buffer with the messages gathered so far
+   if (!TextLogger_GatherHasRoom(pLoggerContext) || TextLogger_FlushBufferIsNeeded(pLoggerContext, headerMaxLength + trailerLength)) {
+      TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   // header after the buffered records, its length is only known once encoded
+   char* pDest = pLoggerContext->pTextBuffer + pLoggerContext->currBytePos;
+   int headerLength = TIMESTAMP_STR_LENGTH + LOG_TAG_STR_LENGTH;
+   time_t lastBinaryTimeStamp = pLoggerContext->lastBinaryTimeStamp;
+   if (isBinary) {
+      headerLength = (int) TextLogger_EncodeBinaryHeader(pLoggerContext, (unsigned char*) pDest, textLength, logLevel, timeStamp);
+   } else {
+      memcpy(pDest, pLoggerContext->pCachedTimeStamp, TIMESTAMP_STR_LENGTH);
+      memcpy(pDest + TIMESTAMP_STR_LENGTH, spLogLevelTags[logLevel], LOG_TAG_STR_LENGTH);
+   }
+
+   // a record that overshoots maxFileSize is dropped whole, like in TextLogger_WriteLargeRecord
+   long int recordLength = (long int) headerLength + textLength + trailerLength;
+   long int pendingLength = pLoggerContext->currBytePos + TextLogger_GatherPendingSize(pLoggerContext);
+   if (pLoggerContext->fileSizeIsLimited && pLoggerContext->currFileSize + pendingLength + recordLength > pLoggerContext->maxFileSize) {
+      pLoggerContext->lastBinaryTimeStamp = lastBinaryTimeStamp; // the next record's delta is based on the last one written
+      pLoggerContext->fileLimitIsReached = true;
+      return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE;
+   }
+
+   pLoggerContext->currBytePos += headerLength;
+   TextLogger_GatherMessage(pLoggerContext, pLogText, textLength);
+   if (!isBinary) {
+      pLoggerContext->pTextBuffer[pLoggerContext->currBytePos++] = '\n';
+   }
+   pLoggerContext->totalBytesStored += recordLength;
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Encodes log message as a TEXTLOGGER_FORMAT_BINARY record into buffer,
+ * or straight into the file if it does not fit in an empty buffer.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_WriteBinaryToBuffer(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel, time_t timeStamp)
+{
+   // message is written from the caller's memory
+   if (NULL != pLoggerContext->pGather && (textLength >= pLoggerContext->maxBufferByteSize - TEXTLOGGER_BINARY_MAX_HEADER_LENGTH ||
+       (0 < pLoggerContext->gatherMinTextSize && textLength >= pLoggerContext->gatherMinTextSize))) {
+      return TextLogger_GatherRecord(pLoggerContext, pLogText, textLength, logLevel, timeStamp);
+   }
+
+   // message does not fit in an empty buffer together with its header
+   if (textLength >= pLoggerContext->maxBufferByteSize - TEXTLOGGER_BINARY_MAX_HEADER_LENGTH) {
+      TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+      unsigned char pHeader[TEXTLOGGER_BINARY_MAX_HEADER_LENGTH];
+      size_t headerLength = TextLogger_EncodeBinaryHeader(pLoggerContext, pHeader, textLength, logLevel, timeStamp);
+      return TextLogger_WriteLargeRecord(pLoggerContext, (const char*) pHeader, (int) headerLength, pLogText, textLength, NULL, 0, logLevel, timeStamp);
+   }
+
+   // check if pTextBuffer must be flushed
+   if (TextLogger_FlushBufferIsNeeded(pLoggerContext, TEXTLOGGER_BINARY_MAX_HEADER_LENGTH + textLength)) {
+      TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   // tag, timestamp and length
+   unsigned char* pRecord = (unsigned char*) (pLoggerContext->pTextBuffer + pLoggerContext->currBytePos);
+   size_t recordLength = TextLogger_EncodeBinaryHeader(pLoggerContext, pRecord, textLength, logLevel, timeStamp);
+
+   // payload
+   memcpy(pRecord + recordLength, pLogText, textLength);
+   recordLength += textLength;
+
+   // increment currBytePos and totalBytesStored
+   pLoggerContext->currBytePos += recordLength;
+   pLoggerContext->totalBytesStored += recordLength;
+   if (NULL != pLoggerContext->pCompress) {
+      TextLogger_CompressAddRecord(pLoggerContext, logLevel, timeStamp);
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Formats one log record into pTextBuffer, whatever its level.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] logLength Length of log message including LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return same as TextLogger_WriteToBuffer.
+ */
+static TextLoggerStatusType TextLogger_FormatFileRecord(LoggerContextType* pLoggerContext, const char* pLogText, int logLength, LogLevelType logLevel, time_t timeStamp)
+{
+
+   if (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) {
+      TextLoggerStatusType status = TextLogger_RotateBeforeRecord(pLoggerContext, TEXTLOGGER_BINARY_MAX_HEADER_LENGTH + logLength - LOG_EXTRA_STR_LENGTH);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+      return TextLogger_WriteBinaryToBuffer(pLoggerContext, pLogText, logLength - LOG_EXTRA_STR_LENGTH, logLevel, timeStamp);
+   }
+
+   const char* pLogMsgTag = spLogLevelTags[logLevel];
+   int textLength = logLength - LOG_EXTRA_STR_LENGTH;
+   int recordLength = TIMESTAMP_STR_LENGTH + logLength;
+
+   // flush before the whole record, so timestamp and message never end up in different files
+   TextLoggerStatusType status = TextLogger_RotateBeforeRecord(pLoggerContext, recordLength);
+   if (TEXTLOGGER_SUCCESS != status) {
+      return status;
+   }
+
+   TextLogger_UpdateTimeStampCache(pLoggerContext, timeStamp);
+
+   // message is written from the caller's memory
+   if (NULL != pLoggerContext->pGather && (recordLength >= pLoggerContext->maxBufferByteSize ||
+       (0 < pLoggerContext->gatherMinTextSize && textLength >= pLoggerContext->gatherMinTextSize))) {
+      return TextLogger_GatherRecord(pLoggerContext, pLogText, textLength, logLevel, timeStamp);
+   }
+
+   // record does not fit in an empty buffer: write it to the file instead of truncating it
+   if (recordLength >= pLoggerContext->maxBufferByteSize) {
+      char pHeader[TIMESTAMP_STR_LENGTH + LOG_TAG_STR_LENGTH];
+      memcpy(pHeader, pLoggerContext->pCachedTimeStamp, TIMESTAMP_STR_LENGTH);
+      memcpy(pHeader + TIMESTAMP_STR_LENGTH, pLogMsgTag, LOG_TAG_STR_LENGTH);
+      return TextLogger_WriteLargeRecord(pLoggerContext, pHeader, sizeof(pHeader), pLogText, textLength, "\n", 1, logLevel, timeStamp);
+   }
+   if (TextLogger_FlushBufferIsNeeded(pLoggerContext, recordLength)) {
+      status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   // timestamp, tag and message in one pass, queued messages are not null-terminated
+   char* pDest = pLoggerContext->pTextBuffer + pLoggerContext->currBytePos;
+   memcpy(pDest, pLoggerContext->pCachedTimeStamp, TIMESTAMP_STR_LENGTH);
+   pDest += TIMESTAMP_STR_LENGTH;
+   memcpy(pDest, pLogMsgTag, LOG_TAG_STR_LENGTH);
+   pDest += LOG_TAG_STR_LENGTH;
+   memcpy(pDest, pLogText, textLength);
+   pDest[textLength] = '\n';
+
+   // increment currBytePos and totalBytesStored
+   pLoggerContext->currBytePos += recordLength;
+   pLoggerContext->totalBytesStored += recordLength;
+   if (NULL != pLoggerContext->pCompress) {
+      TextLogger_CompressAddRecord(pLoggerContext, logLevel, timeStamp);
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_WriteFlightRecorder(LoggerContextType* pLoggerContext)
+{
+   const char* pLogText;
+   int textLength;
+   LogLevelType logLevel;
+   time_t timeStamp;
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+
+   // records are taken out as they are written, so what does not fit in the file is dropped too
+   while (TextLogger_RecorderNext(pLoggerContext, &pLogText, &textLength, &logLevel, &timeStamp)) {
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = TextLogger_FormatFileRecord(pLoggerContext, pLogText, textLength + LOG_EXTRA_STR_LENGTH, logLevel, timeStamp);
+      }
+   }
+
+   return status;
+}
+
+/**
+ * @internal
+ *
+ * Formats one log record into pTextBuffer, see TextLogger_WriteToBuffer, or
+ * keeps it in the flight recorder if it is less important than fileLogLevel.
+ * An error record writes the flight recorder first.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] logLength Length of log message including LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return same as TextLogger_WriteToBuffer.
+ */
+static TextLoggerStatusType TextLogger_FormatRecord(LoggerContextType* pLoggerContext, const char* pLogText, int logLength, LogLevelType logLevel, time_t timeStamp)
+{
+   if (NULL != pLoggerContext->pRecorder) {
+      if ((int) logLevel > pLoggerContext->fileLogLevel) {
+         TextLogger_RecorderAdd(pLoggerContext, pLogText, logLength - LOG_EXTRA_STR_LENGTH, logLevel, timeStamp);
+         return TEXTLOGGER_SUCCESS;
+      }
+      if (LOG_LEVEL_ERROR == logLevel) {
+         TextLoggerStatusType status = TextLogger_WriteFlightRecorder(pLoggerContext);
+         if (TEXTLOGGER_SUCCESS != status) {
+            return status;
+         }
+      }
+   }
+
+   TextLoggerStatusType status = TextLogger_FormatFileRecord(pLoggerContext, pLogText, logLength, logLevel, timeStamp);
+   if (NULL != pLoggerContext->pPersist) {
+      TextLogger_PersistSetWriteHead(pLoggerContext);
+   }
+   return status;
+}
+
+/**
+ * @internal
+ *
+ * Completes the records formatted by one logging call: writes the gathered
+ * messages, which belong to the caller, and makes error records durable.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] status Status of formatting the records.
+ * @param [in] errorIsLogged true if one of the records is an error record.
+ * @return status if it is not TEXTLOGGER_SUCCESS.
+ * @return same as TextLogger_WriteToBuffer otherwise.
+ */
+static TextLoggerStatusType TextLogger_FinishRecords(LoggerContextType* pLoggerContext, TextLoggerStatusType status, bool errorIsLogged)
+{
+   // gathered messages cannot outlive the call: written now, or dropped with the buffer if that fails
+   if (NULL != pLoggerContext->pGather && TextLogger_GatherIsPending(pLoggerContext)) {
+      TextLoggerStatusType flushStatus = TextLogger_FlushBuffer(pLoggerContext);
+      if (TextLogger_GatherIsPending(pLoggerContext)) {
+         TextLogger_GatherClear(pLoggerContext);
+         pLoggerContext->currBytePos = 0;
+      }
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = flushStatus;
+      }
+   }
+
+   // error records do not wait in the buffer: written and synced before returning
+   if (TEXTLOGGER_SUCCESS == status && errorIsLogged && TEXTLOGGER_DURABILITY_SYNC_ON_ERROR == pLoggerContext->durability) {
+      status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pFlusher) {
+         status = TextLogger_FlusherWait(pLoggerContext);
+      }
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = TextLogger_DurableSync(pLoggerContext);
+      }
+   }
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_WriteToBuffer(LoggerContextType* pLoggerContext, const char* pLogText, int logLength, LogLevelType logLevel, time_t timeStamp)
+{
+   if (NULL == pLoggerContext || NULL == pLogText) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   TextLoggerStatusType status = TextLogger_FormatRecord(pLoggerContext, pLogText, logLength, logLevel, timeStamp);
+   return TextLogger_FinishRecords(pLoggerContext, status, LOG_LEVEL_ERROR == logLevel);
+}
+
+/**
+ * @internal
+ *
+ * Hands a log message to the buffer, the writer thread, the calling thread's buffer or the daemon's ring depending on mode.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message.
+ * @param [in] logLevel Level of log message.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if the message is too long to be indexed with an int.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_SubmitLog(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength, LogLevelType logLevel)
+{
+   if ((size_t) (INT_MAX - TIMESTAMP_STR_LENGTH - LOG_EXTRA_STR_LENGTH) < textLength) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   if (NULL == pLogText) {
+      pLogText = ""; // empty (ptr, len) message such as a default std::string_view
    }
 
-   // dynamically allocate & init error msg
-   pLoggerContext->pErrMsg = (char*) malloc(sizeof(char) * (strlen(pErrMsg) + 1));
-   if (NULL == pLoggerContext->pErrMsg) {
-      free(pLoggerContext->pFilePath);
-      free(pLoggerContext->pTextBuffer);
-      free(pLoggerContext);
-      pLoggerContext = NULL;
-      return NULL;
+   if (TEXTLOGGER_MODE_ASYNC == pLoggerContext->mode) {
+      return TextLogger_AsyncPush(pLoggerContext, pLogText, textLength, logLevel);
+   } else if (TEXTLOGGER_MODE_PER_THREAD == pLoggerContext->mode) {
+      TextLoggerStatusType status = TextLogger_PerThreadPush(pLoggerContext, pLogText, textLength, logLevel);
+      // an error record only reaches the file when thread buffers are merged
+      if (TEXTLOGGER_SUCCESS == status && LOG_LEVEL_ERROR == logLevel && TEXTLOGGER_DURABILITY_SYNC_ON_ERROR == pLoggerContext->durability) {
+         status = TextLogger_PerThreadFlush(pLoggerContext);
+      }
+      return status;
+   } else if (TEXTLOGGER_MODE_DAEMON == pLoggerContext->mode) {
+      return TextLogger_DaemonPush(pLoggerContext, pLogText, textLength, logLevel);
    }
-   strcpy(pLoggerContext->pErrMsg, pErrMsg);
 
-   return pLoggerContext;
+   int logLength = textLength + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[E]: \n"
+   return TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, logLevel, time(NULL));
 }
 
-TextLoggerStatusType TextLogger_Destroy(LoggerContextType* pLoggerContext)
+TextLoggerStatusType TextLogger_Log(LoggerContextType* pLoggerContext, LogLevelType logLevel, const char* pLogText, size_t textLength)
 {
-   if (NULL == pLoggerContext) {
+   if (NULL == pLoggerContext || (NULL == pLogText && 0 != textLength) || LOG_LEVEL_ERROR > logLevel || LOG_LEVEL_VERBOSE < logLevel) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // Flush any remaining text to file
-   TextLoggerStatusType status = TextLogger_FlushTextToFileStream(pLoggerContext);
-
-   // free allocated memory for pLoggerContext->pErrMsg
-   if (NULL != pLoggerContext->pErrMsg) {
-      free(pLoggerContext->pErrMsg);
-      pLoggerContext->pErrMsg = NULL;
+   // write to buffer
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   if ((int) logLevel <= pLoggerContext->filter.logLevel) {
+      status = TextLogger_SubmitLog(pLoggerContext, pLogText, textLength, logLevel);
    }
 
-   // free allocated memory for pLoggerContext->pFilePath
-   if (NULL != pLoggerContext->pFilePath) {
-      free(pLoggerContext->pFilePath);
-      pLoggerContext->pFilePath = NULL;
+   return status;
+}
+
+TextLoggerStatusType TextLogger_LogBatch(LoggerContextType* pLoggerContext, const TextLoggerMessageType* pMessages, size_t messageCount)
+{
+   if (NULL == pLoggerContext || (NULL == pMessages && 0 != messageCount)) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // free allocated memory for pLoggerContext->pTextBuffer
-   if (NULL != pLoggerContext->pTextBuffer) {
-      free(pLoggerContext->pTextBuffer);
-      pLoggerContext->pTextBuffer = NULL;
+   // records only reach a shared buffer one by one in the other modes
+   if (TEXTLOGGER_MODE_SYNC != pLoggerContext->mode) {
+      TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+      for (size_t index = 0; index < messageCount && TEXTLOGGER_SUCCESS == status; index++) {
+         status = TextLogger_Log(pLoggerContext, pMessages[index].logLevel, pMessages[index].pText, pMessages[index].textLength);
+      }
+      return status;
    }
 
-   // free allocated memory for pLoggerContext
-   if (NULL != pLoggerContext) {
-      free(pLoggerContext);
-      pLoggerContext = NULL;
+   // gathered messages of the whole batch are written together
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   bool errorIsLogged = false;
+   time_t timeStamp = time(NULL);
+   for (size_t index = 0; index < messageCount; index++) {
+      const TextLoggerMessageType* pMessage = &pMessages[index];
+      if ((NULL == pMessage->pText && 0 != pMessage->textLength) || LOG_LEVEL_ERROR > pMessage->logLevel || LOG_LEVEL_VERBOSE < pMessage->logLevel ||
+          (size_t) (INT_MAX - TIMESTAMP_STR_LENGTH - LOG_EXTRA_STR_LENGTH) < pMessage->textLength) {
+         status = TEXTLOGGER_ERR_INVALID_INPUT;
+         break;
+      }
+      if ((int) pMessage->logLevel > pLoggerContext->filter.logLevel) {
+         continue;
+      }
+
+      const char* pLogText = (NULL != pMessage->pText) ? pMessage->pText : "";
+      int logLength = (int) pMessage->textLength + LOG_EXTRA_STR_LENGTH;
+      status = TextLogger_FormatRecord(pLoggerContext, pLogText, logLength, pMessage->logLevel, timeStamp);
+      if (TEXTLOGGER_SUCCESS != status) {
+         break;
+      }
+      errorIsLogged = errorIsLogged || (LOG_LEVEL_ERROR == pMessage->logLevel);
    }
 
-   return status;
+   return TextLogger_FinishRecords(pLoggerContext, status, errorIsLogged);
 }
 
 /**
  * @internal
  *
- * Checks if buffer needs to be flushed to file.
+ * Logs a null-terminated message, measuring it only if the level is enabled.
  *
- * @param [in,out] pLoggerContext Pointer to logger context
- * @param [in] lengthOfTextToAdd Length of text to compare with the available space in file or current buffer
- * @return true if buffer needs to be flushed.
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] logLevel Level of log message.
+ * @param [in] pLogText String containing log message.
+ * @return same as TextLogger_Log.
  */
-static bool TextLogger_FlushBufferIsNeeded(LoggerContextType* pLoggerContext, int lengthOfTextToAdd)
+static TextLoggerStatusType TextLogger_LogString(LoggerContextType* pLoggerContext, LogLevelType logLevel, const char* pLogText)
 {
-   // check if maxFileSize is about to be reached or if maxBufferByteSize is about to be reached
-   if ((pLoggerContext->maxFileSize - pLoggerContext->totalBytesStored) <= lengthOfTextToAdd ||
-      (pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos) <= lengthOfTextToAdd) {
-      return true;
+   if (NULL == pLoggerContext || NULL == pLogText) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
    }
-   return false;
+
+   // write to buffer
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   if ((int) logLevel <= pLoggerContext->filter.logLevel) {
+      status = TextLogger_SubmitLog(pLoggerContext, pLogText, strlen(pLogText), logLevel);
+   }
+
+   return status;
 }
 
-TextLoggerStatusType TextLogger_LogTimeStamp(LoggerContextType* pLoggerContext)
+TextLoggerStatusType TextLogger_LogError(LoggerContextType* pLoggerContext, const char* pLogText)
 {
-   if (NULL == pLoggerContext) {
-      return TEXTLOGGER_ERR_INVALID_INPUT;
-   }
+   return TextLogger_LogString(pLoggerContext, LOG_LEVEL_ERROR, pLogText);
+}
 
-   // get current date and time as a string
-   time_t rawtime;
-   struct tm *timeinfo;
-   char pTimeBuffer[MAX_STR_SIZE];
-   time(&rawtime);
-   timeinfo = localtime(&rawtime);
-   snprintf(pTimeBuffer, sizeof(pTimeBuffer), "[%04d-%02d-%02d | %02d:%02d:%02d] ",
-            (timeinfo->tm_year) + 1900, (timeinfo->tm_mon) + 1, timeinfo->tm_mday,   // tm_year is years since 1900, tm_mon values are from 0-11
-            timeinfo->tm_hour, timeinfo->tm_min, timeinfo->tm_sec);
+TextLoggerStatusType TextLogger_LogWarn(LoggerContextType* pLoggerContext, const char* pLogText)
+{
+   return TextLogger_LogString(pLoggerContext, LOG_LEVEL_WARN, pLogText);
+}
 
-   // check if pTextBuffer must be flushed
-   if (TextLogger_FlushBufferIsNeeded(pLoggerContext, strlen(pTimeBuffer))) {
-      TextLoggerStatusType status = TextLogger_FlushTextToFileStream(pLoggerContext);
-      if (TEXTLOGGER_SUCCESS != status) {
-         return status;
-      }
-   }
+TextLoggerStatusType TextLogger_LogInfo(LoggerContextType* pLoggerContext, const char* pLogText)
+{
+   return TextLogger_LogString(pLoggerContext, LOG_LEVEL_INFO, pLogText);
+}
 
-   // write to buffer
-   size_t bytesWritten = snprintf(  (pLoggerContext->pTextBuffer + pLoggerContext->currBytePos),
-                                    (pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos),
-                                    "%s", pTimeBuffer
-                                 );
-   // move currBytePos forward
-   pLoggerContext->currBytePos += bytesWritten;
-   pLoggerContext->totalBytesStored += bytesWritten;
+TextLoggerStatusType TextLogger_LogDebug(LoggerContextType* pLoggerContext, const char* pLogText)
+{
+   return TextLogger_LogString(pLoggerContext, LOG_LEVEL_DEBUG, pLogText);
+}
 
-   return TEXTLOGGER_SUCCESS;
+TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, const char* pLogText)
+{
+   return TextLogger_LogString(pLoggerContext, LOG_LEVEL_VERBOSE, pLogText);
+}
+
+TextLoggerStatusType TextLogger_LogErrorN(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength)
+{
+   return TextLogger_Log(pLoggerContext, LOG_LEVEL_ERROR, pLogText, textLength);
+}
+
+TextLoggerStatusType TextLogger_LogWarnN(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength)
+{
+   return TextLogger_Log(pLoggerContext, LOG_LEVEL_WARN, pLogText, textLength);
+}
+
+TextLoggerStatusType TextLogger_LogInfoN(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength)
+{
+   return TextLogger_Log(pLoggerContext, LOG_LEVEL_INFO, pLogText, textLength);
+}
+
+TextLoggerStatusType TextLogger_LogDebugN(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength)
+{
+   return TextLogger_Log(pLoggerContext, LOG_LEVEL_DEBUG, pLogText, textLength);
+}
+
+TextLoggerStatusType TextLogger_LogVerboseN(LoggerContextType* pLoggerContext, const char* pLogText, size_t textLength)
+{
+   return TextLogger_Log(pLoggerContext, LOG_LEVEL_VERBOSE, pLogText, textLength);
 }
 
 /**
  * @internal
  *
- * Writes log message to buffer.
+ * Formats a printf-style log message and hands it on like TextLogger_SubmitLog.
+ * In async mode, formatting is left to the writer thread.
  *
  * @param [in,out] pLoggerContext Pointer to logger context.
- * @param [in] pLogText String containing log message.
- * @param [in] logLength Length of log message.
+ * @param [in] pFormat printf-style format string.
+ * @param [in] args Arguments for pFormat.
  * @param [in] logLevel Level of log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
- * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pFormat cannot be formatted.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
-static TextLoggerStatusType TextLogger_WriteToBuffer(LoggerContextType* pLoggerContext, const char* pLogText, int logLength, LogLevelType logLevel)
+static TextLoggerStatusType TextLogger_SubmitLogf(LoggerContextType* pLoggerContext, const char* pFormat, va_list args, LogLevelType logLevel)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
-      return TEXTLOGGER_ERR_INVALID_INPUT;
-   }
-
-   // initialize log message tag
-   char pLogMsgTag[MAX_STR_SIZE];
-   if (LOG_LEVEL_ERROR == logLevel) {
-      strcpy(pLogMsgTag, "[E]: ");
-   } else if (LOG_LEVEL_WARN == logLevel) {
-      strcpy(pLogMsgTag, "[W]: ");
-   } else if (LOG_LEVEL_INFO == logLevel) {
-      strcpy(pLogMsgTag, "[I]: ");
-   } else if (LOG_LEVEL_DEBUG == logLevel) {
-      strcpy(pLogMsgTag, "[D]: ");
-   } else if (LOG_LEVEL_VERBOSE == logLevel) {
-      strcpy(pLogMsgTag, "[V]: ");
+   if (TEXTLOGGER_MODE_ASYNC == pLoggerContext->mode) {
+      return TextLogger_AsyncPushFormat(pLoggerContext, pFormat, args, logLevel);
    }
 
-   //write timestamp to buffer
-   TextLoggerStatusType status = TextLogger_LogTimeStamp(pLoggerContext);
-   if (TEXTLOGGER_SUCCESS != status) {
-      return status;
+   char pLogText[MAX_LOGF_STR_SIZE];
+   int textLength = vsnprintf(pLogText, sizeof(pLogText), pFormat, args);
+   if (0 > textLength) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
    }
-
-   // check if pTextBuffer must be flushed
-   if (TextLogger_FlushBufferIsNeeded(pLoggerContext, logLength)) {
-      status = TextLogger_FlushTextToFileStream(pLoggerContext);
-      if (TEXTLOGGER_SUCCESS != status) {
-         return status;
-      }
+   if (textLength >= (int) sizeof(pLogText)) {
+      textLength = sizeof(pLogText) - 1; // truncated by vsnprintf
    }
 
-   // write to buffer
-   size_t bytesWritten = snprintf(  (pLoggerContext->pTextBuffer + pLoggerContext->currBytePos),  // pointer to current position in buffer
-                                    (pLoggerContext->maxBufferByteSize - pLoggerContext->currBytePos),  // maximum space available to write
-                                    "%s%s\n", pLogMsgTag, pLogText
-                                 );
-   // increment currBytePos and totalBytesStored
-   pLoggerContext->currBytePos += bytesWritten;
-   pLoggerContext->totalBytesStored += bytesWritten;
-
-   return TEXTLOGGER_SUCCESS;
+   return TextLogger_SubmitLog(pLoggerContext, pLogText, textLength, logLevel);
 }
 
-TextLoggerStatusType TextLogger_LogError(LoggerContextType* pLoggerContext, const char* pLogText)
+TextLoggerStatusType TextLogger_LogfError(LoggerContextType* pLoggerContext, const char* pFormat, ...)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
+   if (NULL == pLoggerContext || NULL == pFormat) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // write to buffer
+   // format and write to buffer
    TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
-   if (LOG_LEVEL_ERROR <= pLoggerContext->logLevel) {
-      size_t logLength = strlen(pLogText) + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[E]: \n"
-      status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, LOG_LEVEL_ERROR);
+   if (LOG_LEVEL_ERROR <= pLoggerContext->filter.logLevel) {
+      va_list args;
+      va_start(args, pFormat);
+      status = TextLogger_SubmitLogf(pLoggerContext, pFormat, args, LOG_LEVEL_ERROR);
+      va_end(args);
    }
 
    return status;
 }
 
-TextLoggerStatusType TextLogger_LogWarn(LoggerContextType* pLoggerContext, const char* pLogText)
+TextLoggerStatusType TextLogger_LogfWarn(LoggerContextType* pLoggerContext, const char* pFormat, ...)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
+   if (NULL == pLoggerContext || NULL == pFormat) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // write to buffer
+   // format and write to buffer
    TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
-   if (LOG_LEVEL_WARN <= pLoggerContext->logLevel) {
-      size_t logLength = strlen(pLogText) + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[W]: \n"
-      status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, LOG_LEVEL_WARN);
+   if (LOG_LEVEL_WARN <= pLoggerContext->filter.logLevel) {
+      va_list args;
+      va_start(args, pFormat);
+      status = TextLogger_SubmitLogf(pLoggerContext, pFormat, args, LOG_LEVEL_WARN);
+      va_end(args);
    }
 
    return status;
 }
 
-TextLoggerStatusType TextLogger_LogInfo(LoggerContextType* pLoggerContext, const char* pLogText)
+TextLoggerStatusType TextLogger_LogfInfo(LoggerContextType* pLoggerContext, const char* pFormat, ...)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
+   if (NULL == pLoggerContext || NULL == pFormat) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // write to buffer
+   // format and write to buffer
    TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
-   if (LOG_LEVEL_INFO <= pLoggerContext->logLevel) {
-      size_t logLength = strlen(pLogText) + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[I]: \n"
-      status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, LOG_LEVEL_INFO);
+   if (LOG_LEVEL_INFO <= pLoggerContext->filter.logLevel) {
+      va_list args;
+      va_start(args, pFormat);
+      status = TextLogger_SubmitLogf(pLoggerContext, pFormat, args, LOG_LEVEL_INFO);
+      va_end(args);
    }
 
    return status;
 }
 
-TextLoggerStatusType TextLogger_LogDebug(LoggerContextType* pLoggerContext, const char* pLogText)
+TextLoggerStatusType TextLogger_LogfDebug(LoggerContextType* pLoggerContext, const char* pFormat, ...)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
+   if (NULL == pLoggerContext || NULL == pFormat) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // write to buffer
+   // format and write to buffer
    TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
-   if (LOG_LEVEL_DEBUG <= pLoggerContext->logLevel) {
-      size_t logLength = strlen(pLogText) + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[D]: \n"
-      status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, LOG_LEVEL_DEBUG);
+   if (LOG_LEVEL_DEBUG <= pLoggerContext->filter.logLevel) {
+      va_list args;
+      va_start(args, pFormat);
+      status = TextLogger_SubmitLogf(pLoggerContext, pFormat, args, LOG_LEVEL_DEBUG);
+      va_end(args);
    }
 
    return status;
 }
 
-TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, const char* pLogText)
+TextLoggerStatusType TextLogger_LogfVerbose(LoggerContextType* pLoggerContext, const char* pFormat, ...)
 {
-   if (NULL == pLoggerContext || NULL == pLogText) {
+   if (NULL == pLoggerContext || NULL == pFormat) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // write to buffer
+   // format and write to buffer
    TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
-   if (LOG_LEVEL_VERBOSE <= pLoggerContext->logLevel) {
-      size_t logLength = strlen(pLogText) + LOG_EXTRA_STR_LENGTH; // LOG_EXTRA_STR_LENGTH corresponds to "[V]: \n"
-      status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, logLength, LOG_LEVEL_VERBOSE);
+   if (LOG_LEVEL_VERBOSE <= pLoggerContext->filter.logLevel) {
+      va_list args;
+      va_start(args, pFormat);
+      status = TextLogger_SubmitLogf(pLoggerContext, pFormat, args, LOG_LEVEL_VERBOSE);
+      va_end(args);
    }
 
    return status;
@@ -353,23 +1491,29 @@ TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, co
  */
 static TextLoggerStatusType TextLogger_FlushErrMsgToFileStream(LoggerContextType* pLoggerContext)
 {
-   // Open file in append mode - binary
-   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "ab");
    if (NULL == pLoggerContext->pLogFile) {
-      // Failed to open the file
       return TEXTLOGGER_ERR_FILE_ERROR;
    }
 
-   // Write buffer to the file
-   size_t bytesWritten = fwrite(pLoggerContext->pErrMsg, sizeof(char), strlen(pLoggerContext->pErrMsg), pLoggerContext->pLogFile);
-   if (bytesWritten != strlen(pLoggerContext->pErrMsg)) {
-      // Failed to write all data to the file
-      fclose(pLoggerContext->pLogFile);
+   // goes after the buffers in flight
+   if (NULL != pLoggerContext->pFlusher && TEXTLOGGER_SUCCESS != TextLogger_FlusherWait(pLoggerContext)) {
       return TEXTLOGGER_ERR_FILE_ERROR;
    }
 
-   fclose(pLoggerContext->pLogFile);
-   return TEXTLOGGER_SUCCESS;
+   // binary format wraps the message in a raw text record
+   size_t errMsgLength = strlen(pLoggerContext->pErrMsg);
+   if (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) {
+      unsigned char pHeader[TEXTLOGGER_BINARY_MAX_HEADER_LENGTH];
+      pHeader[0] = TEXTLOGGER_BINARY_LEVEL_RAW_TEXT;
+      int headerLength = 1 + (int) TextLogger_BinaryPutVarint(pHeader + 1, errMsgLength);
+      TextLoggerStatusType status = TextLogger_WriteBytesToFile(pLoggerContext, (const char*) pHeader, headerLength);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   // Write buffer to the file
+   return TextLogger_WriteBytesToFile(pLoggerContext, pLoggerContext->pErrMsg, (int) errMsgLength);
 }
 
 TextLoggerStatusType TextLogger_FlushTextToFileStream(LoggerContextType* pLoggerContext)
@@ -378,8 +1522,80 @@ TextLoggerStatusType TextLogger_FlushTextToFileStream(LoggerContextType* pLogger
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
+   // buffer is owned by the writer thread in async mode
+   TextLoggerStatusType status;
+   if (TEXTLOGGER_MODE_ASYNC == pLoggerContext->mode) {
+      status = TextLogger_AsyncFlush(pLoggerContext);
+   } else if (TEXTLOGGER_MODE_PER_THREAD == pLoggerContext->mode) {
+      status = TextLogger_PerThreadFlush(pLoggerContext);
+   } else if (TEXTLOGGER_MODE_DAEMON == pLoggerContext->mode) {
+      status = TextLogger_DaemonFlush(pLoggerContext);
+   } else {
+      status = TextLogger_FlushBuffer(pLoggerContext);
+   }
+
+   // handed over buffers count as flushed once the flush thread wrote them
+   if (TEXTLOGGER_SUCCESS == status && NULL != pLoggerContext->pFlusher) {
+      status = TextLogger_FlusherWait(pLoggerContext);
+   }
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_Sync(LoggerContextType* pLoggerContext)
+{
+   // the daemon flushes and syncs the file it writes
+   if (NULL != pLoggerContext && TEXTLOGGER_MODE_DAEMON == pLoggerContext->mode) {
+      return TextLogger_DaemonSync(pLoggerContext);
+   }
+
+   // records logged so far reach the file first
+   TextLoggerStatusType status = TextLogger_FlushTextToFileStream(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS != status) {
+      return status;
+   }
+
+   return TextLogger_DurableSync(pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_DumpFlightRecorder(LoggerContextType* pLoggerContext)
+{
+   if (NULL == pLoggerContext) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   if (NULL == pLoggerContext->pRecorder) {
+      return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+   }
+
+   // the flight recorder belongs to the thread formatting into pTextBuffer
+   TextLoggerStatusType status;
+   if (TEXTLOGGER_MODE_ASYNC == pLoggerContext->mode) {
+      status = TextLogger_AsyncPushRecorderDump(pLoggerContext);
+   } else if (TEXTLOGGER_MODE_PER_THREAD == pLoggerContext->mode) {
+      status = TextLogger_PerThreadWriteRecorder(pLoggerContext);
+   } else {
+      status = TextLogger_WriteFlightRecorder(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS != status) {
+      return status;
+   }
+
+   return TextLogger_FlushTextToFileStream(pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_FlushBuffer(LoggerContextType* pLoggerContext)
+{
+   // with rotation enabled, a full file is moved away (see TextLogger_RotateBeforeRecord) instead of stopping at maxFileSize
+   bool rotationIsEnabled = (0 < pLoggerContext->rotationMaxFiles);
+   if (rotationIsEnabled && TextLogger_RotationIntervalHasElapsed(pLoggerContext)) {
+      TextLoggerStatusType status = TextLogger_RotateFile(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
    // check if max file size has been reached
-   if (pLoggerContext->maxFileSize <= pLoggerContext->totalBytesStored) {
+   if (pLoggerContext->fileSizeIsLimited && pLoggerContext->maxFileSize <= pLoggerContext->totalBytesStored) {
       if(false == pLoggerContext->fileLimitIsReached) {
          // write error msg on file (only once)
          pLoggerContext->fileLimitIsReached = true;
@@ -396,85 +1612,124 @@ TextLoggerStatusType TextLogger_FlushTextToFileStream(LoggerContextType* pLogger
       return TEXTLOGGER_SUCCESS; // Nothing to flush, return success
    }
 
-   // Open file in append mode - binary
-   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "ab");
    if (NULL == pLoggerContext->pLogFile) {
-      // Failed to open the file
       return TEXTLOGGER_ERR_FILE_ERROR;
    }
 
-   // Get current file size
-   fseek(pLoggerContext->pLogFile, 0L, SEEK_END);
-   long int currFileSize = ftell(pLoggerContext->pLogFile);
-
    // account for scenario where buffer flush might overshoot maxFileSize
    TextLoggerStatusType status;
-   if (pLoggerContext->currBytePos + currFileSize > pLoggerContext->maxFileSize) {
+   long int pendingLength = pLoggerContext->currBytePos;
+   if (NULL != pLoggerContext->pGather) {
+      pendingLength += TextLogger_GatherPendingSize(pLoggerContext);
+   }
+   if (NULL != pLoggerContext->pCompress) {
+      // only the compressed block and its index entry count against maxFileSize
+      long int blockLength = TextLogger_CompressBlock(pLoggerContext, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+      long int indexLength = TextLogger_CompressIndexSize(pLoggerContext);
+      if (pLoggerContext->fileSizeIsLimited && blockLength + indexLength + pLoggerContext->currFileSize > pLoggerContext->maxFileSize) {
+         pLoggerContext->totalBytesStored = pLoggerContext->maxFileSize; // error message follows with the next flush
+         status = TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE;
+      } else {
+         status = TextLogger_CompressWriteBlock(pLoggerContext);
+         if (TEXTLOGGER_SUCCESS != status) {
+            return status;
+         }
+         pLoggerContext->totalBytesStored = (int) pLoggerContext->currFileSize; // records buffered next are counted uncompressed on top
+      }
+   } else if (pLoggerContext->fileSizeIsLimited && pendingLength + pLoggerContext->currFileSize > pLoggerContext->maxFileSize) {
       // overshot maxFileSize
       if(false == pLoggerContext->fileLimitIsReached) {
          pLoggerContext->fileLimitIsReached = true;
       }
+      if (NULL != pLoggerContext->pGather) {
+         TextLogger_GatherClear(pLoggerContext);
+      }
       status = TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE;
+   } else if (NULL != pLoggerContext->pMmap) {
+      // buffer already is the file, it only needs to be counted
+      return TextLogger_MmapCommit(pLoggerContext);
+   } else if (NULL != pLoggerContext->pFlusher) {
+      // hand buffer to the flush thread and carry on in a free one
+      status = TextLogger_FlusherSubmit(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+      if (!pLoggerContext->circularFile) {
+         pLoggerContext->currFileSize += pLoggerContext->currBytePos; // size once the flush thread is done
+      }
+   } else if (NULL != pLoggerContext->pGather && TextLogger_GatherIsPending(pLoggerContext)) {
+      // gathered messages go in between, the buffer is reset even after an error since they are gone
+      status = TextLogger_GatherFlush(pLoggerContext);
    } else {
       // Write buffer to the file
-      size_t bytesWritten = fwrite(pLoggerContext->pTextBuffer, sizeof(char), pLoggerContext->currBytePos, pLoggerContext->pLogFile);
-      if (bytesWritten != pLoggerContext->currBytePos) {
-         // Failed to write all data to the file
-         fclose(pLoggerContext->pLogFile);
-         return TEXTLOGGER_ERR_FILE_ERROR;
+      status = TextLogger_WriteBytesToFile(pLoggerContext, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
       }
-
-      status = TEXTLOGGER_SUCCESS;
    }
 
-   // currFileSize = ftell(pLoggerContext->pLogFile); // => for debug
    // printf("curr byte pos: %d, total byte stored: %dB, curr file size: %ldB\n", // => for debug
-   //         pLoggerContext->currBytePos, pLoggerContext->totalBytesStored, currFileSize);
-
-   // close file
-   fclose(pLoggerContext->pLogFile);
+   //         pLoggerContext->currBytePos, pLoggerContext->totalBytesStored, pLoggerContext->currFileSize);
 
    // Reset buffer position
    pLoggerContext->currBytePos = 0;
+   if (NULL != pLoggerContext->pPersist) {
+      TextLogger_PersistFlushed(pLoggerContext);
+   }
 
    return status;
 }
 
-TextLoggerStatusType TextLogger_PrintCurrFileSize(LoggerContextType* pLoggerContext)
+TextLoggerStatusType TextLogger_ReopenFile(LoggerContextType* pLoggerContext)
 {
    if (NULL == pLoggerContext) {
       return TEXTLOGGER_ERR_INVALID_INPUT;
    }
 
-   // Open file in append mode - binary
-   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "ab");
-   if (NULL == pLoggerContext->pLogFile) {
-      // Failed to open the file
-      return TEXTLOGGER_ERR_FILE_ERROR;
+   // file handle is shared between threads in other modes
+   if (TEXTLOGGER_MODE_SYNC != pLoggerContext->mode) {
+      return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+   }
+
+   // Flush any remaining text to the old file first, what it has no room for stays in the buffer
+   TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+   if (TEXTLOGGER_ERR_FILE_ERROR != status && NULL != pLoggerContext->pFlusher) {
+      status = TextLogger_FlusherWait(pLoggerContext);
+   }
+   if (TEXTLOGGER_ERR_FILE_ERROR == status) {
+      return status;
+   }
+
+   // close old file
+   TextLoggerStatusType closeStatus = TextLogger_CloseFile(pLoggerContext);
+
+   // the file at pFilePath may have been replaced, so the size limit starts over with the pending buffer
+   pLoggerContext->totalBytesStored = pLoggerContext->currBytePos;
+   pLoggerContext->fileLimitIsReached = false;
+
+   // pending buffer goes to the new file
+   status = TextLogger_OpenFile(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS == status) {
+      status = TextLogger_FlushBuffer(pLoggerContext);
+   }
+   if (TEXTLOGGER_SUCCESS == status) {
+      status = closeStatus;
+   }
+   return status;
+}
+
+TextLoggerStatusType TextLogger_PrintCurrFileSize(LoggerContextType* pLoggerContext)
+{
+   if (NULL == pLoggerContext) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
    }
-   // Get current file size
-   fseek(pLoggerContext->pLogFile, 0L, SEEK_END);
-   long int currFileSizeAb = ftell(pLoggerContext->pLogFile);
-   // close file
-   fclose(pLoggerContext->pLogFile);
 
-   // Open file in append mode - text
-   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "a");
    if (NULL == pLoggerContext->pLogFile) {
-      // Failed to open the file
       return TEXTLOGGER_ERR_FILE_ERROR;
    }
-   // Get current file size
-   fseek(pLoggerContext->pLogFile, 0L, SEEK_END);
-   long int currFileSizeA = ftell(pLoggerContext->pLogFile);
-   // close file
-   fclose(pLoggerContext->pLogFile);
 
-   printf("Current file size - binary: %ld\n", currFileSizeAb);
-   printf("Current file size - text: %ld\n", currFileSizeA);
+   printf("Current file size: %ld\n", pLoggerContext->currFileSize);
    printf("Total bytes stored: %d\n", pLoggerContext->totalBytesStored);
 
    return TEXTLOGGER_SUCCESS;
 }
-
-
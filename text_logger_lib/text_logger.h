@@ -13,6 +13,9 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#if defined(__cplusplus) && __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 /**
  * @brief This is the enum type for
@@ -22,7 +25,9 @@ typedef enum {
    TEXTLOGGER_SUCCESS = 0,
    TEXTLOGGER_ERR_FILE_ERROR,
    TEXTLOGGER_ERR_INVALID_INPUT,
-   TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE
+   TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE,
+   TEXTLOGGER_ERR_UNSUPPORTED_MODE,
+   TEXTLOGGER_ERR_QUEUE_FULL // record dropped by the async queue policy, see TextLoggerFullPolicyType
 } TextLoggerStatusType;
 
 /**
@@ -39,14 +44,215 @@ typedef enum {
    LOG_LEVEL_VERBOSE
 } LogLevelType;
 
+/**
+ * @brief This is the enum type for
+ * how log messages reach the file.
+ */
+typedef enum {
+   TEXTLOGGER_MODE_SYNC = 0, // caller formats into buffer and writes to file when it is full
+   TEXTLOGGER_MODE_ASYNC,    // caller queues record, a writer thread formats and writes to file
+   TEXTLOGGER_MODE_PER_THREAD, // each thread fills its own buffer of maxBufferByteSize, flushing merges them in timestamp order
+   TEXTLOGGER_MODE_DAEMON     // POSIX: caller copies record into a shared-memory ring, the textlog_daemon process formats and writes to file
+} TextLoggerModeType;
+
+/**
+ * @brief This is the enum type for
+ * what happens when the async queue is full.
+ * Dropped records are counted per level and reported in one warning record
+ * once the writer thread has caught up, at most once a second.
+ */
+typedef enum {
+   TEXTLOGGER_FULL_BLOCK = 0,     // caller waits for a free slot
+   TEXTLOGGER_FULL_DROP_NEWEST,   // record being logged is dropped
+   TEXTLOGGER_FULL_DROP_OLDEST,   // caller waits while the writer thread discards queued records, oldest first, until the queue is half empty
+   TEXTLOGGER_FULL_DROP_BY_LEVEL  // verbose records are dropped from half full, debug from three quarters, info when full, errors and warnings wait
+} TextLoggerFullPolicyType;
+
+/**
+ * @brief This is the enum type for
+ * how records are stored in the file.
+ */
+typedef enum {
+   TEXTLOGGER_FORMAT_TEXT = 0, // "[YYYY-MM-DD | HH:MM:SS] [E]: message" lines
+   TEXTLOGGER_FORMAT_BINARY    // compact records, see text_logger_binary.h, turned back into text by tools/textlog_decode
+} TextLoggerFormatType;
+
+/**
+ * @brief This is the enum type for
+ * how buffers reach the file.
+ */
+typedef enum {
+   TEXTLOGGER_BACKEND_STDIO = 0,   // one buffer at a time through the FILE of the log file
+   TEXTLOGGER_BACKEND_IO_URING,    // Linux: every handed over buffer is in flight at once, at its own offset; pwrite where io_uring is unavailable
+   TEXTLOGGER_BACKEND_MMAP         // POSIX: records are formatted straight into the mapped file, preallocated mmapChunkSize bytes at a time
+} TextLoggerWriteBackendType;
+
+/**
+ * @brief This is the enum type for
+ * when written records are synced to storage, so they survive a power loss or kernel crash.
+ */
+typedef enum {
+   TEXTLOGGER_DURABILITY_NONE = 0,        // left to the operating system, TextLogger_Sync syncs on request
+   TEXTLOGGER_DURABILITY_SYNC_ON_ERROR,   // every error record is written and synced before the call returns (by the writer thread in async mode)
+   TEXTLOGGER_DURABILITY_GROUP_COMMIT     // a sync thread syncs once per groupCommitWindowMs, covering every record written in that window
+} TextLoggerDurabilityType;
+
+/**
+ * @brief This is the enum type for
+ * how flushed buffers are stored in the file.
+ */
+typedef enum {
+   TEXTLOGGER_COMPRESSION_NONE = 0, // bytes are written as they are
+   TEXTLOGGER_COMPRESSION_LZ4       // every flushed buffer becomes one LZ4 compressed block, see text_logger_lz.h, read back by tools/textlog_decode
+} TextLoggerCompressionType;
+
+/**
+ * @brief This is the structure type for
+ * options used when creating a logger context.
+ * Initialize with TextLogger_InitConfig before changing individual options.
+ */
+typedef struct {
+   char* pFilePath; // full file path
+   char* pErrMsg; // error message when file limit is reached
+   int logLevel; // refer to LogLevelType for list of log levels
+   int maxBufferByteSize; // max size of buffer in bytes
+   int maxFileSize; // max size of file that contains all combined buffer + error message, or size at which the file is rotated
+   TextLoggerModeType mode; // defaults to TEXTLOGGER_MODE_SYNC
+   int asyncQueueCapacity; // number of queued records in async mode, rounded up to a power of two
+   int asyncMaxTextSize; // max length of one queued message in async mode, longer ones are truncated
+   TextLoggerFullPolicyType asyncFullPolicy; // defaults to TEXTLOGGER_FULL_BLOCK
+   TextLoggerFormatType format; // defaults to TEXTLOGGER_FORMAT_TEXT
+   int rotationMaxFiles; // rotated files kept (file.1 newest ... file.N oldest), 0 stops logging at maxFileSize instead
+   int rotationIntervalSec; // with rotation enabled, also rotate files older than this, 0 rotates on size only
+   bool circularFile; // keep the most recent bytes in a preallocated file of maxFileSize, text format and no rotation only
+   int flushBufferCount; // buffers of maxBufferByteSize, more than 1 moves file writes to a flush thread so logging continues in a free buffer
+   TextLoggerWriteBackendType writeBackend; // defaults to TEXTLOGGER_BACKEND_STDIO, io_uring needs flushBufferCount > 1, mmap needs 1 and text format, neither works with a circular file
+   int mmapChunkSize; // bytes preallocated and mapped at once with TEXTLOGGER_BACKEND_MMAP, at least one buffer
+   TextLoggerDurabilityType durability; // defaults to TEXTLOGGER_DURABILITY_NONE
+   int groupCommitWindowMs; // time between syncs with TEXTLOGGER_DURABILITY_GROUP_COMMIT
+   int gatherMinTextSize; // sync mode appending through stdio with one buffer: messages at least this long are written from the caller's memory with writev instead of being copied into the buffer, 0 only those that do not fit in it
+   TextLoggerCompressionType compression; // defaults to TEXTLOGGER_COMPRESSION_NONE, LZ4 needs the stdio backend, one buffer of at most 4 MiB and no circular file; maxFileSize then limits compressed bytes
+   int rotationCompressThreads; // with rotation enabled and no compression, rotated files are compressed to file.N.tlz by this many background threads, 0 keeps them as they are
+   int flightRecorderSize; // bytes of an in-memory ring keeping the most recent records less important than logLevel, written to the file before the next error record or by TextLogger_DumpFlightRecorder; 0 drops them, otherwise at least 128
+   bool crashDump; // on SIGSEGV, SIGBUS, SIGILL, SIGFPE or SIGABRT, write the records still in pTextBuffer from a signal handler; stdio backend, flushBufferCount of 1, no per-thread mode and no circularFile
+   char* pBufferFilePath; // file mapped as pTextBuffer (e.g. in /dev/shm), so a killed process leaves its unflushed records there for the next context or textlog_decode; NULL allocates the buffer; stdio backend, flushBufferCount of 1, no per-thread mode, POSIX only
+   char* pDaemonDirPath; // directory served by textlog_daemon (see TextLogger_RunDaemon), where TEXTLOGGER_MODE_DAEMON creates the ring of the context; pFilePath is opened by the daemon, relative to the caller's working directory
+   int daemonRingSize; // bytes of the ring in TEXTLOGGER_MODE_DAEMON, at least 4096, messages longer than half of it are truncated; asyncFullPolicy is TEXTLOGGER_FULL_BLOCK (only while a daemon serves the ring) or TEXTLOGGER_FULL_DROP_NEWEST
+} TextLoggerConfigType;
+
+/**
+ * @brief This is the structure type of one record passed to TextLogger_LogBatch.
+ */
+typedef struct {
+   LogLevelType logLevel;
+   const char* pText; // needs no null terminator, may be NULL if textLength is 0
+   size_t textLength;
+} TextLoggerMessageType;
+
 typedef struct LoggerContext LoggerContextType;
 
+/**
+ * @brief This is the structure type of the leading member of a logger context.
+ * It is public so the TLOG_* macros can check the level inline;
+ * users of the module must not modify it.
+ */
+typedef struct {
+   int logLevel; // refer to LogLevelType for list of log levels
+} TextLoggerFilterType;
+
+/**
+ * Least important level compiled in by the TLOG_* macros, as a number since enums
+ * are not usable by the preprocessor: 1 (error) ... 5 (verbose), 0 strips every level.
+ * e.g. -DTEXTLOGGER_MIN_LEVEL=3 turns TLOG_DEBUG and TLOG_VERBOSE into nothing.
+ */
+#ifndef TEXTLOGGER_MIN_LEVEL
+#define TEXTLOGGER_MIN_LEVEL     (5)
+#endif
+
+// checks the context's level before the arguments are evaluated, NULL contexts are left to the function to reject
+#define TEXTLOGGER_LEVEL_IS_ENABLED(pLoggerContext, level) \
+   (NULL == (pLoggerContext) || (level) <= ((const TextLoggerFilterType*) (const void*) (pLoggerContext))->logLevel)
+
+// compiled out levels still type-check their arguments, but sizeof never evaluates them
+#define TEXTLOGGER_STRIPPED(logfFunction, pLoggerContext, ...) \
+   ((void) sizeof(logfFunction((pLoggerContext), __VA_ARGS__)), (TextLoggerStatusType) TEXTLOGGER_SUCCESS)
+
+#define TEXTLOGGER_ENABLED(logfFunction, level, pLoggerContext, ...) \
+   (TEXTLOGGER_LEVEL_IS_ENABLED((pLoggerContext), (level)) ? logfFunction((pLoggerContext), __VA_ARGS__) : (TextLoggerStatusType) TEXTLOGGER_SUCCESS)
+
+/*
+ * TLOG_ERROR(pLoggerContext, pFormat, ...) ... TLOG_VERBOSE(pLoggerContext, pFormat, ...)
+ * log printf-style like TextLogger_LogfError ... TextLogger_LogfVerbose and evaluate to their status.
+ * pLoggerContext is evaluated more than once.
+ */
+#if TEXTLOGGER_MIN_LEVEL >= 1
+#define TLOG_ERROR(pLoggerContext, ...)      TEXTLOGGER_ENABLED(TextLogger_LogfError, LOG_LEVEL_ERROR, pLoggerContext, __VA_ARGS__)
+#else
+#define TLOG_ERROR(pLoggerContext, ...)      TEXTLOGGER_STRIPPED(TextLogger_LogfError, pLoggerContext, __VA_ARGS__)
+#endif
+
+#if TEXTLOGGER_MIN_LEVEL >= 2
+#define TLOG_WARN(pLoggerContext, ...)       TEXTLOGGER_ENABLED(TextLogger_LogfWarn, LOG_LEVEL_WARN, pLoggerContext, __VA_ARGS__)
+#else
+#define TLOG_WARN(pLoggerContext, ...)       TEXTLOGGER_STRIPPED(TextLogger_LogfWarn, pLoggerContext, __VA_ARGS__)
+#endif
+
+#if TEXTLOGGER_MIN_LEVEL >= 3
+#define TLOG_INFO(pLoggerContext, ...)       TEXTLOGGER_ENABLED(TextLogger_LogfInfo, LOG_LEVEL_INFO, pLoggerContext, __VA_ARGS__)
+#else
+#define TLOG_INFO(pLoggerContext, ...)       TEXTLOGGER_STRIPPED(TextLogger_LogfInfo, pLoggerContext, __VA_ARGS__)
+#endif
+
+#if TEXTLOGGER_MIN_LEVEL >= 4
+#define TLOG_DEBUG(pLoggerContext, ...)      TEXTLOGGER_ENABLED(TextLogger_LogfDebug, LOG_LEVEL_DEBUG, pLoggerContext, __VA_ARGS__)
+#else
+#define TLOG_DEBUG(pLoggerContext, ...)      TEXTLOGGER_STRIPPED(TextLogger_LogfDebug, pLoggerContext, __VA_ARGS__)
+#endif
+
+#if TEXTLOGGER_MIN_LEVEL >= 5
+#define TLOG_VERBOSE(pLoggerContext, ...)    TEXTLOGGER_ENABLED(TextLogger_LogfVerbose, LOG_LEVEL_VERBOSE, pLoggerContext, __VA_ARGS__)
+#else
+#define TLOG_VERBOSE(pLoggerContext, ...)    TEXTLOGGER_STRIPPED(TextLogger_LogfVerbose, pLoggerContext, __VA_ARGS__)
+#endif
+
+// lets the compiler check arguments of the TextLogger_Logf* functions
+#if defined(__GNUC__)
+#define TEXTLOGGER_PRINTF_FORMAT(formatIndex, firstArgIndex)   __attribute__((format(printf, formatIndex, firstArgIndex)))
+#else
+#define TEXTLOGGER_PRINTF_FORMAT(formatIndex, firstArgIndex)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
 /**
- * Initializes a logger context.
+ * Fills a configuration with the given parameters and default options.
+ * 
+ * @param [out] pConfig Pointer to configuration to fill.
+ * @param [in] pFilePath String containing full file path.
+ * @param [in] pErrMsg String containing error message when file limit is reached.
+ * @param [in] logLevel To filter log messages based on level of importance.
+ * @param [in] maxBufferByteSize Max size of buffer in bytes.
+ * @param [in] maxFileSize Max size of file that contains all combined buffer + error message. 
+ */
+void TextLogger_InitConfig(TextLoggerConfigType* pConfig, char* pFilePath, char* pErrMsg, int logLevel, int maxBufferByteSize, int maxFileSize);
+
+/**
+ * Initializes a logger context from a configuration.
+ * In TEXTLOGGER_MODE_ASYNC a writer thread is started here and stopped in TextLogger_Destroy.
+ * In TEXTLOGGER_MODE_ASYNC and TEXTLOGGER_MODE_PER_THREAD the context can be used from several threads.
+ * @post this function needs to be called before calling any other function in this module
+ * 
+ * @param [in] pConfig Pointer to configuration filled by TextLogger_InitConfig.
+ * @return pointer to logger context type.
+ * @return NULL if an input is invalid or the log file cannot be opened.
+ */
+LoggerContextType* TextLogger_CreateWithConfig(const TextLoggerConfigType* pConfig);
+
+/**
+ * Initializes a logger context in TEXTLOGGER_MODE_SYNC.
+ * The log file is opened here and kept open until TextLogger_Destroy.
  * @post this function needs to be called before calling any other function in this module
  * 
  * @param [in] pFilePath String containing full file path.
@@ -55,11 +261,13 @@ extern "C" {
  * @param [in] maxBufferByteSize Max size of buffer in bytes.
  * @param [in] maxFileSize Max size of file that contains all combined buffer + error message. 
  * @return pointer to logger context type.
+ * @return NULL if an input is invalid or the log file cannot be opened.
  */
 LoggerContextType* TextLogger_Create(char* pFilePath, char* pErrMsg, int logLevel, int maxBufferByteSize, int maxFileSize);
 
 /**
  * Destroys a logger context.
+ * In async mode, every queued record is written to file before returning.
  * 
  * @param [in,out] pLoggerContext Pointer to logger context.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
@@ -71,15 +279,50 @@ TextLoggerStatusType TextLogger_Destroy(LoggerContextType* pLoggerContext);
 
 /**
  * Writes current date and time to buffer.
+ * Only available in TEXTLOGGER_MODE_SYNC with TEXTLOGGER_FORMAT_TEXT.
  * 
  * @param [in,out] pLoggerContext Pointer to logger context.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if context is not in TEXTLOGGER_MODE_SYNC or uses TEXTLOGGER_FORMAT_BINARY.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
 TextLoggerStatusType TextLogger_LogTimeStamp(LoggerContextType* pLoggerContext);
 
+/**
+ * Writes log of any level and known length to buffer.
+ * Every other TextLogger_Log* function ends up here.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] logLevel Level of log message.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL, logLevel is unknown or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_Log(LoggerContextType* pLoggerContext, LogLevelType logLevel, const char* pText, size_t textLength);
+
+/**
+ * Writes several logs of any level and known length, like calling TextLogger_Log for each, stopping at the first failure.
+ * In TEXTLOGGER_MODE_SYNC, messages gathered per gatherMinTextSize are written together
+ * with the buffer by one writev per batch instead of one per record.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pMessages Records to log, in order.
+ * @param [in] messageCount Number of records.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL, a logLevel is unknown or a textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if a record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogBatch(LoggerContextType* pLoggerContext, const TextLoggerMessageType* pMessages, size_t messageCount);
+
 /**
  * Writes Error level log to buffer.
  * 
@@ -87,6 +330,7 @@ TextLoggerStatusType TextLogger_LogTimeStamp(LoggerContextType* pLoggerContext);
  * @param [in] pText String containing log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
@@ -99,6 +343,7 @@ TextLoggerStatusType TextLogger_LogError(LoggerContextType* pLoggerContext, cons
  * @param [in] pText String containing log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
@@ -111,6 +356,7 @@ TextLoggerStatusType TextLogger_LogWarn(LoggerContextType* pLoggerContext, const
  * @param [in] pText String containing log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
@@ -123,6 +369,7 @@ TextLoggerStatusType TextLogger_LogInfo(LoggerContextType* pLoggerContext, const
  * @param [in] pText String containing log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
@@ -135,13 +382,167 @@ TextLoggerStatusType TextLogger_LogDebug(LoggerContextType* pLoggerContext, cons
  * @param [in] pText String containing log message.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
  * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
  * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
  * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
  */
 TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, const char* pText); // log level 5
 
+/**
+ * Writes Error level log of known length to buffer.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogErrorN(LoggerContextType* pLoggerContext, const char* pText, size_t textLength); // log level 1
+
+/**
+ * Writes Warn level log of known length to buffer.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogWarnN(LoggerContextType* pLoggerContext, const char* pText, size_t textLength); // log level 2
+
+/**
+ * Writes Info level log of known length to buffer.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogInfoN(LoggerContextType* pLoggerContext, const char* pText, size_t textLength); // log level 3
+
+/**
+ * Writes Debug level log of known length to buffer.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogDebugN(LoggerContextType* pLoggerContext, const char* pText, size_t textLength); // log level 4
+
+/**
+ * Writes Verbose level log of known length to buffer.
+ * pText needs no null terminator. A record larger than the buffer is written straight to the file.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pText Log message, may be NULL if textLength is 0.
+ * @param [in] textLength Length of log message in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or textLength does not fit in an int.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogVerboseN(LoggerContextType* pLoggerContext, const char* pText, size_t textLength); // log level 5
+
+/**
+ * Formats and writes Error level log to buffer, printf-style.
+ * Arguments are not evaluated for formatting if the level is filtered out.
+ * In async mode, formatting is done by the writer thread.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogfError(LoggerContextType* pLoggerContext, const char* pFormat, ...) TEXTLOGGER_PRINTF_FORMAT(2, 3); // log level 1
+
+/**
+ * Formats and writes Warn level log to buffer, printf-style.
+ * Arguments are not evaluated for formatting if the level is filtered out.
+ * In async mode, formatting is done by the writer thread.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogfWarn(LoggerContextType* pLoggerContext, const char* pFormat, ...) TEXTLOGGER_PRINTF_FORMAT(2, 3); // log level 2
+
+/**
+ * Formats and writes Info level log to buffer, printf-style.
+ * Arguments are not evaluated for formatting if the level is filtered out.
+ * In async mode, formatting is done by the writer thread.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogfInfo(LoggerContextType* pLoggerContext, const char* pFormat, ...) TEXTLOGGER_PRINTF_FORMAT(2, 3); // log level 3
+
+/**
+ * Formats and writes Debug level log to buffer, printf-style.
+ * Arguments are not evaluated for formatting if the level is filtered out.
+ * In async mode, formatting is done by the writer thread.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogfDebug(LoggerContextType* pLoggerContext, const char* pFormat, ...) TEXTLOGGER_PRINTF_FORMAT(2, 3); // log level 4
+
+/**
+ * Formats and writes Verbose level log to buffer, printf-style.
+ * Arguments are not evaluated for formatting if the level is filtered out.
+ * In async mode, formatting is done by the writer thread.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_LogfVerbose(LoggerContextType* pLoggerContext, const char* pFormat, ...) TEXTLOGGER_PRINTF_FORMAT(2, 3); // log level 5
+
 /**
  * Flushes buffer to file stream.
+ * In async mode, waits until the writer thread has written every record queued before this call.
+ * In per-thread mode, merges the buffers of all threads in timestamp order.
+ * In daemon mode, waits until the daemon has written them, TEXTLOGGER_ERR_FILE_ERROR if none serves the context.
  * 
  * @param [in,out] pLoggerContext Pointer to logger context.
  * @return TEXTLOGGER_SUCCESS if operation is successful.
@@ -151,6 +552,90 @@ TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, co
  */
 TextLoggerStatusType TextLogger_FlushTextToFileStream(LoggerContextType* pLoggerContext);
 
+/**
+ * Flushes buffer to file stream like TextLogger_FlushTextToFileStream,
+ * then waits until the records logged before this call are synced to storage.
+ * With TEXTLOGGER_DURABILITY_GROUP_COMMIT this waits for the next group commit,
+ * which also covers records of other threads; otherwise the file is synced right away.
+ * Records logged by other threads after this call are not waited for.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations or syncing.
+ */
+TextLoggerStatusType TextLogger_Sync(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes the records kept by the flight recorder (see flightRecorderSize) after
+ * the records logged so far, oldest first, then flushes like TextLogger_FlushTextToFileStream.
+ * The flight recorder is empty afterwards. An error record does the same without this call.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if the context has no flight recorder.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_DumpFlightRecorder(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes the records still buffered by every context created with crashDump
+ * to their files, like the handler of fatal signals does. Async-signal-safe,
+ * for applications with a fatal signal handler of their own (installed after
+ * the context, it replaces the logger's). Only the first call in the process
+ * writes; the contexts must not be used afterwards.
+ */
+void TextLogger_DumpCrashBuffers(void);
+
+/**
+ * Serves the TEXTLOGGER_MODE_DAEMON contexts of every process logging to
+ * pDirPath until TextLogger_StopDaemon is called: the records of each context
+ * are taken from its ring and written to its file by a context of this process,
+ * created with the options of the client. Rings of clients that were destroyed
+ * or exited are written to the end, then removed; rings of running clients are
+ * left for the next daemon. Run by tools/textlog_daemon, one per directory.
+ *
+ * @param [in] pDirPath Directory the clients create their rings in.
+ * @return TEXTLOGGER_SUCCESS once stopped.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or the path is too long.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the directory cannot be used or another daemon serves it.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if not built for POSIX.
+ */
+TextLoggerStatusType TextLogger_RunDaemon(const char* pDirPath);
+
+/**
+ * Makes TextLogger_RunDaemon return after its current pass. Async-signal-safe,
+ * to be called from a SIGTERM or SIGINT handler.
+ */
+void TextLogger_StopDaemon(void);
+
+/**
+ * Flushes buffer, closes log file and opens it again at the same path.
+ * To be called by external log rotation tools after moving the file away.
+ * Records the old file had no room for are written to the new one.
+ * 
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_ReopenFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes the records of a circular log file (TextLoggerConfigType.circularFile)
+ * to pOutput, oldest first. A record partly overwritten by newer ones is skipped.
+ * 
+ * @param [in] pFilePath String containing full file path.
+ * @param [in,out] pOutput Stream to write the records to.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL or the file is not a circular log file.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_ReadCircularFile(const char* pFilePath, FILE* pOutput);
+
 /**
  * Prints current file size.
  * 
@@ -165,6 +650,39 @@ TextLoggerStatusType TextLogger_PrintCurrFileSize(LoggerContextType* pLoggerCont
 }
 #endif // __cplusplus
 
+// C++17: log std::string, std::string_view and friends without strlen or a copy
+#if defined(__cplusplus) && __cplusplus >= 201703L
+inline TextLoggerStatusType TextLogger_Log(LoggerContextType* pLoggerContext, LogLevelType logLevel, std::string_view text)
+{
+   return TextLogger_Log(pLoggerContext, logLevel, text.data(), text.size());
+}
+
+inline TextLoggerStatusType TextLogger_LogError(LoggerContextType* pLoggerContext, std::string_view text)
+{
+   return TextLogger_LogErrorN(pLoggerContext, text.data(), text.size());
+}
+
+inline TextLoggerStatusType TextLogger_LogWarn(LoggerContextType* pLoggerContext, std::string_view text)
+{
+   return TextLogger_LogWarnN(pLoggerContext, text.data(), text.size());
+}
+
+inline TextLoggerStatusType TextLogger_LogInfo(LoggerContextType* pLoggerContext, std::string_view text)
+{
+   return TextLogger_LogInfoN(pLoggerContext, text.data(), text.size());
+}
+
+inline TextLoggerStatusType TextLogger_LogDebug(LoggerContextType* pLoggerContext, std::string_view text)
+{
+   return TextLogger_LogDebugN(pLoggerContext, text.data(), text.size());
+}
+
+inline TextLoggerStatusType TextLogger_LogVerbose(LoggerContextType* pLoggerContext, std::string_view text)
+{
+   return TextLogger_LogVerboseN(pLoggerContext, text.data(), text.size());
+}
+#endif // __cplusplus >= 201703L
+
 #endif // _TEXT_LOGGER_H_
 
 /**
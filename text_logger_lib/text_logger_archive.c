@@ -0,0 +1,487 @@
+#define _POSIX_C_SOURCE 200809L // pread, fsync
+
+/* system headers */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+#include "text_logger_lz.h"
+
+#ifndef _WIN32
+
+/*
+ * Defines
+ */
+
+#define ARCHIVE_BLOCK_SIZE       (1024 * 1024) // uncompressed bytes per block, the unit of work of one thread
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of one rotated file queued for compression.
+ *
+ * Threads claim its blocks in order and append them to file.N.tlz in the same
+ * order, each one waiting for the blocks claimed before its own. Both files
+ * stay open, so rotation can rename them while they are compressed.
+ */
+typedef struct TextLoggerArchiveSegment{
+   struct TextLoggerArchiveSegment* pNext;
+   int fileIndex; // N of file.N, moves on with every rotation, beyond rotationMaxFiles once the file was dropped
+   bool isOpen;
+   bool hasFailed; // file.N is kept and file.N.tlz removed
+   int inputFd; // file.N, -1 if not open
+   int outputFd; // file.N.tlz, -1 if not created
+   long int inputSize;
+   long int blockCount;
+   long int nextBlock; // next block to claim
+   long int nextWriteBlock; // next block to append to file.N.tlz
+} TextLoggerArchiveSegmentType;
+
+/**
+ * @brief This is the structure type of one compressing thread, with its own
+ * match finder and room for one block.
+ */
+typedef struct {
+   TextLoggerArchiveType* pArchive;
+   pthread_t thread;
+   TextLoggerLzTableType table;
+   unsigned char* pInput;
+   unsigned char* pBlock;
+} TextLoggerArchiveWorkerType;
+
+/**
+ * @brief This is the structure type of the background compression of rotated files.
+ *
+ * Every thread works on the oldest queued file that still has unclaimed blocks,
+ * so a single large file is compressed by all of them at once. lock is only
+ * held to claim blocks and to open, rename or remove files, never while
+ * compressing, so rotation in the flush path is not held up.
+ */
+struct TextLoggerArchive{
+   char* pFilePath; // copy of the active log file path
+   char* pPath; // scratch path, only used with lock held
+   int maxFiles;
+   TextLoggerArchiveSegmentType* pHead; // oldest first
+   TextLoggerArchiveSegmentType* pTail;
+   bool stopRequested;
+
+   TextLoggerArchiveWorkerType* pWorkers;
+   int threadCount; // threads started
+   pthread_mutex_t lock;
+   pthread_cond_t wakeWorker; // broadcast when a file is queued or finished, or stop is requested
+   pthread_cond_t blockWritten; // broadcast when nextWriteBlock of a file moves
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Writes all bytes to a file descriptor.
+ *
+ * @param [in] fd File descriptor.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes.
+ * @return true if successful.
+ */
+static bool TextLogger_ArchiveWriteAll(int fd, const unsigned char* pData, size_t length)
+{
+   while (0 < length) {
+      ssize_t written = write(fd, pData, length);
+      if (0 >= written) {
+         return false;
+      }
+      pData += written;
+      length -= (size_t) written;
+   }
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Reads all bytes of a block from a file descriptor.
+ *
+ * @param [in] fd File descriptor.
+ * @param [out] pData Destination.
+ * @param [in] length Number of bytes.
+ * @param [in] offset File offset of the block.
+ * @return true if successful.
+ */
+static bool TextLogger_ArchiveReadAll(int fd, unsigned char* pData, size_t length, off_t offset)
+{
+   while (0 < length) {
+      ssize_t bytesRead = pread(fd, pData, length, offset);
+      if (0 >= bytesRead) {
+         return false; // file was cut short
+      }
+      pData += bytesRead;
+      length -= (size_t) bytesRead;
+      offset += bytesRead;
+   }
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Opens file.N and creates file.N.tlz with the magic of compressed files.
+ * Called with lock held, so the names match fileIndex.
+ *
+ * @param [in,out] pArchive Pointer to background compression.
+ * @param [in,out] pSegment File to open.
+ */
+static void TextLogger_ArchiveOpenSegment(TextLoggerArchiveType* pArchive, TextLoggerArchiveSegmentType* pSegment)
+{
+   pSegment->isOpen = true;
+   if (pSegment->fileIndex > pArchive->maxFiles) {
+      return; // dropped before its turn
+   }
+
+   struct stat fileStatus;
+   TextLogger_RotatedFilePath(pArchive->pPath, pArchive->pFilePath, pSegment->fileIndex, "");
+   pSegment->inputFd = open(pArchive->pPath, O_RDONLY);
+   if (0 > pSegment->inputFd || 0 != fstat(pSegment->inputFd, &fileStatus)) {
+      pSegment->hasFailed = true;
+      return;
+   }
+
+   TextLogger_RotatedFilePath(pArchive->pPath, pArchive->pFilePath, pSegment->fileIndex, ARCHIVE_FILE_SUFFIX);
+   pSegment->outputFd = open(pArchive->pPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (0 > pSegment->outputFd ||
+       !TextLogger_ArchiveWriteAll(pSegment->outputFd, (const unsigned char*) TEXTLOGGER_LZ_MAGIC, TEXTLOGGER_LZ_MAGIC_LENGTH)) {
+      pSegment->hasFailed = true;
+      return;
+   }
+
+   pSegment->inputSize = (long int) fileStatus.st_size;
+   pSegment->blockCount = (pSegment->inputSize + ARCHIVE_BLOCK_SIZE - 1) / ARCHIVE_BLOCK_SIZE;
+}
+
+/**
+ * @internal
+ *
+ * Replaces file.N with the complete file.N.tlz, or removes file.N.tlz if
+ * compression failed, then takes the file off the queue.
+ * Called with lock held by the thread that appended the last block.
+ *
+ * @param [in,out] pArchive Pointer to background compression.
+ * @param [in,out] pSegment Finished file.
+ */
+static void TextLogger_ArchiveFinishSegment(TextLoggerArchiveType* pArchive, TextLoggerArchiveSegmentType* pSegment)
+{
+   // the compressed copy is made durable before the original goes away
+   bool isCompressed = (!pSegment->hasFailed && pSegment->fileIndex <= pArchive->maxFiles);
+   if (isCompressed) {
+      pthread_mutex_unlock(&pArchive->lock);
+      isCompressed = (0 == fsync(pSegment->outputFd));
+      pthread_mutex_lock(&pArchive->lock);
+   }
+
+   // a rotation may have moved or dropped the files meanwhile
+   if (pSegment->fileIndex <= pArchive->maxFiles && (isCompressed || 0 <= pSegment->outputFd)) {
+      TextLogger_RotatedFilePath(pArchive->pPath, pArchive->pFilePath, pSegment->fileIndex, isCompressed ? "" : ARCHIVE_FILE_SUFFIX);
+      remove(pArchive->pPath);
+   }
+
+   if (0 <= pSegment->inputFd) {
+      close(pSegment->inputFd);
+   }
+   if (0 <= pSegment->outputFd) {
+      close(pSegment->outputFd);
+   }
+
+   // files are finished oldest first, except when a later one fails early
+   TextLoggerArchiveSegmentType** ppLink = &pArchive->pHead;
+   TextLoggerArchiveSegmentType* pPrevious = NULL;
+   while (*ppLink != pSegment) {
+      pPrevious = *ppLink;
+      ppLink = &(*ppLink)->pNext;
+   }
+   *ppLink = pSegment->pNext;
+   if (pArchive->pTail == pSegment) {
+      pArchive->pTail = pPrevious;
+   }
+   free(pSegment);
+
+   pthread_cond_broadcast(&pArchive->wakeWorker);
+}
+
+/**
+ * @internal
+ *
+ * Thread function compressing the blocks of queued files until stop is
+ * requested and the queue is empty.
+ *
+ * @param [in,out] pArg Pointer to TextLoggerArchiveWorkerType.
+ * @return NULL.
+ */
+static void* TextLogger_ArchiveThread(void* pArg)
+{
+   TextLoggerArchiveWorkerType* pWorker = (TextLoggerArchiveWorkerType*) pArg;
+   TextLoggerArchiveType* pArchive = pWorker->pArchive;
+
+   pthread_mutex_lock(&pArchive->lock);
+   for (;;) {
+      TextLoggerArchiveSegmentType* pSegment = pArchive->pHead;
+      while (NULL != pSegment && pSegment->isOpen && pSegment->nextBlock >= pSegment->blockCount) {
+         pSegment = pSegment->pNext;
+      }
+      if (NULL == pSegment) {
+         if (pArchive->stopRequested && NULL == pArchive->pHead) {
+            break;
+         }
+         pthread_cond_wait(&pArchive->wakeWorker, &pArchive->lock);
+         continue;
+      }
+
+      if (!pSegment->isOpen) {
+         TextLogger_ArchiveOpenSegment(pArchive, pSegment);
+      }
+
+      // no more blocks once the file failed or was dropped, the ones claimed still take their turn
+      if (pSegment->hasFailed || pSegment->fileIndex > pArchive->maxFiles) {
+         pSegment->blockCount = pSegment->nextBlock;
+         if (pSegment->nextWriteBlock == pSegment->blockCount) {
+            TextLogger_ArchiveFinishSegment(pArchive, pSegment);
+         }
+         continue;
+      }
+      if (0 == pSegment->blockCount) {
+         TextLogger_ArchiveFinishSegment(pArchive, pSegment);
+         continue;
+      }
+
+      long int blockNumber = pSegment->nextBlock++;
+      pthread_mutex_unlock(&pArchive->lock);
+
+      // read and compress without the lock, other threads work on the next blocks
+      long int blockOffset = blockNumber * ARCHIVE_BLOCK_SIZE;
+      size_t length = (size_t) ((pSegment->inputSize - blockOffset < ARCHIVE_BLOCK_SIZE) ? pSegment->inputSize - blockOffset : ARCHIVE_BLOCK_SIZE);
+      size_t blockLength = 0;
+      if (TextLogger_ArchiveReadAll(pSegment->inputFd, pWorker->pInput, length, (off_t) blockOffset)) {
+         blockLength = TextLogger_CompressPutBlock(&pWorker->table, pWorker->pInput, length, pWorker->pBlock);
+      }
+
+      // blocks are appended in file order
+      pthread_mutex_lock(&pArchive->lock);
+      while (pSegment->nextWriteBlock != blockNumber) {
+         pthread_cond_wait(&pArchive->blockWritten, &pArchive->lock);
+      }
+      bool isWritten = (0 < blockLength);
+      if (isWritten && !pSegment->hasFailed && pSegment->fileIndex <= pArchive->maxFiles) {
+         pthread_mutex_unlock(&pArchive->lock); // no other thread writes until nextWriteBlock moves
+         isWritten = TextLogger_ArchiveWriteAll(pSegment->outputFd, pWorker->pBlock, blockLength);
+         pthread_mutex_lock(&pArchive->lock);
+      }
+      if (!isWritten) {
+         pSegment->hasFailed = true;
+      }
+      pSegment->nextWriteBlock++;
+      pthread_cond_broadcast(&pArchive->blockWritten);
+      if (pSegment->nextWriteBlock == pSegment->blockCount) {
+         TextLogger_ArchiveFinishSegment(pArchive, pSegment);
+      }
+   }
+   pthread_mutex_unlock(&pArchive->lock);
+
+   return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Queues file.N to be compressed after the files already queued.
+ * Called with lock held, or before the threads are started.
+ *
+ * @param [in,out] pArchive Pointer to background compression.
+ * @param [in] fileIndex N of file.N.
+ */
+static void TextLogger_ArchiveQueueSegment(TextLoggerArchiveType* pArchive, int fileIndex)
+{
+   // without memory the file just stays as it is
+   TextLoggerArchiveSegmentType* pSegment = (TextLoggerArchiveSegmentType*) calloc(1, sizeof(TextLoggerArchiveSegmentType));
+   if (NULL == pSegment) {
+      return;
+   }
+   pSegment->fileIndex = fileIndex;
+   pSegment->inputFd = -1;
+   pSegment->outputFd = -1;
+   if (NULL == pArchive->pTail) {
+      pArchive->pHead = pSegment;
+   } else {
+      pArchive->pTail->pNext = pSegment;
+   }
+   pArchive->pTail = pSegment;
+}
+
+/**
+ * @internal
+ *
+ * Picks up the work of a context that ended before compressing every rotated
+ * file, e.g. killed by a crash: file.N is only removed once file.N.tlz is
+ * complete, so a file.N.tlz next to its file.N is partial and removed, and
+ * every file.N is queued again, oldest first. Called before the threads are started.
+ *
+ * @param [in,out] pArchive Pointer to background compression.
+ */
+static void TextLogger_ArchiveRecover(TextLoggerArchiveType* pArchive)
+{
+   struct stat fileStatus;
+   for (int fileIndex = pArchive->maxFiles; fileIndex >= 1; fileIndex--) {
+      TextLogger_RotatedFilePath(pArchive->pPath, pArchive->pFilePath, fileIndex, "");
+      if (0 != stat(pArchive->pPath, &fileStatus)) {
+         continue;
+      }
+      TextLogger_RotatedFilePath(pArchive->pPath, pArchive->pFilePath, fileIndex, ARCHIVE_FILE_SUFFIX);
+      remove(pArchive->pPath);
+      TextLogger_ArchiveQueueSegment(pArchive, fileIndex);
+   }
+}
+
+/**
+ * @internal
+ *
+ * Stops the threads started so far and frees the background compression.
+ *
+ * @param [in,out] pArchive Pointer to background compression.
+ */
+static void TextLogger_ArchiveFree(TextLoggerArchiveType* pArchive)
+{
+   pthread_mutex_lock(&pArchive->lock);
+   pArchive->stopRequested = true;
+   pthread_cond_broadcast(&pArchive->wakeWorker);
+   pthread_mutex_unlock(&pArchive->lock);
+   for (int index = 0; index < pArchive->threadCount; index++) {
+      pthread_join(pArchive->pWorkers[index].thread, NULL);
+   }
+
+   // files recovered at start are still queued if no thread could be started
+   while (NULL != pArchive->pHead) {
+      TextLoggerArchiveSegmentType* pSegment = pArchive->pHead;
+      pArchive->pHead = pSegment->pNext;
+      free(pSegment);
+   }
+
+   pthread_cond_destroy(&pArchive->blockWritten);
+   pthread_cond_destroy(&pArchive->wakeWorker);
+   pthread_mutex_destroy(&pArchive->lock);
+   if (NULL != pArchive->pWorkers) {
+      for (int index = 0; index < pArchive->threadCount; index++) {
+         free(pArchive->pWorkers[index].pInput);
+         free(pArchive->pWorkers[index].pBlock);
+      }
+      free(pArchive->pWorkers);
+   }
+   free(pArchive->pPath);
+   free(pArchive->pFilePath);
+   free(pArchive);
+}
+
+TextLoggerStatusType TextLogger_ArchiveStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   TextLoggerArchiveType* pArchive = (TextLoggerArchiveType*) calloc(1, sizeof(TextLoggerArchiveType));
+   if (NULL == pArchive) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pthread_mutex_init(&pArchive->lock, NULL);
+   pthread_cond_init(&pArchive->wakeWorker, NULL);
+   pthread_cond_init(&pArchive->blockWritten, NULL);
+   pArchive->maxFiles = pLoggerContext->rotationMaxFiles;
+
+   size_t pathLength = strlen(pLoggerContext->pFilePath);
+   pArchive->pFilePath = (char*) malloc(pathLength + 1);
+   pArchive->pPath = (char*) malloc(pathLength + ROTATED_PATH_SUFFIX_SIZE);
+   pArchive->pWorkers = (TextLoggerArchiveWorkerType*) calloc(pConfig->rotationCompressThreads, sizeof(TextLoggerArchiveWorkerType));
+   if (NULL == pArchive->pFilePath || NULL == pArchive->pPath || NULL == pArchive->pWorkers) {
+      TextLogger_ArchiveFree(pArchive);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   strcpy(pArchive->pFilePath, pLoggerContext->pFilePath);
+   TextLogger_ArchiveRecover(pArchive);
+
+   for (int index = 0; index < pConfig->rotationCompressThreads; index++) {
+      TextLoggerArchiveWorkerType* pWorker = &pArchive->pWorkers[index];
+      pWorker->pArchive = pArchive;
+      pWorker->table.tableBase = 1;
+      pWorker->pInput = (unsigned char*) malloc(ARCHIVE_BLOCK_SIZE);
+      pWorker->pBlock = (unsigned char*) malloc(TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + TEXTLOGGER_LZ_BOUND(ARCHIVE_BLOCK_SIZE));
+      if (NULL == pWorker->pInput || NULL == pWorker->pBlock || 0 != pthread_create(&pWorker->thread, NULL, TextLogger_ArchiveThread, pWorker)) {
+         free(pWorker->pInput);
+         free(pWorker->pBlock);
+         pWorker->pInput = NULL;
+         pWorker->pBlock = NULL;
+         TextLogger_ArchiveFree(pArchive);
+         return TEXTLOGGER_ERR_INVALID_INPUT;
+      }
+      pArchive->threadCount++;
+   }
+
+   pLoggerContext->pArchive = pArchive;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_ArchiveStop(LoggerContextType* pLoggerContext)
+{
+   TextLogger_ArchiveFree(pLoggerContext->pArchive);
+   pLoggerContext->pArchive = NULL;
+}
+
+void TextLogger_ArchiveBeginRotation(LoggerContextType* pLoggerContext)
+{
+   pthread_mutex_lock(&pLoggerContext->pArchive->lock);
+}
+
+void TextLogger_ArchiveEndRotation(LoggerContextType* pLoggerContext)
+{
+   TextLoggerArchiveType* pArchive = pLoggerContext->pArchive;
+   for (TextLoggerArchiveSegmentType* pSegment = pArchive->pHead; NULL != pSegment; pSegment = pSegment->pNext) {
+      pSegment->fileIndex++;
+   }
+
+   TextLogger_ArchiveQueueSegment(pArchive, 1);
+   pthread_cond_broadcast(&pArchive->wakeWorker);
+
+   pthread_mutex_unlock(&pArchive->lock);
+}
+
+#else // _WIN32
+
+TextLoggerStatusType TextLogger_ArchiveStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   (void) pLoggerContext;
+   (void) pConfig;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+void TextLogger_ArchiveStop(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+void TextLogger_ArchiveBeginRotation(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+void TextLogger_ArchiveEndRotation(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+#endif // _WIN32
@@ -0,0 +1,661 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+/* system headers */
+#include <pthread.h>
+#include <stdarg.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+#define ASYNC_IDLE_WAIT_MS       (100) // writer wakes up at least this often even without a signal
+#define ASYNC_FULL_SPIN_COUNT    (64) // yields of a producer finding the queue full before it waits on slotFreed
+#define ASYNC_DROP_SUMMARY_MS    (1000) // least time between two drop summaries, so a queue under pressure does not flood the file
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of one queued log record.
+ *
+ * Slots are laid out back to back in pSlots, each followed by
+ * maxTextSize bytes of message text and one for the null terminator
+ * written by vsnprintf.
+ */
+typedef struct {
+   atomic_size_t sequence; // slot is free for enqueue position N when sequence == N, readable when sequence == N + 1
+   time_t timeStamp;
+   int textLength;
+   LogLevelType logLevel;
+   bool hasCapturedArgs; // pText holds format and raw arguments from TextLogger_CaptureArgs instead of text
+   bool isRecorderDump; // no text: the writer thread writes the flight recorder, see TextLogger_DumpFlightRecorder
+   char pText[];
+} TextLoggerAsyncRecordType;
+
+/**
+ * @brief This is the structure type of the async state of a logger context.
+ *
+ * Records are stored in a bounded multi-producer/single-consumer ring:
+ * producers claim a slot with a CAS on enqueuePos and publish it through
+ * the slot sequence, the writer thread is the only one moving dequeuePos.
+ * When the queue is full, policy decides whether producers wait or records are dropped.
+ */
+struct TextLoggerAsync{
+   unsigned char* pSlots;
+   size_t slotByteSize;
+   size_t capacity; // power of two
+   size_t mask; // capacity - 1
+   int maxTextSize;
+   char* pFormatBuffer; // writer thread formats captured arguments here, maxTextSize + 1 bytes
+
+   atomic_size_t enqueuePos; // next position claimed by producers
+   atomic_size_t dequeuePos; // next position read by the writer thread, read by producers to estimate the queue length
+   atomic_size_t writtenPos; // every record before this position has been written to file
+
+   atomic_int writerStatus; // last error reported by the writer thread
+   TextLoggerFullPolicyType policy;
+   atomic_bool dropOldestRequested; // set by producers finding the queue full with TEXTLOGGER_FULL_DROP_OLDEST
+   atomic_uint_fast64_t pDroppedCounts[LOG_LEVEL_VERBOSE + 1]; // records dropped since the last summary, indexed by LogLevelType
+   int64_t lastDropSummaryMs; // monotonic time of the last drop summary, only used by the writer thread
+   atomic_bool writerIsSleeping;
+   atomic_bool stopRequested;
+   atomic_int waitingProducerCount; // producers waiting on slotFreed, changed under lock
+
+   pthread_t writerThread;
+   pthread_mutex_t lock;
+   pthread_cond_t wakeWriter; // signaled by producers when writer is sleeping
+   pthread_cond_t flushDone; // broadcast by writer after writtenPos moves
+   pthread_cond_t slotFreed; // broadcast by writer after giving a slot back while producers wait
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Returns the slot used by a queue position.
+ *
+ * @param [in] pAsync Pointer to async state.
+ * @param [in] pos Queue position.
+ * @return pointer to the slot.
+ */
+static TextLoggerAsyncRecordType* TextLogger_AsyncSlot(TextLoggerAsyncType* pAsync, size_t pos)
+{
+   return (TextLoggerAsyncRecordType*) (pAsync->pSlots + (pos & pAsync->mask) * pAsync->slotByteSize);
+}
+
+/**
+ * @internal
+ *
+ * Wakes up the producers waiting for a free slot, if any. Called by the
+ * writer thread after giving a slot back.
+ *
+ * @param [in,out] pAsync Pointer to async state.
+ */
+static void TextLogger_AsyncWakeProducers(TextLoggerAsyncType* pAsync)
+{
+   atomic_thread_fence(memory_order_seq_cst); // pairs with the count increment before a producer re-checks its slot
+   if (0 < atomic_load(&pAsync->waitingProducerCount)) {
+      pthread_mutex_lock(&pAsync->lock);
+      pthread_cond_broadcast(&pAsync->slotFreed);
+      pthread_mutex_unlock(&pAsync->lock);
+   }
+}
+
+/**
+ * @internal
+ *
+ * Formats every published record into the buffer, in queue order.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return number of records drained.
+ */
+static size_t TextLogger_AsyncDrain(LoggerContextType* pLoggerContext)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+   size_t dequeuePos = atomic_load_explicit(&pAsync->dequeuePos, memory_order_relaxed);
+   size_t drained = 0;
+
+   while (true) {
+      TextLoggerAsyncRecordType* pRecord = TextLogger_AsyncSlot(pAsync, dequeuePos);
+      size_t sequence = atomic_load_explicit(&pRecord->sequence, memory_order_acquire);
+      if (sequence != dequeuePos + 1) {
+         break; // queue is empty or next record is not published yet
+      }
+
+      // producers are waiting on a full queue: discard the oldest records until it is half empty
+      bool isDropped = false;
+      if (atomic_load_explicit(&pAsync->dropOldestRequested, memory_order_relaxed)) {
+         size_t queuedCount = atomic_load_explicit(&pAsync->enqueuePos, memory_order_relaxed) - dequeuePos;
+         if (queuedCount > pAsync->capacity / 2 && !pRecord->isRecorderDump) {
+            atomic_fetch_add_explicit(&pAsync->pDroppedCounts[pRecord->logLevel], 1, memory_order_relaxed);
+            isDropped = true;
+         } else {
+            atomic_store_explicit(&pAsync->dropOldestRequested, false, memory_order_relaxed);
+         }
+      }
+
+      if (!isDropped && pRecord->isRecorderDump) {
+         TextLoggerStatusType status = TextLogger_WriteFlightRecorder(pLoggerContext);
+         if (TEXTLOGGER_SUCCESS != status) {
+            atomic_store_explicit(&pAsync->writerStatus, status, memory_order_relaxed);
+         }
+      } else if (!isDropped) {
+         const char* pText = pRecord->pText;
+         int textLength = pRecord->textLength;
+         if (pRecord->hasCapturedArgs) {
+            textLength = TextLogger_FormatCapturedArgs(pAsync->pFormatBuffer, pAsync->maxTextSize + 1, pRecord->pText);
+            pText = pAsync->pFormatBuffer;
+         }
+
+         TextLoggerStatusType status = TextLogger_WriteToBuffer(pLoggerContext, pText,
+                                                                textLength + LOG_EXTRA_STR_LENGTH,
+                                                                pRecord->logLevel, pRecord->timeStamp);
+         if (TEXTLOGGER_SUCCESS != status) {
+            atomic_store_explicit(&pAsync->writerStatus, status, memory_order_relaxed);
+         }
+      }
+
+      // give slot back to producers for the next lap
+      atomic_store_explicit(&pRecord->sequence, dequeuePos + pAsync->capacity, memory_order_release);
+      dequeuePos++;
+      atomic_store_explicit(&pAsync->dequeuePos, dequeuePos, memory_order_relaxed);
+      TextLogger_AsyncWakeProducers(pAsync);
+      drained++;
+   }
+
+   return drained;
+}
+
+/**
+ * @internal
+ *
+ * Reads the monotonic clock.
+ *
+ * @return Milliseconds since an arbitrary point.
+ */
+static int64_t TextLogger_AsyncNowMs(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000L;
+}
+
+/**
+ * @internal
+ *
+ * Writes one warning record with the number of records dropped per level since the last one.
+ * Called by the writer thread once the queue ran empty, at most once per ASYNC_DROP_SUMMARY_MS:
+ * drops in between are added up into the next summary.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] isForced Writes the summary even if the last one is recent, used before the writer stops.
+ */
+static void TextLogger_AsyncWriteDropSummary(LoggerContextType* pLoggerContext, bool isForced)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+   int64_t nowMs = TextLogger_AsyncNowMs();
+   if (!isForced && ASYNC_DROP_SUMMARY_MS > nowMs - pAsync->lastDropSummaryMs) {
+      return;
+   }
+
+   uint64_t pDroppedCounts[LOG_LEVEL_VERBOSE + 1];
+   uint64_t totalCount = 0;
+   for (int level = LOG_LEVEL_ERROR; level <= LOG_LEVEL_VERBOSE; level++) {
+      pDroppedCounts[level] = atomic_exchange_explicit(&pAsync->pDroppedCounts[level], 0, memory_order_relaxed);
+      totalCount += pDroppedCounts[level];
+   }
+   if (0 == totalCount) {
+      return;
+   }
+   pAsync->lastDropSummaryMs = nowMs;
+
+   char pSummary[MAX_STR_SIZE];
+   int textLength = snprintf(pSummary, sizeof(pSummary),
+                             "%llu records dropped while the log queue was full (E:%llu W:%llu I:%llu D:%llu V:%llu)",
+                             (unsigned long long) totalCount,
+                             (unsigned long long) pDroppedCounts[LOG_LEVEL_ERROR], (unsigned long long) pDroppedCounts[LOG_LEVEL_WARN],
+                             (unsigned long long) pDroppedCounts[LOG_LEVEL_INFO], (unsigned long long) pDroppedCounts[LOG_LEVEL_DEBUG],
+                             (unsigned long long) pDroppedCounts[LOG_LEVEL_VERBOSE]);
+   if (textLength >= (int) sizeof(pSummary)) {
+      textLength = sizeof(pSummary) - 1;
+   }
+
+   TextLoggerStatusType status = TextLogger_WriteToBuffer(pLoggerContext, pSummary, textLength + LOG_EXTRA_STR_LENGTH, LOG_LEVEL_WARN, time(NULL));
+   if (TEXTLOGGER_SUCCESS != status) {
+      atomic_store_explicit(&pAsync->writerStatus, status, memory_order_relaxed);
+   }
+}
+
+/**
+ * @internal
+ *
+ * Writer thread: drains the queue and writes the buffer to file whenever the queue runs empty.
+ *
+ * @param [in,out] pArg Pointer to logger context.
+ * @return NULL.
+ */
+static void* TextLogger_AsyncWriterThread(void* pArg)
+{
+   LoggerContextType* pLoggerContext = (LoggerContextType*) pArg;
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+
+   while (true) {
+      TextLogger_AsyncDrain(pLoggerContext);
+
+      // queue ran empty: report what was dropped, then write out whatever was batched so far
+      TextLogger_AsyncWriteDropSummary(pLoggerContext, atomic_load(&pAsync->stopRequested));
+      TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         atomic_store_explicit(&pAsync->writerStatus, status, memory_order_relaxed);
+      }
+
+      pthread_mutex_lock(&pAsync->lock);
+      size_t dequeuePos = atomic_load_explicit(&pAsync->dequeuePos, memory_order_relaxed);
+      atomic_store_explicit(&pAsync->writtenPos, dequeuePos, memory_order_release);
+      pthread_cond_broadcast(&pAsync->flushDone);
+
+      // sleep until a producer publishes a record, re-checking the queue after announcing it
+      atomic_store(&pAsync->writerIsSleeping, true);
+      TextLoggerAsyncRecordType* pNext = TextLogger_AsyncSlot(pAsync, dequeuePos);
+      bool queueIsEmpty = (atomic_load(&pNext->sequence) != dequeuePos + 1);
+      if (queueIsEmpty && atomic_load(&pAsync->stopRequested)) {
+         pthread_mutex_unlock(&pAsync->lock);
+         break;
+      }
+      if (queueIsEmpty) {
+         struct timespec deadline;
+         clock_gettime(CLOCK_REALTIME, &deadline);
+         deadline.tv_nsec += ASYNC_IDLE_WAIT_MS * 1000000L;
+         if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+         }
+         pthread_cond_timedwait(&pAsync->wakeWriter, &pAsync->lock, &deadline);
+      }
+      atomic_store(&pAsync->writerIsSleeping, false);
+      pthread_mutex_unlock(&pAsync->lock);
+   }
+
+   return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Wakes up the writer thread if it is sleeping.
+ *
+ * @param [in,out] pAsync Pointer to async state.
+ */
+static void TextLogger_AsyncWakeWriter(TextLoggerAsyncType* pAsync)
+{
+   if (atomic_load(&pAsync->writerIsSleeping)) {
+      pthread_mutex_lock(&pAsync->lock);
+      pthread_cond_signal(&pAsync->wakeWriter);
+      pthread_mutex_unlock(&pAsync->lock);
+   }
+}
+
+TextLoggerStatusType TextLogger_AsyncStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   if (0 >= pConfig->asyncQueueCapacity || 0 >= pConfig->asyncMaxTextSize ||
+       TEXTLOGGER_FULL_BLOCK > pConfig->asyncFullPolicy || TEXTLOGGER_FULL_DROP_BY_LEVEL < pConfig->asyncFullPolicy) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   TextLoggerAsyncType* pAsync = (TextLoggerAsyncType*) malloc(sizeof(TextLoggerAsyncType));
+   if (NULL == pAsync) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // round capacity up to a power of two so positions can be masked
+   pAsync->capacity = 1;
+   while (pAsync->capacity < (size_t) pConfig->asyncQueueCapacity) {
+      pAsync->capacity <<= 1;
+   }
+   pAsync->mask = pAsync->capacity - 1;
+   pAsync->maxTextSize = pConfig->asyncMaxTextSize;
+
+   // keep every slot aligned for its atomic sequence
+   pAsync->slotByteSize = sizeof(TextLoggerAsyncRecordType) + pAsync->maxTextSize + 1;
+   pAsync->slotByteSize = (pAsync->slotByteSize + _Alignof(TextLoggerAsyncRecordType) - 1) & ~(_Alignof(TextLoggerAsyncRecordType) - 1);
+
+   pAsync->pSlots = (unsigned char*) malloc(pAsync->capacity * pAsync->slotByteSize);
+   if (NULL == pAsync->pSlots) {
+      free(pAsync);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pAsync->pFormatBuffer = (char*) malloc(pAsync->maxTextSize + 1);
+   if (NULL == pAsync->pFormatBuffer) {
+      free(pAsync->pSlots);
+      free(pAsync);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   for (size_t pos = 0; pos < pAsync->capacity; pos++) {
+      atomic_init(&TextLogger_AsyncSlot(pAsync, pos)->sequence, pos);
+   }
+
+   atomic_init(&pAsync->enqueuePos, 0);
+   atomic_init(&pAsync->dequeuePos, 0);
+   pAsync->policy = pConfig->asyncFullPolicy;
+   atomic_init(&pAsync->dropOldestRequested, false);
+   for (int level = 0; level <= LOG_LEVEL_VERBOSE; level++) {
+      atomic_init(&pAsync->pDroppedCounts[level], 0);
+   }
+   pAsync->lastDropSummaryMs = TextLogger_AsyncNowMs() - ASYNC_DROP_SUMMARY_MS; // the first summary is not held back
+   atomic_init(&pAsync->writtenPos, 0);
+   atomic_init(&pAsync->writerStatus, TEXTLOGGER_SUCCESS);
+   atomic_init(&pAsync->writerIsSleeping, false);
+   atomic_init(&pAsync->stopRequested, false);
+   pthread_mutex_init(&pAsync->lock, NULL);
+   pthread_cond_init(&pAsync->wakeWriter, NULL);
+   pthread_cond_init(&pAsync->flushDone, NULL);
+   atomic_init(&pAsync->waitingProducerCount, 0);
+   pthread_cond_init(&pAsync->slotFreed, NULL);
+
+   pLoggerContext->pAsync = pAsync;
+   if (0 != pthread_create(&pAsync->writerThread, NULL, TextLogger_AsyncWriterThread, pLoggerContext)) {
+      pthread_cond_destroy(&pAsync->slotFreed);
+      pthread_cond_destroy(&pAsync->flushDone);
+      pthread_cond_destroy(&pAsync->wakeWriter);
+      pthread_mutex_destroy(&pAsync->lock);
+      free(pAsync->pFormatBuffer);
+      free(pAsync->pSlots);
+      free(pAsync);
+      pLoggerContext->pAsync = NULL;
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_AsyncStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+
+   // writer exits only once the queue is empty
+   pthread_mutex_lock(&pAsync->lock);
+   atomic_store(&pAsync->stopRequested, true);
+   pthread_cond_signal(&pAsync->wakeWriter);
+   pthread_mutex_unlock(&pAsync->lock);
+   pthread_join(pAsync->writerThread, NULL);
+
+   pthread_cond_destroy(&pAsync->slotFreed);
+   pthread_cond_destroy(&pAsync->flushDone);
+   pthread_cond_destroy(&pAsync->wakeWriter);
+   pthread_mutex_destroy(&pAsync->lock);
+   free(pAsync->pFormatBuffer);
+   free(pAsync->pSlots);
+   free(pAsync);
+   pLoggerContext->pAsync = NULL;
+}
+
+/**
+ * @internal
+ *
+ * Checks if TEXTLOGGER_FULL_DROP_BY_LEVEL sheds a record given the queue length:
+ * verbose records from half full, debug from three quarters, info when full.
+ * Errors and warnings are never shed.
+ *
+ * @param [in] pAsync Pointer to async state.
+ * @param [in] logLevel Level of the record.
+ * @param [in] queuedCount Number of records in the queue.
+ * @return true if the record is dropped.
+ */
+static bool TextLogger_AsyncShedsLevel(TextLoggerAsyncType* pAsync, LogLevelType logLevel, size_t queuedCount)
+{
+   if (LOG_LEVEL_VERBOSE == logLevel) {
+      return (queuedCount >= pAsync->capacity / 2);
+   } else if (LOG_LEVEL_DEBUG == logLevel) {
+      return (queuedCount >= pAsync->capacity - pAsync->capacity / 4);
+   } else if (LOG_LEVEL_INFO == logLevel) {
+      return (queuedCount >= pAsync->capacity);
+   }
+   return false;
+}
+
+/**
+ * @internal
+ *
+ * Claims the next free slot. While the queue is full, either waits until
+ * the writer frees a slot or gives up, depending on the policy. A waiting
+ * producer yields a few times, then sleeps on slotFreed so a slow disk does
+ * not keep it spinning.
+ *
+ * @param [in,out] pAsync Pointer to async state.
+ * @param [in] logLevel Level of the record.
+ * @param [in] policy What to do while the queue is full, asyncFullPolicy for log records.
+ * @param [out] pPos Queue position of the claimed slot.
+ * @return pointer to the claimed slot.
+ * @return NULL if the record is dropped, it is then counted for the drop summary.
+ */
+static TextLoggerAsyncRecordType* TextLogger_AsyncClaimSlot(TextLoggerAsyncType* pAsync, LogLevelType logLevel, TextLoggerFullPolicyType policy, size_t* pPos)
+{
+   TextLoggerAsyncRecordType* pRecord;
+   // dequeuePos is read first: read after, the writer could already be past a stale enqueuePos
+   size_t dequeuePos = atomic_load(&pAsync->dequeuePos);
+   size_t pos = atomic_load(&pAsync->enqueuePos);
+
+   // shed less important records before the queue is full
+   if (TEXTLOGGER_FULL_DROP_BY_LEVEL == policy &&
+       TextLogger_AsyncShedsLevel(pAsync, logLevel, (pos > dequeuePos) ? pos - dequeuePos : 0)) {
+      atomic_fetch_add_explicit(&pAsync->pDroppedCounts[logLevel], 1, memory_order_relaxed);
+      return NULL;
+   }
+
+   int spinCount = 0;
+   while (true) {
+      pRecord = TextLogger_AsyncSlot(pAsync, pos);
+      size_t sequence = atomic_load_explicit(&pRecord->sequence, memory_order_acquire);
+      intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+      if (0 == diff) {
+         if (atomic_compare_exchange_weak_explicit(&pAsync->enqueuePos, &pos, pos + 1,
+                                                   memory_order_relaxed, memory_order_relaxed)) {
+            break;
+         }
+      } else if (0 > diff) {
+         // queue is full
+         if (TEXTLOGGER_FULL_DROP_NEWEST == policy ||
+             (TEXTLOGGER_FULL_DROP_BY_LEVEL == policy && TextLogger_AsyncShedsLevel(pAsync, logLevel, pAsync->capacity))) {
+            atomic_fetch_add_explicit(&pAsync->pDroppedCounts[logLevel], 1, memory_order_relaxed);
+            return NULL;
+         }
+         if (TEXTLOGGER_FULL_DROP_OLDEST == policy) {
+            atomic_store_explicit(&pAsync->dropOldestRequested, true, memory_order_relaxed);
+         }
+
+         // let the writer catch up, briefly spinning before sleeping until it frees a slot
+         TextLogger_AsyncWakeWriter(pAsync);
+         if (ASYNC_FULL_SPIN_COUNT > spinCount) {
+            spinCount++;
+            sched_yield();
+         } else {
+            pthread_mutex_lock(&pAsync->lock);
+            atomic_fetch_add(&pAsync->waitingProducerCount, 1);
+            if ((intptr_t) atomic_load(&pRecord->sequence) - (intptr_t) pos < 0) {
+               pthread_cond_wait(&pAsync->slotFreed, &pAsync->lock);
+            }
+            atomic_fetch_sub(&pAsync->waitingProducerCount, 1);
+            pthread_mutex_unlock(&pAsync->lock);
+         }
+         pos = atomic_load_explicit(&pAsync->enqueuePos, memory_order_relaxed);
+      } else {
+         pos = atomic_load_explicit(&pAsync->enqueuePos, memory_order_relaxed);
+      }
+   }
+
+   *pPos = pos;
+   return pRecord;
+}
+
+/**
+ * @internal
+ *
+ * Hands a filled slot to the writer thread.
+ *
+ * @param [in,out] pAsync Pointer to async state.
+ * @param [in,out] pRecord Pointer to the claimed slot.
+ * @param [in] pos Queue position of the claimed slot.
+ */
+static void TextLogger_AsyncPublishSlot(TextLoggerAsyncType* pAsync, TextLoggerAsyncRecordType* pRecord, size_t pos)
+{
+   atomic_store_explicit(&pRecord->sequence, pos + 1, memory_order_release);
+
+   atomic_thread_fence(memory_order_seq_cst); // pairs with writerIsSleeping store before the writer re-checks the queue
+   TextLogger_AsyncWakeWriter(pAsync);
+}
+
+/**
+ * @internal
+ *
+ * Checks if an error of the writer thread ends logging for good: a file that
+ * reached maxFileSize stays full unless it is rotated.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @param [in] status Error reported by the writer thread.
+ * @return true if every later record would fail the same way.
+ */
+static bool TextLogger_AsyncWriterStatusIsFinal(const LoggerContextType* pLoggerContext, TextLoggerStatusType status)
+{
+   return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE == status && pLoggerContext->fileSizeIsLimited;
+}
+
+/**
+ * @internal
+ *
+ * Reads the error reported by the writer thread. A final one is kept, any
+ * other is reported to one caller and cleared, later records may well be written.
+ *
+ * @param [in,out] pAsync Pointer to async state.
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if the writer reported no error since the last call.
+ */
+static TextLoggerStatusType TextLogger_AsyncTakeWriterStatus(TextLoggerAsyncType* pAsync, const LoggerContextType* pLoggerContext)
+{
+   TextLoggerStatusType status = atomic_load_explicit(&pAsync->writerStatus, memory_order_relaxed);
+   if (TEXTLOGGER_SUCCESS == status || TextLogger_AsyncWriterStatusIsFinal(pLoggerContext, status)) {
+      return status;
+   }
+   return (TextLoggerStatusType) atomic_exchange_explicit(&pAsync->writerStatus, TEXTLOGGER_SUCCESS, memory_order_relaxed);
+}
+
+TextLoggerStatusType TextLogger_AsyncPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+
+   // once the writer hit the file limit, records would be dropped anyway
+   TextLoggerStatusType writerStatus = atomic_load_explicit(&pAsync->writerStatus, memory_order_relaxed);
+   if (TextLogger_AsyncWriterStatusIsFinal(pLoggerContext, writerStatus)) {
+      return writerStatus;
+   }
+
+   size_t pos;
+   TextLoggerAsyncRecordType* pRecord = TextLogger_AsyncClaimSlot(pAsync, logLevel, pAsync->policy, &pos);
+   if (NULL == pRecord) {
+      return TEXTLOGGER_ERR_QUEUE_FULL;
+   }
+
+   // fill and publish slot
+   if (textLength > pAsync->maxTextSize) {
+      textLength = pAsync->maxTextSize;
+   }
+   memcpy(pRecord->pText, pLogText, textLength);
+   pRecord->textLength = textLength;
+   pRecord->logLevel = logLevel;
+   pRecord->timeStamp = time(NULL);
+   pRecord->hasCapturedArgs = false;
+   pRecord->isRecorderDump = false;
+   TextLogger_AsyncPublishSlot(pAsync, pRecord, pos);
+
+   return TextLogger_AsyncTakeWriterStatus(pAsync, pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_AsyncPushFormat(LoggerContextType* pLoggerContext, const char* pFormat, va_list args, LogLevelType logLevel)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+
+   // once the writer hit the file limit, records would be dropped anyway
+   TextLoggerStatusType writerStatus = atomic_load_explicit(&pAsync->writerStatus, memory_order_relaxed);
+   if (TextLogger_AsyncWriterStatusIsFinal(pLoggerContext, writerStatus)) {
+      return writerStatus;
+   }
+
+   size_t pos;
+   TextLoggerAsyncRecordType* pRecord = TextLogger_AsyncClaimSlot(pAsync, logLevel, pAsync->policy, &pos);
+   if (NULL == pRecord) {
+      return TEXTLOGGER_ERR_QUEUE_FULL;
+   }
+
+   // store format and raw arguments, the writer thread formats them
+   va_list argsCopy;
+   va_copy(argsCopy, args);
+   int capturedLength = TextLogger_CaptureArgs(pRecord->pText, pAsync->maxTextSize, pFormat, argsCopy);
+   va_end(argsCopy);
+
+   if (0 <= capturedLength) {
+      pRecord->textLength = capturedLength;
+      pRecord->hasCapturedArgs = true;
+   } else {
+      // arguments do not fit in the slot or cannot be captured: format right away, truncated like captured ones
+      int textLength = vsnprintf(pRecord->pText, pAsync->maxTextSize + 1, pFormat, args);
+      if (0 > textLength) {
+         textLength = 0;
+      } else if (textLength > pAsync->maxTextSize) {
+         textLength = pAsync->maxTextSize;
+      }
+      pRecord->textLength = textLength;
+      pRecord->hasCapturedArgs = false;
+   }
+   pRecord->isRecorderDump = false;
+   pRecord->logLevel = logLevel;
+   pRecord->timeStamp = time(NULL);
+   TextLogger_AsyncPublishSlot(pAsync, pRecord, pos);
+
+   return TextLogger_AsyncTakeWriterStatus(pAsync, pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_AsyncFlush(LoggerContextType* pLoggerContext)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+   size_t targetPos = atomic_load(&pAsync->enqueuePos);
+
+   pthread_mutex_lock(&pAsync->lock);
+   pthread_cond_signal(&pAsync->wakeWriter);
+   while (atomic_load_explicit(&pAsync->writtenPos, memory_order_acquire) < targetPos) {
+      pthread_cond_wait(&pAsync->flushDone, &pAsync->lock);
+   }
+   pthread_mutex_unlock(&pAsync->lock);
+
+   return TextLogger_AsyncTakeWriterStatus(pAsync, pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_AsyncPushRecorderDump(LoggerContextType* pLoggerContext)
+{
+   TextLoggerAsyncType* pAsync = pLoggerContext->pAsync;
+
+   size_t pos;
+   TextLoggerAsyncRecordType* pRecord = TextLogger_AsyncClaimSlot(pAsync, LOG_LEVEL_ERROR, TEXTLOGGER_FULL_BLOCK, &pos);
+   pRecord->textLength = 0;
+   pRecord->logLevel = LOG_LEVEL_ERROR;
+   pRecord->timeStamp = time(NULL);
+   pRecord->hasCapturedArgs = false;
+   pRecord->isRecorderDump = true;
+   TextLogger_AsyncPublishSlot(pAsync, pRecord, pos);
+
+   return TextLogger_AsyncTakeWriterStatus(pAsync, pLoggerContext);
+}
@@ -0,0 +1,108 @@
+/**
+ * @addtogroup TextLogger
+ * @{
+ */
+
+/**
+ * @brief On-disk layout of TEXTLOGGER_FORMAT_BINARY log files,
+ * shared by the logger and the textlog_decode tool.
+ *
+ * A file starts with TEXTLOGGER_BINARY_MAGIC, followed by records:
+ * 1) one tag byte: log level in the low bits (0 for raw text such as
+ *    the file limit error message), TEXTLOGGER_BINARY_ABSOLUTE_TIME if
+ *    the timestamp is absolute,
+ * 2) timestamp, unless the record is raw text: absolute seconds since
+ *    the epoch as a varint, or the zigzag varint delta to the previous record,
+ * 3) message length as a varint, then the message bytes.
+ * The first record of every flushed buffer carries an absolute timestamp,
+ * so a lost buffer never breaks decoding of the next one.
+ */
+
+#ifndef _TEXT_LOGGER_BINARY_H_
+#define _TEXT_LOGGER_BINARY_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Defines
+ */
+
+#define TEXTLOGGER_BINARY_MAGIC              "TLOGBIN\001"
+#define TEXTLOGGER_BINARY_MAGIC_LENGTH       (8)
+#define TEXTLOGGER_BINARY_LEVEL_MASK         (0x07)
+#define TEXTLOGGER_BINARY_LEVEL_RAW_TEXT     (0x00)
+#define TEXTLOGGER_BINARY_ABSOLUTE_TIME      (0x80)
+#define TEXTLOGGER_BINARY_MAX_VARINT_LENGTH  (10) // 64-bit value
+#define TEXTLOGGER_BINARY_MAX_HEADER_LENGTH  (1 + 2 * TEXTLOGGER_BINARY_MAX_VARINT_LENGTH)
+
+/*
+ * Code
+ */
+
+/**
+ * Writes an unsigned LEB128 varint.
+ *
+ * @param [out] pDest Destination, at least TEXTLOGGER_BINARY_MAX_VARINT_LENGTH bytes.
+ * @param [in] value Value to write.
+ * @return number of bytes written.
+ */
+static inline size_t TextLogger_BinaryPutVarint(unsigned char* pDest, uint64_t value)
+{
+   size_t length = 0;
+   while (0x80 <= value) {
+      pDest[length++] = (unsigned char) (value | 0x80);
+      value >>= 7;
+   }
+   pDest[length++] = (unsigned char) value;
+   return length;
+}
+
+/**
+ * Reads an unsigned LEB128 varint.
+ *
+ * @param [in] pSource Source bytes.
+ * @param [in] sourceLength Number of bytes available in pSource.
+ * @param [out] pValue Value read.
+ * @return number of bytes read, 0 if pSource ends before the varint does.
+ */
+static inline size_t TextLogger_BinaryGetVarint(const unsigned char* pSource, size_t sourceLength, uint64_t* pValue)
+{
+   uint64_t value = 0;
+   for (size_t length = 0; length < sourceLength && length < TEXTLOGGER_BINARY_MAX_VARINT_LENGTH; length++) {
+      value |= (uint64_t) (pSource[length] & 0x7F) << (7 * length);
+      if (0 == (pSource[length] & 0x80)) {
+         *pValue = value;
+         return length + 1;
+      }
+   }
+   return 0;
+}
+
+/**
+ * Maps a signed delta to an unsigned value with small magnitude, e.g. -1 -> 1, 1 -> 2.
+ *
+ * @param [in] value Signed value.
+ * @return zigzag encoded value.
+ */
+static inline uint64_t TextLogger_BinaryZigzagEncode(int64_t value)
+{
+   return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+/**
+ * Reverses TextLogger_BinaryZigzagEncode.
+ *
+ * @param [in] value Zigzag encoded value.
+ * @return signed value.
+ */
+static inline int64_t TextLogger_BinaryZigzagDecode(uint64_t value)
+{
+   return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+#endif // _TEXT_LOGGER_BINARY_H_
+
+/**
+ * @}
+ */
@@ -0,0 +1,335 @@
+#define _POSIX_C_SOURCE 200809L // pwrite, ftruncate, fileno
+
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+/*
+ * A circular log file is CIRCULAR_HEADER_SIZE bytes of header followed by
+ * a data region of fixed size holding text records, oldest overwritten first.
+ * Header fields are little-endian 64-bit values after the magic:
+ * 1) write head: offset in the data region where the next byte goes,
+ * 2) flags: CIRCULAR_FLAG_WRAPPED once the data region has been filled,
+ * 3) size of the data region.
+ */
+#define CIRCULAR_MAGIC           "TLOGCIR\001"
+#define CIRCULAR_MAGIC_LENGTH    (8)
+#define CIRCULAR_FLAG_WRAPPED    (0x01)
+#define READ_CHUNK_SIZE          (64 * 1024)
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Writes a 64-bit value in little-endian byte order.
+ *
+ * @param [out] pDest Destination, 8 bytes.
+ * @param [in] value Value to write.
+ */
+static void TextLogger_CircularPutU64(unsigned char* pDest, uint64_t value)
+{
+   for (int index = 0; index < 8; index++) {
+      pDest[index] = (unsigned char) (value >> (8 * index));
+   }
+}
+
+/**
+ * @internal
+ *
+ * Reads a 64-bit value in little-endian byte order.
+ *
+ * @param [in] pSource Source, 8 bytes.
+ * @return value read.
+ */
+static uint64_t TextLogger_CircularGetU64(const unsigned char* pSource)
+{
+   uint64_t value = 0;
+   for (int index = 0; index < 8; index++) {
+      value |= (uint64_t) pSource[index] << (8 * index);
+   }
+   return value;
+}
+
+/**
+ * @internal
+ *
+ * Writes bytes at a fixed file offset, without moving any append position.
+ *
+ * @param [in] pFile Log file.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @param [in] offset File offset of the first byte.
+ * @return true if every byte was written.
+ */
+static bool TextLogger_CircularWriteAt(FILE* pFile, const char* pData, size_t length, long int offset)
+{
+#ifdef _WIN32
+   if (0 != fseek(pFile, offset, SEEK_SET)) {
+      return false;
+   }
+   return (length == fwrite(pData, sizeof(char), length, pFile));
+#else
+   int fd = fileno(pFile);
+   while (0 < length) {
+      ssize_t bytesWritten = pwrite(fd, pData, length, (off_t) offset);
+      if (0 >= bytesWritten) {
+         return false;
+      }
+      pData += bytesWritten;
+      length -= (size_t) bytesWritten;
+      offset += (long int) bytesWritten;
+   }
+   return true;
+#endif
+}
+
+/**
+ * @internal
+ *
+ * Writes the header with the current write head and wrapped flag.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return true if the header was written.
+ */
+static bool TextLogger_CircularWriteHeader(LoggerContextType* pLoggerContext)
+{
+   unsigned char pHeader[CIRCULAR_HEADER_SIZE] = { 0 };
+   memcpy(pHeader, CIRCULAR_MAGIC, CIRCULAR_MAGIC_LENGTH);
+   TextLogger_CircularPutU64(pHeader + 8, (uint64_t) pLoggerContext->circularWriteHead);
+   TextLogger_CircularPutU64(pHeader + 16, pLoggerContext->circularHasWrapped ? CIRCULAR_FLAG_WRAPPED : 0);
+   TextLogger_CircularPutU64(pHeader + 24, (uint64_t) pLoggerContext->maxFileSize);
+   return TextLogger_CircularWriteAt(pLoggerContext->pLogFile, (const char*) pHeader, CIRCULAR_HEADER_SIZE, 0);
+}
+
+/**
+ * @internal
+ *
+ * Reads and checks the header of a circular log file.
+ *
+ * @param [in] pFile File positioned anywhere.
+ * @param [in] fileSize Size of the file.
+ * @param [out] pWriteHead Write head read from the header.
+ * @param [out] pHasWrapped Wrapped flag read from the header.
+ * @param [out] pDataSize Size of the data region read from the header.
+ * @return true if the header is valid and matches fileSize.
+ */
+static bool TextLogger_CircularReadHeader(FILE* pFile, long int fileSize, long int* pWriteHead, bool* pHasWrapped, long int* pDataSize)
+{
+   unsigned char pHeader[CIRCULAR_HEADER_SIZE];
+   if (0 != fseek(pFile, 0L, SEEK_SET) || CIRCULAR_HEADER_SIZE != fread(pHeader, 1, CIRCULAR_HEADER_SIZE, pFile)) {
+      return false;
+   }
+   if (0 != memcmp(pHeader, CIRCULAR_MAGIC, CIRCULAR_MAGIC_LENGTH)) {
+      return false;
+   }
+
+   uint64_t writeHead = TextLogger_CircularGetU64(pHeader + 8);
+   uint64_t dataSize = TextLogger_CircularGetU64(pHeader + 24);
+   if ((uint64_t) (fileSize - CIRCULAR_HEADER_SIZE) != dataSize || writeHead >= dataSize) {
+      return false;
+   }
+
+   *pWriteHead = (long int) writeHead;
+   *pHasWrapped = (0 != (TextLogger_CircularGetU64(pHeader + 16) & CIRCULAR_FLAG_WRAPPED));
+   *pDataSize = (long int) dataSize;
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Returns the size of a file opened for reading.
+ *
+ * @param [in] pFile File.
+ * @return size of the file, -1 on error.
+ */
+static long int TextLogger_CircularFileSize(FILE* pFile)
+{
+   if (0 != fseek(pFile, 0L, SEEK_END)) {
+      return -1;
+   }
+   return ftell(pFile);
+}
+
+TextLoggerStatusType TextLogger_CircularOpenFile(LoggerContextType* pLoggerContext)
+{
+   // writes go to fixed offsets, so the file must not be in append mode
+   pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "r+b");
+   if (NULL == pLoggerContext->pLogFile) {
+      pLoggerContext->pLogFile = fopen(pLoggerContext->pFilePath, "w+b");
+   }
+   if (NULL == pLoggerContext->pLogFile) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   setvbuf(pLoggerContext->pLogFile, NULL, _IONBF, 0);
+   pLoggerContext->fileOpenTime = time(NULL);
+   pLoggerContext->currFileSize = CIRCULAR_HEADER_SIZE + (long int) pLoggerContext->maxFileSize;
+
+   // carry on from where an earlier run of the same size stopped
+   long int writeHead;
+   bool hasWrapped;
+   long int dataSize;
+   long int fileSize = TextLogger_CircularFileSize(pLoggerContext->pLogFile);
+   if (fileSize == pLoggerContext->currFileSize &&
+       TextLogger_CircularReadHeader(pLoggerContext->pLogFile, fileSize, &writeHead, &hasWrapped, &dataSize)) {
+      pLoggerContext->circularWriteHead = writeHead;
+      pLoggerContext->circularHasWrapped = hasWrapped;
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   // otherwise start over with a preallocated, empty file
+   pLoggerContext->circularWriteHead = 0;
+   pLoggerContext->circularHasWrapped = false;
+#ifdef _WIN32
+   bool isResized = (0 == _chsize_s(_fileno(pLoggerContext->pLogFile), 0) &&
+                     0 == _chsize_s(_fileno(pLoggerContext->pLogFile), pLoggerContext->currFileSize));
+#else
+   bool isResized = (0 == ftruncate(fileno(pLoggerContext->pLogFile), 0) &&
+                     0 == ftruncate(fileno(pLoggerContext->pLogFile), (off_t) pLoggerContext->currFileSize));
+#endif
+   if (!isResized || !TextLogger_CircularWriteHeader(pLoggerContext)) {
+      fclose(pLoggerContext->pLogFile);
+      pLoggerContext->pLogFile = NULL;
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_CircularWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length)
+{
+   long int dataSize = pLoggerContext->maxFileSize;
+
+   // only the most recent dataSize bytes survive a write larger than the file
+   size_t keptLength = ((size_t) dataSize < length) ? (size_t) dataSize : length;
+   pData += length - keptLength;
+   long int endPos = (long int) ((pLoggerContext->circularWriteHead + length) % (size_t) dataSize);
+   long int startPos = (endPos - (long int) keptLength + dataSize) % dataSize;
+
+   // write up to the end of the data region, then the rest from its start
+   size_t firstLength = (size_t) (dataSize - startPos);
+   if (firstLength > keptLength) {
+      firstLength = keptLength;
+   }
+   if (!TextLogger_CircularWriteAt(pLoggerContext->pLogFile, pData, firstLength, CIRCULAR_HEADER_SIZE + startPos)) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   if (firstLength < keptLength &&
+       !TextLogger_CircularWriteAt(pLoggerContext->pLogFile, pData + firstLength, keptLength - firstLength, CIRCULAR_HEADER_SIZE)) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // header is updated after the data, so it never points past unwritten bytes
+   if ((size_t) (dataSize - pLoggerContext->circularWriteHead) <= length) {
+      pLoggerContext->circularHasWrapped = true;
+   }
+   pLoggerContext->circularWriteHead = endPos;
+   if (!TextLogger_CircularWriteHeader(pLoggerContext)) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+/**
+ * @internal
+ *
+ * Copies a range of the data region to the output.
+ *
+ * @param [in] pFile Circular log file.
+ * @param [in] startPos Offset of the range in the data region.
+ * @param [in] endPos Offset of the end of the range in the data region.
+ * @param [in,out] pSkipPartialLine true while the bytes up to the next newline must be dropped.
+ * @param [in,out] pOutput Output stream.
+ * @param [in,out] pChunk Scratch buffer of READ_CHUNK_SIZE bytes.
+ * @return true if the range was copied.
+ */
+static bool TextLogger_CircularCopyRange(FILE* pFile, long int startPos, long int endPos, bool* pSkipPartialLine, FILE* pOutput, char* pChunk)
+{
+   if (0 != fseek(pFile, CIRCULAR_HEADER_SIZE + startPos, SEEK_SET)) {
+      return false;
+   }
+
+   long int remaining = endPos - startPos;
+   while (0 < remaining) {
+      size_t chunkLength = (READ_CHUNK_SIZE < remaining) ? READ_CHUNK_SIZE : (size_t) remaining;
+      if (chunkLength != fread(pChunk, 1, chunkLength, pFile)) {
+         return false;
+      }
+      remaining -= (long int) chunkLength;
+
+      // oldest record was partly overwritten, drop what is left of it
+      size_t skipLength = 0;
+      if (*pSkipPartialLine) {
+         char* pNewLine = (char*) memchr(pChunk, '\n', chunkLength);
+         if (NULL == pNewLine) {
+            continue;
+         }
+         skipLength = (size_t) (pNewLine - pChunk) + 1;
+         *pSkipPartialLine = false;
+      }
+
+      if (chunkLength - skipLength != fwrite(pChunk + skipLength, 1, chunkLength - skipLength, pOutput)) {
+         return false;
+      }
+   }
+
+   return true;
+}
+
+TextLoggerStatusType TextLogger_ReadCircularFile(const char* pFilePath, FILE* pOutput)
+{
+   if (NULL == pFilePath || NULL == pOutput) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   FILE* pFile = fopen(pFilePath, "rb");
+   if (NULL == pFile) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   long int writeHead;
+   bool hasWrapped;
+   long int dataSize;
+   char* pChunk = (char*) malloc(READ_CHUNK_SIZE);
+   if (NULL == pChunk ||
+       !TextLogger_CircularReadHeader(pFile, TextLogger_CircularFileSize(pFile), &writeHead, &hasWrapped, &dataSize)) {
+      free(pChunk);
+      fclose(pFile);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // oldest bytes follow the write head once the file has wrapped
+   bool skipPartialLine = hasWrapped;
+   bool isCopied = true;
+   if (hasWrapped) {
+      isCopied = TextLogger_CircularCopyRange(pFile, writeHead, dataSize, &skipPartialLine, pOutput, pChunk);
+   }
+   if (isCopied) {
+      isCopied = TextLogger_CircularCopyRange(pFile, 0, writeHead, &skipPartialLine, pOutput, pChunk);
+   }
+
+   free(pChunk);
+   fclose(pFile);
+   return isCopied ? TEXTLOGGER_SUCCESS : TEXTLOGGER_ERR_FILE_ERROR;
+}
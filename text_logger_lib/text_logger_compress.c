@@ -0,0 +1,526 @@
+#define _POSIX_C_SOURCE 200809L // fileno, ftruncate
+
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+#include "text_logger_lz.h"
+
+/*
+ * Defines
+ */
+
+#define LZ_LAST_LITERALS         (5) // a block ends with at least this many literals
+#define LZ_MATCH_FIND_LIMIT      (12) // no match starts in the last bytes of a block
+#define LZ_MAX_OFFSET            (65535)
+#define LZ_SKIP_TRIGGER          (6) // step grows by one every 2^6 misses, so incompressible data is skipped fast
+#define LZ_INDEX_MIN_CAPACITY    (64)
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the block compressor of a logger context.
+ *
+ * The index entries of the blocks written to the current file are kept in
+ * memory and written as the index block when the file is closed.
+ */
+struct TextLoggerCompress{
+   TextLoggerLzTableType table;
+   unsigned char* pBlock; // header and data of the last compressed block
+   size_t blockLength;
+   size_t maxBlockLength; // uncompressed bytes per block
+   TextLoggerLzIndexEntryType blockEntry; // index entry of the block in pBlock
+   TextLoggerLzIndexEntryType pendingEntry; // records added since the last block, not in pBlock yet
+   bool pendingHasRecords;
+   int64_t lastTimeStamp; // latest timestamp of the blocks so far, for blocks that start no record
+   TextLoggerLzIndexEntryType* pIndex;
+   int indexCount;
+   int indexCapacity;
+   bool indexIsComplete; // false once an entry could not be stored, the file then gets no index
+   long int firstIndexedOffset;
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Reads four bytes in native byte order, for hashing and comparing only.
+ *
+ * @param [in] pSource Source bytes.
+ * @return value read.
+ */
+static inline uint32_t TextLogger_CompressRead32(const unsigned char* pSource)
+{
+   uint32_t value;
+   memcpy(&value, pSource, sizeof(value));
+   return value;
+}
+
+/**
+ * @internal
+ *
+ * Counts how many bytes two positions have in common.
+ *
+ * @param [in] pAhead Later position.
+ * @param [in] pBehind Earlier position.
+ * @param [in] pLimit Where pAhead must stop.
+ * @return number of equal bytes.
+ */
+static size_t TextLogger_CompressCommonLength(const unsigned char* pAhead, const unsigned char* pBehind, const unsigned char* pLimit)
+{
+   const unsigned char* pStart = pAhead;
+
+   // eight bytes at a time until they differ
+   while (pAhead + sizeof(uint64_t) <= pLimit) {
+      uint64_t ahead;
+      uint64_t behind;
+      memcpy(&ahead, pAhead, sizeof(ahead));
+      memcpy(&behind, pBehind, sizeof(behind));
+      if (ahead != behind) {
+         break;
+      }
+      pAhead += sizeof(uint64_t);
+      pBehind += sizeof(uint64_t);
+   }
+   while (pAhead < pLimit && *pAhead == *pBehind) {
+      pAhead++;
+      pBehind++;
+   }
+
+   return (size_t) (pAhead - pStart);
+}
+
+/**
+ * @internal
+ *
+ * Writes the extra bytes of a literal or match length of 15 or more.
+ *
+ * @param [out] pDest Destination.
+ * @param [in] length Length minus 15.
+ * @return position after the bytes written.
+ */
+static unsigned char* TextLogger_CompressPutLength(unsigned char* pDest, size_t length)
+{
+   while (255 <= length) {
+      *pDest++ = 255;
+      length -= 255;
+   }
+   *pDest++ = (unsigned char) length;
+   return pDest;
+}
+
+/**
+ * @internal
+ *
+ * Writes one sequence: literals, then a match unless matchLength is 0.
+ *
+ * @param [out] pDest Destination.
+ * @param [in] pLiterals Literal bytes.
+ * @param [in] literalLength Number of literal bytes.
+ * @param [in] offset Distance back to the match.
+ * @param [in] matchLength Length of the match, 0 for the last sequence.
+ * @return position after the sequence.
+ */
+static unsigned char* TextLogger_CompressPutSequence(unsigned char* pDest, const unsigned char* pLiterals, size_t literalLength,
+                                                     size_t offset, size_t matchLength)
+{
+   unsigned char* pToken = pDest++;
+   if (15 <= literalLength) {
+      *pToken = 15 << 4;
+      pDest = TextLogger_CompressPutLength(pDest, literalLength - 15);
+   } else {
+      *pToken = (unsigned char) (literalLength << 4);
+   }
+   memcpy(pDest, pLiterals, literalLength);
+   pDest += literalLength;
+
+   if (0 == matchLength) {
+      return pDest;
+   }
+   *pDest++ = (unsigned char) offset;
+   *pDest++ = (unsigned char) (offset >> 8);
+   matchLength -= TEXTLOGGER_LZ_MIN_MATCH;
+   if (15 <= matchLength) {
+      *pToken |= 15;
+      pDest = TextLogger_CompressPutLength(pDest, matchLength - 15);
+   } else {
+      *pToken |= (unsigned char) matchLength;
+   }
+   return pDest;
+}
+
+/**
+ * @internal
+ *
+ * Compresses bytes to the LZ4 block format: greedy, one hash probe per position.
+ *
+ * @param [in,out] pTable Match finder state.
+ * @param [in] pSource Bytes to compress.
+ * @param [in] length Number of bytes, at most TEXTLOGGER_LZ_MAX_BLOCK_SIZE.
+ * @param [out] pDest Destination, TEXTLOGGER_LZ_BOUND(length) bytes.
+ * @return compressed length.
+ */
+static size_t TextLogger_CompressLz(TextLoggerLzTableType* pTable, const unsigned char* pSource, size_t length, unsigned char* pDest)
+{
+   unsigned char* pOut = pDest;
+   size_t anchor = 0; // first byte not written yet
+
+   if (LZ_MATCH_FIND_LIMIT < length) {
+      uint32_t base = pTable->tableBase;
+      size_t matchLimit = length - LZ_MATCH_FIND_LIMIT;
+      const unsigned char* pMatchEnd = pSource + length - LZ_LAST_LITERALS;
+      size_t position = 0;
+      size_t missCount = 0;
+
+      while (position < matchLimit) {
+         uint32_t sequence = TextLogger_CompressRead32(pSource + position);
+         uint32_t hash = (sequence * 2654435761u) >> (32 - TEXTLOGGER_LZ_HASH_LOG);
+         uint32_t candidate = pTable->pTable[hash];
+         pTable->pTable[hash] = base + (uint32_t) position;
+
+         if (candidate < base || base + position - candidate > LZ_MAX_OFFSET ||
+             TextLogger_CompressRead32(pSource + (candidate - base)) != sequence) {
+            position += 1 + (missCount++ >> LZ_SKIP_TRIGGER);
+            continue;
+         }
+
+         // extend the match backwards over literals, then forwards
+         size_t matchPosition = candidate - base;
+         while (position > anchor && matchPosition > 0 && pSource[position - 1] == pSource[matchPosition - 1]) {
+            position--;
+            matchPosition--;
+         }
+         size_t matchLength = TEXTLOGGER_LZ_MIN_MATCH + TextLogger_CompressCommonLength(pSource + position + TEXTLOGGER_LZ_MIN_MATCH,
+                                                                                        pSource + matchPosition + TEXTLOGGER_LZ_MIN_MATCH, pMatchEnd);
+         pOut = TextLogger_CompressPutSequence(pOut, pSource + anchor, position - anchor, position - matchPosition, matchLength);
+         position += matchLength;
+         anchor = position;
+         missCount = 0;
+
+         // so a repeat of the end of this match is found too
+         if (position < matchLimit) {
+            uint32_t previous = TextLogger_CompressRead32(pSource + position - 2);
+            pTable->pTable[(previous * 2654435761u) >> (32 - TEXTLOGGER_LZ_HASH_LOG)] = base + (uint32_t) position - 2;
+         }
+      }
+   }
+
+   pOut = TextLogger_CompressPutSequence(pOut, pSource + anchor, length - anchor, 0, 0);
+
+   // positions of the next block follow this one, the table is cleared long before they wrap
+   pTable->tableBase += (uint32_t) length;
+   if (UINT32_MAX / 2 < pTable->tableBase) {
+      memset(pTable->pTable, 0, sizeof(pTable->pTable));
+      pTable->tableBase = 1;
+   }
+
+   return (size_t) (pOut - pDest);
+}
+
+size_t TextLogger_CompressPutBlock(TextLoggerLzTableType* pTable, const unsigned char* pSource, size_t length, unsigned char* pBlock)
+{
+   unsigned char* pBlockData = pBlock + TEXTLOGGER_LZ_BLOCK_HEADER_SIZE;
+
+   // data that does not shrink is stored as is
+   uint32_t dataLength = (uint32_t) TextLogger_CompressLz(pTable, pSource, length, pBlockData);
+   if (dataLength >= length) {
+      memcpy(pBlockData, pSource, length);
+      dataLength = (uint32_t) length | TEXTLOGGER_LZ_STORED;
+   }
+   TextLogger_LzPut32(pBlock, dataLength);
+   TextLogger_LzPut32(pBlock + 4, (uint32_t) length);
+   TextLogger_LzPut32(pBlock + 8, TextLogger_LzChecksum(pSource, length));
+
+   return TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + (dataLength & TEXTLOGGER_LZ_LENGTH_MASK);
+}
+
+TextLoggerStatusType TextLogger_CompressStart(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCompressType* pCompress = (TextLoggerCompressType*) calloc(1, sizeof(TextLoggerCompressType));
+   if (NULL == pCompress) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pCompress->table.tableBase = 1;
+   pCompress->maxBlockLength = (size_t) pLoggerContext->maxBufferByteSize;
+   pCompress->pBlock = (unsigned char*) malloc(TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + TEXTLOGGER_LZ_BOUND(pCompress->maxBlockLength));
+   if (NULL == pCompress->pBlock) {
+      free(pCompress);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   pLoggerContext->pCompress = pCompress;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_CompressStop(LoggerContextType* pLoggerContext)
+{
+   free(pLoggerContext->pCompress->pIndex);
+   free(pLoggerContext->pCompress->pBlock);
+   free(pLoggerContext->pCompress);
+   pLoggerContext->pCompress = NULL;
+}
+
+/**
+ * @internal
+ *
+ * Loads the entries of the index block at the end of a file, so the index
+ * written at close covers the blocks already in the file too.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] indexOffset File offset of the index block.
+ * @param [in] pHeader Header of the index block.
+ * @return true if the index block is complete and belongs to the blocks before it.
+ */
+static bool TextLogger_CompressLoadIndex(LoggerContextType* pLoggerContext, long int indexOffset, const unsigned char* pHeader)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   size_t dataLength = TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_LENGTH_MASK;
+   if (TextLogger_LzGet32(pHeader + 4) != dataLength || TEXTLOGGER_LZ_INDEX_TRAILER_SIZE > dataLength ||
+       pLoggerContext->currFileSize - indexOffset - TEXTLOGGER_LZ_BLOCK_HEADER_SIZE != (long int) dataLength) {
+      return false;
+   }
+
+   unsigned char* pData = (unsigned char*) malloc(dataLength);
+   if (NULL == pData) {
+      return false;
+   }
+   bool indexIsValid = (dataLength == fread(pData, 1, dataLength, pLoggerContext->pLogFile) &&
+                        TextLogger_LzGet32(pHeader + 8) == TextLogger_LzChecksum(pData, dataLength));
+   unsigned char* pTrailer = pData + dataLength - TEXTLOGGER_LZ_INDEX_TRAILER_SIZE;
+   uint32_t entryCount = indexIsValid ? TextLogger_LzGet32(pTrailer) : 0;
+   indexIsValid = indexIsValid && 0 == memcmp(pTrailer + 12, TEXTLOGGER_LZ_INDEX_MAGIC, TEXTLOGGER_LZ_INDEX_MAGIC_LENGTH) &&
+                  (size_t) entryCount * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE + TEXTLOGGER_LZ_INDEX_TRAILER_SIZE == dataLength;
+
+   // room for the entries of the blocks written next too
+   int capacity = (int) entryCount + LZ_INDEX_MIN_CAPACITY;
+   if (indexIsValid && pCompress->indexCapacity < capacity) {
+      TextLoggerLzIndexEntryType* pIndex = (TextLoggerLzIndexEntryType*) realloc(pCompress->pIndex, capacity * sizeof(TextLoggerLzIndexEntryType));
+      indexIsValid = (NULL != pIndex);
+      if (NULL != pIndex) {
+         pCompress->pIndex = pIndex;
+         pCompress->indexCapacity = capacity;
+      }
+   }
+   if (indexIsValid) {
+      for (uint32_t index = 0; index < entryCount; index++) {
+         TextLogger_LzGetIndexEntry(pData + index * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE, &pCompress->pIndex[index]);
+      }
+      pCompress->indexCount = (int) entryCount;
+      pCompress->firstIndexedOffset = (long int) TextLogger_LzGet64(pTrailer + 4);
+      if (0 < entryCount) {
+         pCompress->lastTimeStamp = pCompress->pIndex[entryCount - 1].lastTimeStamp;
+      }
+   }
+
+   free(pData);
+   return indexIsValid;
+}
+
+TextLoggerStatusType TextLogger_CompressOpenFile(LoggerContextType* pLoggerContext)
+{
+   FILE* pLogFile = pLoggerContext->pLogFile;
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+
+   // index starts over with every file
+   pCompress->indexCount = 0;
+   pCompress->indexIsComplete = true;
+   pCompress->firstIndexedOffset = TEXTLOGGER_LZ_MAGIC_LENGTH;
+   pCompress->lastTimeStamp = 0;
+   pCompress->pendingHasRecords = false;
+
+   // new file
+   if (0 == pLoggerContext->currFileSize) {
+      size_t bytesWritten = fwrite(TEXTLOGGER_LZ_MAGIC, sizeof(char), TEXTLOGGER_LZ_MAGIC_LENGTH, pLogFile);
+      pLoggerContext->currFileSize += bytesWritten;
+      return (TEXTLOGGER_LZ_MAGIC_LENGTH == bytesWritten) ? TEXTLOGGER_SUCCESS : TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // blocks are never appended to a file of another kind
+   char pMagic[TEXTLOGGER_LZ_MAGIC_LENGTH];
+   if (0 != fseek(pLogFile, 0L, SEEK_SET) || TEXTLOGGER_LZ_MAGIC_LENGTH != fread(pMagic, sizeof(char), TEXTLOGGER_LZ_MAGIC_LENGTH, pLogFile) ||
+       0 != memcmp(pMagic, TEXTLOGGER_LZ_MAGIC, TEXTLOGGER_LZ_MAGIC_LENGTH)) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // the index is taken over and rewritten at close, a block cut short by a crash is dropped
+   long int blockOffset = TEXTLOGGER_LZ_MAGIC_LENGTH;
+   bool indexIsLoaded = false;
+   unsigned char pHeader[TEXTLOGGER_LZ_BLOCK_HEADER_SIZE];
+   while (blockOffset < pLoggerContext->currFileSize) {
+      if (0 != fseek(pLogFile, blockOffset, SEEK_SET) || TEXTLOGGER_LZ_BLOCK_HEADER_SIZE != fread(pHeader, 1, TEXTLOGGER_LZ_BLOCK_HEADER_SIZE, pLogFile)) {
+         break;
+      }
+      if (0 != (TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_INDEX)) {
+         indexIsLoaded = TextLogger_CompressLoadIndex(pLoggerContext, blockOffset, pHeader);
+         break;
+      }
+      long int dataLength = (long int) (TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_LENGTH_MASK);
+      if (pLoggerContext->currFileSize - blockOffset - TEXTLOGGER_LZ_BLOCK_HEADER_SIZE < dataLength) {
+         break;
+      }
+      blockOffset += TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + dataLength;
+   }
+   if (!indexIsLoaded) {
+      pCompress->firstIndexedOffset = blockOffset; // blocks left by a crash are not indexed
+   }
+   if (blockOffset < pLoggerContext->currFileSize) {
+      fflush(pLogFile);
+#ifdef _WIN32
+      int result = _chsize(_fileno(pLogFile), blockOffset);
+#else
+      int result = ftruncate(fileno(pLogFile), (off_t) blockOffset);
+#endif
+      if (0 != result) {
+         return TEXTLOGGER_ERR_FILE_ERROR;
+      }
+      pLoggerContext->currFileSize = blockOffset;
+   }
+
+   // append mode writes at the end whatever the position
+   fseek(pLogFile, 0L, SEEK_END);
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_CompressCloseFile(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   if (!pCompress->indexIsComplete) {
+      return TEXTLOGGER_SUCCESS; // read from the start, like a file left by a crash
+   }
+
+   size_t dataLength = (size_t) pCompress->indexCount * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE + TEXTLOGGER_LZ_INDEX_TRAILER_SIZE;
+   unsigned char* pIndexBlock = (unsigned char*) malloc(TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + dataLength);
+   if (NULL == pIndexBlock) {
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   unsigned char* pData = pIndexBlock + TEXTLOGGER_LZ_BLOCK_HEADER_SIZE;
+   for (int index = 0; index < pCompress->indexCount; index++) {
+      TextLogger_LzPutIndexEntry(pData + index * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE, &pCompress->pIndex[index]);
+   }
+   unsigned char* pTrailer = pData + dataLength - TEXTLOGGER_LZ_INDEX_TRAILER_SIZE;
+   TextLogger_LzPut32(pTrailer, (uint32_t) pCompress->indexCount);
+   TextLogger_LzPut64(pTrailer + 4, (uint64_t) pCompress->firstIndexedOffset);
+   memcpy(pTrailer + 12, TEXTLOGGER_LZ_INDEX_MAGIC, TEXTLOGGER_LZ_INDEX_MAGIC_LENGTH);
+   TextLogger_LzPut32(pIndexBlock, (uint32_t) dataLength | TEXTLOGGER_LZ_STORED | TEXTLOGGER_LZ_INDEX);
+   TextLogger_LzPut32(pIndexBlock + 4, (uint32_t) dataLength);
+   TextLogger_LzPut32(pIndexBlock + 8, TextLogger_LzChecksum(pData, dataLength));
+
+   size_t bytesWritten = fwrite(pIndexBlock, sizeof(char), TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + dataLength, pLoggerContext->pLogFile);
+   pLoggerContext->currFileSize += bytesWritten;
+   TextLogger_DurableAddWritten(pLoggerContext, bytesWritten);
+   free(pIndexBlock);
+   pCompress->indexCount = 0;
+
+   return (TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + dataLength == bytesWritten) ? TEXTLOGGER_SUCCESS : TEXTLOGGER_ERR_FILE_ERROR;
+}
+
+void TextLogger_CompressAddRecord(LoggerContextType* pLoggerContext, LogLevelType logLevel, time_t timeStamp)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   TextLoggerLzIndexEntryType* pEntry = &pCompress->pendingEntry;
+
+   if (!pCompress->pendingHasRecords) {
+      memset(pEntry, 0, sizeof(TextLoggerLzIndexEntryType));
+      pEntry->firstTimeStamp = (int64_t) timeStamp;
+      pEntry->lastTimeStamp = (int64_t) timeStamp;
+      pCompress->pendingHasRecords = true;
+   } else if ((int64_t) timeStamp > pEntry->lastTimeStamp) {
+      pEntry->lastTimeStamp = (int64_t) timeStamp;
+   }
+   pEntry->pLevelCounts[logLevel - LOG_LEVEL_ERROR]++;
+}
+
+long int TextLogger_CompressIndexSize(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   if (!pCompress->indexIsComplete) {
+      return 0;
+   }
+   return TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + (long int) (pCompress->indexCount + 1) * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE + TEXTLOGGER_LZ_INDEX_TRAILER_SIZE;
+}
+
+long int TextLogger_CompressBlock(LoggerContextType* pLoggerContext, const char* pData, size_t length)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   pCompress->blockLength = TextLogger_CompressPutBlock(&pCompress->table, (const unsigned char*) pData, length, pCompress->pBlock);
+
+   // records added so far are in this block now
+   if (pCompress->pendingHasRecords) {
+      pCompress->blockEntry = pCompress->pendingEntry;
+      pCompress->pendingHasRecords = false;
+      if (pCompress->blockEntry.lastTimeStamp > pCompress->lastTimeStamp) {
+         pCompress->lastTimeStamp = pCompress->blockEntry.lastTimeStamp;
+      }
+   } else {
+      memset(&pCompress->blockEntry, 0, sizeof(TextLoggerLzIndexEntryType));
+      pCompress->blockEntry.firstTimeStamp = pCompress->lastTimeStamp;
+      pCompress->blockEntry.lastTimeStamp = pCompress->lastTimeStamp;
+   }
+
+   return (long int) pCompress->blockLength;
+}
+
+TextLoggerStatusType TextLogger_CompressWriteBlock(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCompressType* pCompress = pLoggerContext->pCompress;
+   pCompress->blockEntry.blockOffset = (uint64_t) pLoggerContext->currFileSize;
+
+   size_t bytesWritten = fwrite(pCompress->pBlock, sizeof(char), pCompress->blockLength, pLoggerContext->pLogFile);
+   pLoggerContext->currFileSize += bytesWritten;
+   TextLogger_DurableAddWritten(pLoggerContext, bytesWritten);
+   if (bytesWritten != pCompress->blockLength) {
+      // Failed to write all data to the file
+      pCompress->indexIsComplete = false; // the block is torn, entries after it would be off
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // an index that misses a block would skip it
+   if (pCompress->indexIsComplete && pCompress->indexCount == pCompress->indexCapacity) {
+      int capacity = (0 < pCompress->indexCapacity) ? 2 * pCompress->indexCapacity : LZ_INDEX_MIN_CAPACITY;
+      TextLoggerLzIndexEntryType* pIndex = (TextLoggerLzIndexEntryType*) realloc(pCompress->pIndex, capacity * sizeof(TextLoggerLzIndexEntryType));
+      if (NULL == pIndex) {
+         pCompress->indexIsComplete = false;
+         return TEXTLOGGER_SUCCESS;
+      }
+      pCompress->pIndex = pIndex;
+      pCompress->indexCapacity = capacity;
+   }
+   if (pCompress->indexIsComplete) {
+      pCompress->pIndex[pCompress->indexCount++] = pCompress->blockEntry;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_CompressWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length)
+{
+   while (0 < length) {
+      size_t blockLength = (length < pLoggerContext->pCompress->maxBlockLength) ? length : pLoggerContext->pCompress->maxBlockLength;
+      TextLogger_CompressBlock(pLoggerContext, pData, blockLength);
+      TextLoggerStatusType status = TextLogger_CompressWriteBlock(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+      pData += blockLength;
+      length -= blockLength;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
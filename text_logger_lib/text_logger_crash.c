@@ -0,0 +1,304 @@
+#define _XOPEN_SOURCE 700 // sigaction, SA_ONSTACK, dup, fileno
+
+/* system headers */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+#include "text_logger_lz.h"
+
+/*
+ * Defines
+ */
+
+#define CRASH_MAX_CONTEXTS       (64) // contexts with crashDump alive at the same time
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the crash dump state of a logger context.
+ *
+ * It only remembers the context's slot in spCrashSlots: the signal handler
+ * never reads it, so it can be freed while a handler runs on another thread.
+ */
+struct TextLoggerCrash{
+   int slot;
+};
+
+/**
+ * @brief This is the structure type of a registry slot read by the signal handler.
+ *
+ * The signal handler may not allocate, lock or use stdio, so everything it
+ * needs is prepared here: the context and its own descriptor of the log
+ * file, replaced when the file is rotated or reopened.
+ */
+typedef struct {
+   _Atomic(LoggerContextType*) pLoggerContext; // NULL if the slot is free
+   atomic_int fd; // duplicate of the log file descriptor, -1 if none
+} TextLoggerCrashSlotType;
+
+/*
+ * Static
+ */
+
+#ifdef _WIN32
+static const int spCrashSignals[] = { SIGSEGV, SIGILL, SIGFPE, SIGABRT };
+typedef void (*TextLoggerSignalHandlerType)(int);
+static TextLoggerSignalHandlerType spPreviousHandlers[sizeof(spCrashSignals) / sizeof(spCrashSignals[0])];
+#else
+static const int spCrashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+static struct sigaction spPreviousActions[sizeof(spCrashSignals) / sizeof(spCrashSignals[0])];
+#endif
+#define CRASH_SIGNAL_COUNT       ((int) (sizeof(spCrashSignals) / sizeof(spCrashSignals[0])))
+
+static TextLoggerCrashSlotType spCrashSlots[CRASH_MAX_CONTEXTS]; // descriptors set to -1 by TextLogger_CrashInstallHandlers
+static pthread_once_t sCrashHandlerOnce = PTHREAD_ONCE_INIT;
+static atomic_flag sCrashDumpIsTaken = ATOMIC_FLAG_INIT; // set by the first thread that dumps
+static atomic_bool sCrashDumpIsRunning = false; // set while the dump reads the registered contexts
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Closes a duplicated log file descriptor.
+ *
+ * @param [in] fd File descriptor, ignored if negative.
+ */
+static void TextLogger_CrashCloseFd(int fd)
+{
+   if (0 > fd) {
+      return;
+   }
+#ifdef _WIN32
+   _close(fd);
+#else
+   close(fd);
+#endif
+}
+
+/**
+ * @internal
+ *
+ * Waits until a dump running on another thread is done with the registry,
+ * so a descriptor taken out of it can be closed without the dump writing to
+ * whatever file reuses its number next.
+ */
+static void TextLogger_CrashWaitForDump(void)
+{
+   while (atomic_load(&sCrashDumpIsRunning)) {
+      sched_yield();
+   }
+}
+
+/**
+ * @internal
+ *
+ * Writes all bytes to a file descriptor. Async-signal-safe.
+ *
+ * @param [in] fd File descriptor.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes.
+ * @return true if every byte is written.
+ */
+static bool TextLogger_CrashWriteAll(int fd, const unsigned char* pData, size_t length)
+{
+   while (0 < length) {
+#ifdef _WIN32
+      int bytesWritten = _write(fd, pData, (unsigned int) length);
+#else
+      ssize_t bytesWritten = write(fd, pData, length);
+#endif
+      if (0 > bytesWritten && EINTR == errno) {
+         continue;
+      }
+      if (0 >= bytesWritten) {
+         return false;
+      }
+      pData += bytesWritten;
+      length -= (size_t) bytesWritten;
+   }
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Writes the pending buffer of one context to its file. Async-signal-safe.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @param [in] fd Duplicate of its log file descriptor, taken from its slot.
+ */
+static void TextLogger_CrashDumpContext(const LoggerContextType* pLoggerContext, int fd)
+{
+   int length = pLoggerContext->currBytePos; // the crash may have hit in the middle of a record, the buffer still ends at a complete one
+   if (0 > fd || 0 >= length || pLoggerContext->maxBufferByteSize < length) {
+      return;
+   }
+   const unsigned char* pData = (const unsigned char*) pLoggerContext->pTextBuffer;
+
+   // a compressed file only holds blocks: store the buffer as it is, the checksum needs no allocation
+   if (NULL != pLoggerContext->pCompress) {
+      unsigned char pHeader[TEXTLOGGER_LZ_BLOCK_HEADER_SIZE];
+      TextLogger_LzPut32(pHeader, TEXTLOGGER_LZ_STORED | (uint32_t) length);
+      TextLogger_LzPut32(pHeader + 4, (uint32_t) length);
+      TextLogger_LzPut32(pHeader + 8, TextLogger_LzChecksum(pData, (size_t) length));
+      if (!TextLogger_CrashWriteAll(fd, pHeader, sizeof(pHeader))) {
+         return;
+      }
+   }
+
+   if (TextLogger_CrashWriteAll(fd, pData, (size_t) length) && TEXTLOGGER_DURABILITY_NONE != pLoggerContext->durability) {
+#ifdef _WIN32
+      _commit(fd);
+#else
+      fsync(fd);
+#endif
+   }
+}
+
+/**
+ * @internal
+ *
+ * Handler of fatal signals: dumps every registered context, then hands the
+ * signal to the handler installed before, or to the default action.
+ *
+ * @param [in] signalNumber Signal being handled.
+ */
+static void TextLogger_CrashHandler(int signalNumber)
+{
+   int savedErrno = errno;
+   TextLogger_DumpCrashBuffers();
+   errno = savedErrno;
+
+   for (int i = 0; i < CRASH_SIGNAL_COUNT; i++) {
+      if (spCrashSignals[i] != signalNumber) {
+         continue;
+      }
+      // the signal is blocked until this handler returns, so the raised one reaches the restored action right after
+#ifdef _WIN32
+      signal(signalNumber, spPreviousHandlers[i]);
+#else
+      sigaction(signalNumber, &spPreviousActions[i], NULL);
+#endif
+      raise(signalNumber);
+      return;
+   }
+}
+
+/**
+ * @internal
+ *
+ * Empties the registry and installs TextLogger_CrashHandler for every fatal
+ * signal, once per process.
+ */
+static void TextLogger_CrashInstallHandlers(void)
+{
+   for (int i = 0; i < CRASH_MAX_CONTEXTS; i++) {
+      atomic_store(&spCrashSlots[i].fd, -1);
+   }
+
+   for (int i = 0; i < CRASH_SIGNAL_COUNT; i++) {
+#ifdef _WIN32
+      spPreviousHandlers[i] = signal(spCrashSignals[i], TextLogger_CrashHandler);
+#else
+      struct sigaction action;
+      action.sa_handler = TextLogger_CrashHandler;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_ONSTACK; // a stack overflow is only handled on an alternate stack set up by the application
+      sigaction(spCrashSignals[i], &action, &spPreviousActions[i]);
+#endif
+   }
+}
+
+void TextLogger_DumpCrashBuffers(void)
+{
+   // a second thread crashing at the same time, or a crash inside the dump, must not write twice
+   if (atomic_flag_test_and_set(&sCrashDumpIsTaken)) {
+      return;
+   }
+
+   // set before the slots are read: TextLogger_CrashStop and TextLogger_CrashSetFile take a descriptor out of its slot
+   // before checking this, so either they wait for the dump or the dump only finds what replaced the descriptor
+   atomic_store(&sCrashDumpIsRunning, true);
+   for (int i = 0; i < CRASH_MAX_CONTEXTS; i++) {
+      LoggerContextType* pLoggerContext = atomic_load(&spCrashSlots[i].pLoggerContext);
+      if (NULL != pLoggerContext) {
+         TextLogger_CrashDumpContext(pLoggerContext, atomic_load(&spCrashSlots[i].fd));
+      }
+   }
+   atomic_store(&sCrashDumpIsRunning, false);
+}
+
+TextLoggerStatusType TextLogger_CrashStart(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCrashType* pCrash = (TextLoggerCrashType*) malloc(sizeof(TextLoggerCrashType));
+   if (NULL == pCrash) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pthread_once(&sCrashHandlerOnce, TextLogger_CrashInstallHandlers);
+
+   // take a free slot, the handler only ever reads them; a free slot's descriptor is -1
+   for (pCrash->slot = 0; pCrash->slot < CRASH_MAX_CONTEXTS; pCrash->slot++) {
+      LoggerContextType* pExpected = NULL;
+      if (atomic_compare_exchange_strong(&spCrashSlots[pCrash->slot].pLoggerContext, &pExpected, pLoggerContext)) {
+         break;
+      }
+   }
+   if (CRASH_MAX_CONTEXTS == pCrash->slot) {
+      free(pCrash);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pLoggerContext->pCrash = pCrash;
+   TextLogger_CrashSetFile(pLoggerContext);
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_CrashStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerCrashType* pCrash = pLoggerContext->pCrash;
+   TextLoggerCrashSlotType* pSlot = &spCrashSlots[pCrash->slot];
+
+   // handlers stay installed for the other contexts, an empty registry makes them a no-op;
+   // the descriptor is taken out before the slot is freed, which may be taken again right after
+   int fd = atomic_exchange(&pSlot->fd, -1);
+   atomic_store(&pSlot->pLoggerContext, NULL);
+   free(pCrash);
+   pLoggerContext->pCrash = NULL;
+
+   // a dump running on another thread may still use the descriptor and the context, which the caller frees next
+   TextLogger_CrashWaitForDump();
+   TextLogger_CrashCloseFd(fd);
+}
+
+void TextLogger_CrashSetFile(LoggerContextType* pLoggerContext)
+{
+   // swapped before the old one is closed, so the handler finds either the previous or the new file,
+   // and the previous one is only closed once a running dump is done with it
+#ifdef _WIN32
+   int fd = _dup(_fileno(pLoggerContext->pLogFile));
+#else
+   int fd = dup(fileno(pLoggerContext->pLogFile));
+#endif
+   int previousFd = atomic_exchange(&spCrashSlots[pLoggerContext->pCrash->slot].fd, fd);
+   TextLogger_CrashWaitForDump();
+   TextLogger_CrashCloseFd(previousFd);
+}
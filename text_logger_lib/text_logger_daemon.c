@@ -0,0 +1,778 @@
+#define _POSIX_C_SOURCE 200809L // kill, nanosleep, clock_gettime, ftruncate, O_CLOEXEC
+
+/* system headers */
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+#ifndef _WIN32
+
+/*
+ * Defines
+ */
+
+#define DAEMON_RING_MAGIC        "TLOGRNG\001"
+#define DAEMON_RING_MAGIC_LENGTH (8)
+#define DAEMON_RING_SUFFIX       ".ring" // rings are renamed to this once their header is complete
+#define DAEMON_LOCK_NAME         "daemon.lock" // held by the daemon serving the directory
+#define DAEMON_PATH_SIZE         (4096)
+#define DAEMON_ERR_MSG_SIZE      (256)
+#define DAEMON_ENTRY_ALIGN       (16)
+#define DAEMON_CLIENT_WAIT_US    (100) // between checks of a client waiting for room, a flush or a sync
+#define DAEMON_MIN_IDLE_WAIT_US  (50) // first sleep of the daemon once every ring is empty, doubled up to DAEMON_MAX_IDLE_WAIT_US
+#define DAEMON_MAX_IDLE_WAIT_US  (5000)
+#define DAEMON_SCAN_INTERVAL_MS  (100) // between looks for new rings and for clients that exited
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the header of a ring file, mapped by
+ * one client context and the daemon.
+ *
+ * The options are written once by the client before the file gets its
+ * DAEMON_RING_SUFFIX name; the daemon creates its own context from them.
+ * writePos is only moved by the client, every other position by the daemon,
+ * each on a cache line of its own. Positions count bytes since the ring was
+ * created, entries (see TextLoggerDaemonEntryType) follow the header.
+ */
+typedef struct {
+   char pMagic[DAEMON_RING_MAGIC_LENGTH];
+   int32_t clientPid;
+   uint32_t capacity; // bytes of entries after the header, a multiple of DAEMON_ENTRY_ALIGN
+   int32_t logLevel;
+   int32_t maxBufferByteSize;
+   int32_t maxFileSize;
+   int32_t format;
+   int32_t rotationMaxFiles;
+   int32_t rotationIntervalSec;
+   int32_t circularFile;
+   int32_t durability;
+   int32_t groupCommitWindowMs;
+   int32_t compression;
+   int32_t rotationCompressThreads;
+   int32_t flightRecorderSize;
+   char pFilePath[DAEMON_PATH_SIZE]; // absolute, the daemon runs in another directory
+   char pErrMsg[DAEMON_ERR_MSG_SIZE];
+
+   _Alignas(64) atomic_uint_fast64_t writePos; // end of the entries logged by the client
+   _Alignas(64) atomic_uint_fast64_t readPos; // end of the entries taken by the daemon
+   atomic_uint_fast64_t writtenPos; // entries before it are written to the log file
+   atomic_uint_fast64_t syncedPos; // entries before it are synced to storage
+   atomic_int daemonStatus; // status of the last write or sync of the daemon's context
+   atomic_int daemonPid; // 0 while no daemon serves the ring
+   _Alignas(64) atomic_uint_fast64_t syncRequestedPos; // entries before it are to be synced, moved by TextLogger_Sync of the client
+   atomic_bool isClosed; // set by the client once it logs nothing more
+} TextLoggerDaemonRingType;
+
+/**
+ * @brief This is the structure type of the header of one entry in a ring,
+ * followed by textLength bytes of the message. Entries start at multiples
+ * of DAEMON_ENTRY_ALIGN; one that would not fit before the end of the ring
+ * goes to its start, after a padding entry.
+ */
+typedef struct {
+   int64_t timeStamp;
+   int32_t textLength; // -1 for padding up to the end of the ring
+   int32_t logLevel;
+} TextLoggerDaemonEntryType;
+
+/**
+ * @brief This is the structure type of the client end of a ring.
+ *
+ * The ring has a single producer: threads of the process take turns with
+ * lock, which only guards the copy of one message into shared memory.
+ */
+struct TextLoggerDaemon{
+   TextLoggerDaemonRingType* pRing; // start of the mapping
+   unsigned char* pEntries;
+   size_t mappedSize;
+   int maxTextLength; // longer messages are cut, so one always fits in an empty ring
+   int lockFd; // DAEMON_LOCK_NAME of the directory, to find a daemon that did not attach the ring yet
+   TextLoggerFullPolicyType fullPolicy;
+   pthread_mutex_t lock;
+};
+
+/**
+ * @brief This is the structure type of a ring served by the daemon.
+ */
+typedef struct {
+   char* pRingPath;
+   TextLoggerDaemonRingType* pRing;
+   unsigned char* pEntries;
+   size_t mappedSize;
+   uint64_t readPos; // copy of pRing->readPos, only moved by the daemon
+   LoggerContextType* pLoggerContext; // NULL if it could not be created, the entries are then dropped
+} TextLoggerDaemonClientType;
+
+/*
+ * Static
+ */
+
+static atomic_int sDaemonRingCount; // rings created by this process, for unique names
+static volatile sig_atomic_t sDaemonStopIsRequested; // set by TextLogger_StopDaemon
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Sleeps for a number of microseconds.
+ *
+ * @param [in] microseconds Time to sleep.
+ */
+static void TextLogger_DaemonSleep(long int microseconds)
+{
+   struct timespec duration;
+   duration.tv_sec = microseconds / 1000000L;
+   duration.tv_nsec = (microseconds % 1000000L) * 1000L;
+   nanosleep(&duration, NULL);
+}
+
+/**
+ * @internal
+ *
+ * Rounds the size of an entry up to the alignment of the next one.
+ *
+ * @param [in] textLength Length of the message.
+ * @return Bytes taken in the ring.
+ */
+static uint64_t TextLogger_DaemonEntrySize(int textLength)
+{
+   return (sizeof(TextLoggerDaemonEntryType) + (uint64_t) textLength + DAEMON_ENTRY_ALIGN - 1) & ~(uint64_t) (DAEMON_ENTRY_ALIGN - 1);
+}
+
+/**
+ * @internal
+ *
+ * Checks if a daemon process serves the ring, or will at its next scan.
+ *
+ * @param [in] pDaemon Client end of the ring.
+ * @return true if the daemon that attached last is still running, or another one holds the directory.
+ */
+static bool TextLogger_DaemonIsServing(const TextLoggerDaemonType* pDaemon)
+{
+   int daemonPid = atomic_load(&pDaemon->pRing->daemonPid);
+   if (0 != daemonPid && (0 == kill((pid_t) daemonPid, 0) || EPERM == errno)) {
+      return true;
+   }
+
+   struct flock lock;
+   memset(&lock, 0, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+   return 0 == fcntl(pDaemon->lockFd, F_GETLK, &lock) && F_UNLCK != lock.l_type;
+}
+
+/**
+ * @internal
+ *
+ * Waits until the daemon moved a position of the ring past target.
+ *
+ * @param [in] pDaemon Client end of the ring.
+ * @param [in] pPos Position moved by the daemon.
+ * @param [in] target Position to wait for.
+ * @return Status of the daemon's context.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if no daemon serves the ring.
+ */
+static TextLoggerStatusType TextLogger_DaemonWaitFor(const TextLoggerDaemonType* pDaemon, atomic_uint_fast64_t* pPos, uint64_t target)
+{
+   TextLoggerDaemonRingType* pRing = pDaemon->pRing;
+   while (target > atomic_load_explicit(pPos, memory_order_acquire)) {
+      // the daemon may have moved the position right before it exited
+      if (!TextLogger_DaemonIsServing(pDaemon)) {
+         if (target > atomic_load_explicit(pPos, memory_order_acquire)) {
+            return TEXTLOGGER_ERR_FILE_ERROR;
+         }
+         break;
+      }
+      TextLogger_DaemonSleep(DAEMON_CLIENT_WAIT_US);
+   }
+   return (TextLoggerStatusType) atomic_load(&pRing->daemonStatus);
+}
+
+/**
+ * @internal
+ *
+ * Copies a string into a fixed size field of the ring header.
+ *
+ * @param [out] pDest Field of the header.
+ * @param [in] destSize Size of the field.
+ * @param [in] pPrefix Directory to put in front of pText, NULL for none.
+ * @param [in] pText String to copy.
+ * @return true if the string fits with its null terminator.
+ */
+static bool TextLogger_DaemonCopyString(char* pDest, size_t destSize, const char* pPrefix, const char* pText)
+{
+   int length = (NULL == pPrefix) ? snprintf(pDest, destSize, "%s", pText) : snprintf(pDest, destSize, "%s/%s", pPrefix, pText);
+   return 0 <= length && (size_t) length < destSize;
+}
+
+/**
+ * @internal
+ *
+ * Writes the options of the context the daemon creates for the ring.
+ *
+ * @param [out] pRing Ring header, zeroed.
+ * @param [in] pConfig Options of the client context.
+ * @return true if the paths and the error message fit in the header.
+ */
+static bool TextLogger_DaemonWriteOptions(TextLoggerDaemonRingType* pRing, const TextLoggerConfigType* pConfig)
+{
+   pRing->clientPid = (int32_t) getpid();
+   pRing->logLevel = pConfig->logLevel;
+   pRing->maxBufferByteSize = pConfig->maxBufferByteSize;
+   pRing->maxFileSize = pConfig->maxFileSize;
+   pRing->format = (int32_t) pConfig->format;
+   pRing->rotationMaxFiles = pConfig->rotationMaxFiles;
+   pRing->rotationIntervalSec = pConfig->rotationIntervalSec;
+   pRing->circularFile = pConfig->circularFile ? 1 : 0;
+   pRing->durability = (int32_t) pConfig->durability;
+   pRing->groupCommitWindowMs = pConfig->groupCommitWindowMs;
+   pRing->compression = (int32_t) pConfig->compression;
+   pRing->rotationCompressThreads = pConfig->rotationCompressThreads;
+   pRing->flightRecorderSize = pConfig->flightRecorderSize;
+   if (!TextLogger_DaemonCopyString(pRing->pErrMsg, sizeof(pRing->pErrMsg), NULL, pConfig->pErrMsg)) {
+      return false;
+   }
+   if ('/' == pConfig->pFilePath[0]) {
+      return TextLogger_DaemonCopyString(pRing->pFilePath, sizeof(pRing->pFilePath), NULL, pConfig->pFilePath);
+   }
+   char pWorkDir[DAEMON_PATH_SIZE];
+   return NULL != getcwd(pWorkDir, sizeof(pWorkDir)) &&
+          TextLogger_DaemonCopyString(pRing->pFilePath, sizeof(pRing->pFilePath), pWorkDir, pConfig->pFilePath);
+}
+
+TextLoggerStatusType TextLogger_DaemonStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   TextLoggerDaemonType* pDaemon = (TextLoggerDaemonType*) malloc(sizeof(TextLoggerDaemonType));
+   if (NULL == pDaemon) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   uint32_t capacity = (uint32_t) pConfig->daemonRingSize & ~(uint32_t) (DAEMON_ENTRY_ALIGN - 1);
+   pDaemon->maxTextLength = (int) (capacity / 2 - sizeof(TextLoggerDaemonEntryType));
+   pDaemon->fullPolicy = pConfig->asyncFullPolicy;
+   pDaemon->mappedSize = sizeof(TextLoggerDaemonRingType) + capacity;
+
+   // the daemon only looks at files with the ring suffix, given once the header is complete
+   int ringNumber = atomic_fetch_add(&sDaemonRingCount, 1);
+   char pTempPath[DAEMON_PATH_SIZE];
+   char pRingPath[DAEMON_PATH_SIZE];
+   char pLockPath[DAEMON_PATH_SIZE];
+   int lockLength = snprintf(pLockPath, sizeof(pLockPath), "%s/" DAEMON_LOCK_NAME, pConfig->pDaemonDirPath);
+   int tempLength = snprintf(pTempPath, sizeof(pTempPath), "%s/%ld-%d.tmp", pConfig->pDaemonDirPath, (long int) getpid(), ringNumber);
+   int ringLength = snprintf(pRingPath, sizeof(pRingPath), "%s/%ld-%d" DAEMON_RING_SUFFIX, pConfig->pDaemonDirPath, (long int) getpid(), ringNumber);
+   if (0 > lockLength || (size_t) lockLength >= sizeof(pLockPath) || 0 > tempLength || (size_t) tempLength >= sizeof(pTempPath) ||
+       0 > ringLength || (size_t) ringLength >= sizeof(pRingPath)) {
+      free(pDaemon);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // the lock file is only tested, whichever of the client and the daemon comes first creates it
+   pDaemon->lockFd = open(pLockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+   if (0 > pDaemon->lockFd) {
+      free(pDaemon);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // records of the process are only readable by its user and the daemon running as it
+   int fd = open(pTempPath, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+   if (0 > fd) {
+      close(pDaemon->lockFd);
+      free(pDaemon);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   void* pMapping = MAP_FAILED;
+   if (0 == ftruncate(fd, (off_t) pDaemon->mappedSize)) {
+      pMapping = mmap(NULL, pDaemon->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   }
+   close(fd);
+   if (MAP_FAILED == pMapping) {
+      unlink(pTempPath);
+      close(pDaemon->lockFd);
+      free(pDaemon);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pDaemon->pRing = (TextLoggerDaemonRingType*) pMapping;
+   pDaemon->pEntries = (unsigned char*) pMapping + sizeof(TextLoggerDaemonRingType);
+
+   // a new file reads as zeros, so every position and the daemon's status start at 0
+   pDaemon->pRing->capacity = capacity;
+   if (!TextLogger_DaemonWriteOptions(pDaemon->pRing, pConfig) || 0 != pthread_mutex_init(&pDaemon->lock, NULL)) {
+      munmap(pMapping, pDaemon->mappedSize);
+      unlink(pTempPath);
+      close(pDaemon->lockFd);
+      free(pDaemon);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   memcpy(pDaemon->pRing->pMagic, DAEMON_RING_MAGIC, DAEMON_RING_MAGIC_LENGTH);
+   if (0 != rename(pTempPath, pRingPath)) {
+      pthread_mutex_destroy(&pDaemon->lock);
+      munmap(pMapping, pDaemon->mappedSize);
+      unlink(pTempPath);
+      close(pDaemon->lockFd);
+      free(pDaemon);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   pLoggerContext->pDaemon = pDaemon;
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_DaemonStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDaemonType* pDaemon = pLoggerContext->pDaemon;
+
+   // without a daemon the records stay in the ring file until one starts
+   TextLoggerStatusType status = TextLogger_DaemonFlush(pLoggerContext);
+   atomic_store_explicit(&pDaemon->pRing->isClosed, true, memory_order_release);
+
+   munmap(pDaemon->pRing, pDaemon->mappedSize);
+   close(pDaemon->lockFd);
+   pthread_mutex_destroy(&pDaemon->lock);
+   free(pDaemon);
+   pLoggerContext->pDaemon = NULL;
+   return status;
+}
+
+TextLoggerStatusType TextLogger_DaemonPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel)
+{
+   TextLoggerDaemonType* pDaemon = pLoggerContext->pDaemon;
+   TextLoggerDaemonRingType* pRing = pDaemon->pRing;
+   if (pDaemon->maxTextLength < textLength) {
+      textLength = pDaemon->maxTextLength;
+   }
+   uint64_t entrySize = TextLogger_DaemonEntrySize(textLength);
+   time_t timeStamp = time(NULL);
+
+   pthread_mutex_lock(&pDaemon->lock);
+   uint64_t writePos = atomic_load_explicit(&pRing->writePos, memory_order_relaxed);
+   uint64_t offset = writePos % pRing->capacity;
+   uint64_t padding = (pRing->capacity - offset < entrySize) ? pRing->capacity - offset : 0;
+   while (pRing->capacity - (writePos - atomic_load_explicit(&pRing->readPos, memory_order_acquire)) < padding + entrySize) {
+      // records are only kept waiting while a daemon makes room
+      if (TEXTLOGGER_FULL_DROP_NEWEST == pDaemon->fullPolicy || !TextLogger_DaemonIsServing(pDaemon)) {
+         pthread_mutex_unlock(&pDaemon->lock);
+         return TEXTLOGGER_ERR_QUEUE_FULL;
+      }
+      TextLogger_DaemonSleep(DAEMON_CLIENT_WAIT_US);
+   }
+
+   if (0 < padding) {
+      TextLoggerDaemonEntryType* pPadding = (TextLoggerDaemonEntryType*) (pDaemon->pEntries + offset);
+      pPadding->textLength = -1;
+      offset = 0;
+   }
+   TextLoggerDaemonEntryType* pEntry = (TextLoggerDaemonEntryType*) (pDaemon->pEntries + offset);
+   pEntry->timeStamp = (int64_t) timeStamp;
+   pEntry->textLength = textLength;
+   pEntry->logLevel = (int32_t) logLevel;
+   memcpy(pEntry + 1, pLogText, (size_t) textLength);
+   atomic_store_explicit(&pRing->writePos, writePos + padding + entrySize, memory_order_release);
+   pthread_mutex_unlock(&pDaemon->lock);
+
+   return (TextLoggerStatusType) atomic_load(&pRing->daemonStatus);
+}
+
+TextLoggerStatusType TextLogger_DaemonFlush(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDaemonRingType* pRing = pLoggerContext->pDaemon->pRing;
+   uint64_t target = atomic_load_explicit(&pRing->writePos, memory_order_relaxed);
+   return TextLogger_DaemonWaitFor(pLoggerContext->pDaemon, &pRing->writtenPos, target);
+}
+
+TextLoggerStatusType TextLogger_DaemonSync(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDaemonRingType* pRing = pLoggerContext->pDaemon->pRing;
+   uint64_t target = atomic_load_explicit(&pRing->writePos, memory_order_relaxed);
+
+   // a request of another thread for more records covers this one
+   uint64_t requestedPos = atomic_load(&pRing->syncRequestedPos);
+   while (requestedPos < target && !atomic_compare_exchange_weak(&pRing->syncRequestedPos, &requestedPos, target)) {
+   }
+   return TextLogger_DaemonWaitFor(pLoggerContext->pDaemon, &pRing->syncedPos, target);
+}
+
+/**
+ * @internal
+ *
+ * Maps a ring file found in the daemon's directory and creates the context
+ * writing its records from the options in its header.
+ *
+ * @param [in] pDirPath Directory served by the daemon.
+ * @param [in] pName Name of the ring file in pDirPath.
+ * @return Served ring, NULL if the file is not a complete ring or allocation fails.
+ */
+static TextLoggerDaemonClientType* TextLogger_DaemonAttach(const char* pDirPath, const char* pName)
+{
+   TextLoggerDaemonClientType* pClient = (TextLoggerDaemonClientType*) malloc(sizeof(TextLoggerDaemonClientType));
+   if (NULL == pClient) {
+      return NULL;
+   }
+   pClient->pRingPath = (char*) malloc(strlen(pDirPath) + 1 + strlen(pName) + 1);
+   if (NULL == pClient->pRingPath) {
+      free(pClient);
+      return NULL;
+   }
+   sprintf(pClient->pRingPath, "%s/%s", pDirPath, pName);
+
+   int fd = open(pClient->pRingPath, O_RDWR | O_CLOEXEC);
+   struct stat fileStatus;
+   if (0 > fd || 0 != fstat(fd, &fileStatus) || (off_t) sizeof(TextLoggerDaemonRingType) >= fileStatus.st_size) {
+      if (0 <= fd) {
+         close(fd);
+      }
+      free(pClient->pRingPath);
+      free(pClient);
+      return NULL;
+   }
+   pClient->mappedSize = (size_t) fileStatus.st_size;
+   void* pMapping = mmap(NULL, pClient->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if (MAP_FAILED == pMapping) {
+      free(pClient->pRingPath);
+      free(pClient);
+      return NULL;
+   }
+   pClient->pRing = (TextLoggerDaemonRingType*) pMapping;
+   pClient->pEntries = (unsigned char*) pMapping + sizeof(TextLoggerDaemonRingType);
+   uint32_t capacity = pClient->pRing->capacity;
+   if (0 != memcmp(pClient->pRing->pMagic, DAEMON_RING_MAGIC, DAEMON_RING_MAGIC_LENGTH) || 0 != capacity % DAEMON_ENTRY_ALIGN ||
+       sizeof(TextLoggerDaemonRingType) + capacity != pClient->mappedSize) {
+      munmap(pMapping, pClient->mappedSize);
+      free(pClient->pRingPath);
+      free(pClient);
+      return NULL;
+   }
+
+   // the header is the client's memory: the strings are copied and terminated before use
+   char pFilePath[DAEMON_PATH_SIZE];
+   char pErrMsg[DAEMON_ERR_MSG_SIZE];
+   memcpy(pFilePath, pClient->pRing->pFilePath, sizeof(pFilePath));
+   memcpy(pErrMsg, pClient->pRing->pErrMsg, sizeof(pErrMsg));
+   pFilePath[sizeof(pFilePath) - 1] = '\0';
+   pErrMsg[sizeof(pErrMsg) - 1] = '\0';
+   TextLoggerConfigType config;
+   TextLogger_InitConfig(&config, pFilePath, pErrMsg, pClient->pRing->logLevel, pClient->pRing->maxBufferByteSize, pClient->pRing->maxFileSize);
+   config.format = (TextLoggerFormatType) pClient->pRing->format;
+   config.rotationMaxFiles = pClient->pRing->rotationMaxFiles;
+   config.rotationIntervalSec = pClient->pRing->rotationIntervalSec;
+   config.circularFile = (0 != pClient->pRing->circularFile);
+   config.durability = (TextLoggerDurabilityType) pClient->pRing->durability;
+   config.groupCommitWindowMs = pClient->pRing->groupCommitWindowMs;
+   config.compression = (TextLoggerCompressionType) pClient->pRing->compression;
+   config.rotationCompressThreads = pClient->pRing->rotationCompressThreads;
+   config.flightRecorderSize = pClient->pRing->flightRecorderSize;
+   pClient->pLoggerContext = TextLogger_CreateWithConfig(&config);
+   if (NULL == pClient->pLoggerContext) {
+      atomic_store(&pClient->pRing->daemonStatus, TEXTLOGGER_ERR_FILE_ERROR);
+   }
+
+   // a previous daemon may have taken part of the entries already
+   pClient->readPos = atomic_load_explicit(&pClient->pRing->readPos, memory_order_relaxed);
+   atomic_store(&pClient->pRing->daemonPid, (int) getpid());
+   return pClient;
+}
+
+/**
+ * @internal
+ *
+ * Writes the entries logged to a ring so far, then flushes or syncs the
+ * context as its client waits for.
+ *
+ * @param [in,out] pClient Served ring.
+ * @return true if entries were taken from the ring.
+ */
+static bool TextLogger_DaemonDrain(TextLoggerDaemonClientType* pClient)
+{
+   TextLoggerDaemonRingType* pRing = pClient->pRing;
+   uint64_t capacity = pRing->capacity;
+   uint64_t writePos = atomic_load_explicit(&pRing->writePos, memory_order_acquire);
+   bool entriesAreTaken = (pClient->readPos != writePos);
+
+   TextLoggerStatusType status = (NULL == pClient->pLoggerContext) ? TEXTLOGGER_ERR_FILE_ERROR : TEXTLOGGER_SUCCESS;
+   if (capacity < writePos - pClient->readPos) {
+      pClient->readPos = writePos; // positions from a broken client, nothing in between can be trusted
+      status = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   while (pClient->readPos != writePos) {
+      uint64_t offset = pClient->readPos % capacity;
+      TextLoggerDaemonEntryType entry;
+      memcpy(&entry, pClient->pEntries + offset, sizeof(entry));
+      if (0 > entry.textLength) {
+         pClient->readPos += capacity - offset;
+      } else if ((uint64_t) entry.textLength > capacity - offset - sizeof(entry) ||
+                 LOG_LEVEL_ERROR > entry.logLevel || LOG_LEVEL_VERBOSE < entry.logLevel) {
+         pClient->readPos = writePos;
+         status = TEXTLOGGER_ERR_FILE_ERROR;
+      } else {
+         if (NULL != pClient->pLoggerContext) {
+            TextLoggerStatusType writeStatus = TextLogger_WriteToBuffer(pClient->pLoggerContext, (const char*) (pClient->pEntries + offset + sizeof(entry)),
+                                                                        entry.textLength + LOG_EXTRA_STR_LENGTH, (LogLevelType) entry.logLevel, (time_t) entry.timeStamp);
+            if (TEXTLOGGER_SUCCESS == status) {
+               status = writeStatus;
+            }
+         }
+         pClient->readPos += TextLogger_DaemonEntrySize(entry.textLength);
+      }
+      // room is given back entry by entry, the client may be waiting for it
+      atomic_store_explicit(&pRing->readPos, pClient->readPos, memory_order_release);
+   }
+
+   // like the async writer, the buffer is flushed whenever the ring runs empty
+   if (entriesAreTaken) {
+      if (NULL != pClient->pLoggerContext) {
+         TextLoggerStatusType flushStatus = TextLogger_FlushTextToFileStream(pClient->pLoggerContext);
+         if (TEXTLOGGER_SUCCESS == status) {
+            status = flushStatus;
+         }
+      }
+      atomic_store(&pRing->daemonStatus, (int) status);
+      atomic_store_explicit(&pRing->writtenPos, pClient->readPos, memory_order_release);
+   }
+
+   uint64_t syncRequestedPos = atomic_load(&pRing->syncRequestedPos);
+   if (syncRequestedPos > atomic_load_explicit(&pRing->syncedPos, memory_order_relaxed) && syncRequestedPos <= pClient->readPos) {
+      status = (NULL == pClient->pLoggerContext) ? TEXTLOGGER_ERR_FILE_ERROR : TextLogger_Sync(pClient->pLoggerContext);
+      atomic_store(&pRing->daemonStatus, (int) status);
+      atomic_store_explicit(&pRing->syncedPos, pClient->readPos, memory_order_release);
+   }
+   return entriesAreTaken;
+}
+
+/**
+ * @internal
+ *
+ * Writes what is left in a ring and stops serving it.
+ *
+ * @param [in,out] pClient Served ring, freed.
+ * @param [in] ringIsDone true if the client is gone, the ring file is then removed.
+ */
+static void TextLogger_DaemonDetach(TextLoggerDaemonClientType* pClient, bool ringIsDone)
+{
+   TextLogger_DaemonDrain(pClient);
+   if (NULL != pClient->pLoggerContext) {
+      TextLogger_Destroy(pClient->pLoggerContext);
+   }
+
+   // a client still running sees no daemon until the next one attaches
+   int daemonPid = (int) getpid();
+   atomic_compare_exchange_strong(&pClient->pRing->daemonPid, &daemonPid, 0);
+   if (ringIsDone) {
+      unlink(pClient->pRingPath);
+   }
+   munmap(pClient->pRing, pClient->mappedSize);
+   free(pClient->pRingPath);
+   free(pClient);
+}
+
+/**
+ * @internal
+ *
+ * Reads the monotonic clock.
+ *
+ * @return Milliseconds since an arbitrary point.
+ */
+static int64_t TextLogger_DaemonNowMs(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000L;
+}
+
+/**
+ * @internal
+ *
+ * Attaches the rings created in the directory since the last scan, and
+ * detaches the ones whose client closed them or exited.
+ *
+ * @param [in] pDirPath Directory served by the daemon.
+ * @param [in,out] pppClients Served rings, grown as needed.
+ * @param [in,out] pClientCount Number of served rings.
+ * @param [in,out] pClientCapacity Number of rings pppClients has room for.
+ */
+static void TextLogger_DaemonScan(const char* pDirPath, TextLoggerDaemonClientType*** pppClients, size_t* pClientCount, size_t* pClientCapacity)
+{
+   // the client's flag is read before the last entries, so none logged before it is left behind
+   for (size_t i = 0; i < *pClientCount;) {
+      TextLoggerDaemonRingType* pRing = (*pppClients)[i]->pRing;
+      if (atomic_load_explicit(&pRing->isClosed, memory_order_acquire) || (0 != kill((pid_t) pRing->clientPid, 0) && ESRCH == errno)) {
+         TextLogger_DaemonDetach((*pppClients)[i], true);
+         (*pppClients)[i] = (*pppClients)[--(*pClientCount)];
+      } else {
+         i++;
+      }
+   }
+
+   DIR* pDir = opendir(pDirPath);
+   if (NULL == pDir) {
+      return;
+   }
+   size_t suffixLength = strlen(DAEMON_RING_SUFFIX);
+   struct dirent* pEntry;
+   while (NULL != (pEntry = readdir(pDir))) {
+      size_t nameLength = strlen(pEntry->d_name);
+      if (suffixLength >= nameLength || 0 != strcmp(pEntry->d_name + nameLength - suffixLength, DAEMON_RING_SUFFIX)) {
+         continue;
+      }
+      bool ringIsServed = false;
+      for (size_t i = 0; i < *pClientCount && !ringIsServed; i++) {
+         const char* pServedName = strrchr((*pppClients)[i]->pRingPath, '/') + 1;
+         ringIsServed = (0 == strcmp(pServedName, pEntry->d_name));
+      }
+      if (ringIsServed) {
+         continue;
+      }
+      if (*pClientCount == *pClientCapacity) {
+         size_t newCapacity = (0 == *pClientCapacity) ? 16 : 2 * *pClientCapacity;
+         TextLoggerDaemonClientType** ppClients = (TextLoggerDaemonClientType**) realloc(*pppClients, newCapacity * sizeof(TextLoggerDaemonClientType*));
+         if (NULL == ppClients) {
+            break;
+         }
+         *pppClients = ppClients;
+         *pClientCapacity = newCapacity;
+      }
+      TextLoggerDaemonClientType* pClient = TextLogger_DaemonAttach(pDirPath, pEntry->d_name);
+      if (NULL != pClient) {
+         (*pppClients)[(*pClientCount)++] = pClient;
+      }
+   }
+   closedir(pDir);
+}
+
+TextLoggerStatusType TextLogger_RunDaemon(const char* pDirPath)
+{
+   if (NULL == pDirPath) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // every ring has a single consumer: a second daemon on the directory is refused
+   char pLockPath[DAEMON_PATH_SIZE];
+   int lockLength = snprintf(pLockPath, sizeof(pLockPath), "%s/" DAEMON_LOCK_NAME, pDirPath);
+   if (0 > lockLength || (size_t) lockLength >= sizeof(pLockPath)) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   int lockFd = open(pLockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+   if (0 > lockFd) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   struct flock lock;
+   memset(&lock, 0, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+   if (-1 == fcntl(lockFd, F_SETLK, &lock)) {
+      close(lockFd);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   TextLoggerDaemonClientType** ppClients = NULL;
+   size_t clientCount = 0;
+   size_t clientCapacity = 0;
+   int64_t lastScanMs = 0;
+   long int idleWaitUs = DAEMON_MIN_IDLE_WAIT_US;
+   while (!sDaemonStopIsRequested) {
+      int64_t nowMs = TextLogger_DaemonNowMs();
+      if (0 == lastScanMs || DAEMON_SCAN_INTERVAL_MS <= nowMs - lastScanMs) {
+         TextLogger_DaemonScan(pDirPath, &ppClients, &clientCount, &clientCapacity);
+         lastScanMs = nowMs;
+      }
+
+      bool entriesAreTaken = false;
+      for (size_t i = 0; i < clientCount; i++) {
+         if (TextLogger_DaemonDrain(ppClients[i])) {
+            entriesAreTaken = true;
+         }
+      }
+
+      // polled, so clients never make a system call to log; the wait grows while every ring stays empty
+      if (entriesAreTaken) {
+         idleWaitUs = DAEMON_MIN_IDLE_WAIT_US;
+      } else {
+         TextLogger_DaemonSleep(idleWaitUs);
+         idleWaitUs = (DAEMON_MAX_IDLE_WAIT_US < 2 * idleWaitUs) ? DAEMON_MAX_IDLE_WAIT_US : 2 * idleWaitUs;
+      }
+   }
+
+   // rings of running clients are kept for the next daemon
+   for (size_t i = 0; i < clientCount; i++) {
+      TextLogger_DaemonDetach(ppClients[i], atomic_load_explicit(&ppClients[i]->pRing->isClosed, memory_order_acquire));
+   }
+   free(ppClients);
+   close(lockFd);
+   sDaemonStopIsRequested = 0;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_StopDaemon(void)
+{
+   sDaemonStopIsRequested = 1;
+}
+
+#else
+
+TextLoggerStatusType TextLogger_DaemonStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   (void) pLoggerContext;
+   (void) pConfig;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_DaemonStop(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_DaemonPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel)
+{
+   (void) pLoggerContext;
+   (void) pLogText;
+   (void) textLength;
+   (void) logLevel;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_DaemonFlush(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_DaemonSync(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_RunDaemon(const char* pDirPath)
+{
+   (void) pDirPath;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+void TextLogger_StopDaemon(void)
+{
+}
+
+#endif // _WIN32
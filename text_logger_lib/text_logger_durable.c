@@ -0,0 +1,245 @@
+#define _POSIX_C_SOURCE 200809L // fdatasync, fileno, clock_gettime
+
+/* system headers */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the durability state of a logger context.
+ *
+ * Keeps its own descriptor of the log file so it can sync from any thread
+ * while the file is rotated or reopened. writtenByteCount counts every byte
+ * handed to the file, syncedByteCount how many of them are known to be durable.
+ */
+struct TextLoggerDurable{
+   TextLoggerDurabilityType durability;
+   int groupCommitWindowMs;
+   int fd; // duplicate of the log file descriptor, -1 if none
+   atomic_uint_fast64_t writtenByteCount;
+   uint64_t syncedByteCount;
+   TextLoggerStatusType syncStatus; // last sync error
+   bool stopRequested;
+
+   pthread_t syncThread; // only in TEXTLOGGER_DURABILITY_GROUP_COMMIT
+   pthread_mutex_t lock;
+   pthread_cond_t syncDone; // broadcast when syncedByteCount moves
+   pthread_cond_t wakeSyncer; // signaled to stop the sync thread
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Makes everything written to a file descriptor durable.
+ *
+ * @param [in] fd File descriptor.
+ * @return true if successful.
+ */
+static bool TextLogger_DurableSyncFd(int fd)
+{
+#if defined(_WIN32)
+   return (0 == _commit(fd));
+#elif defined(__APPLE__)
+   return (0 == fsync(fd)); // no fdatasync
+#else
+   return (0 == fdatasync(fd));
+#endif
+}
+
+/**
+ * @internal
+ *
+ * Syncs the log file and publishes how many bytes are now durable.
+ * @pre lock is held.
+ *
+ * @param [in,out] pDurable Pointer to durability state.
+ */
+static void TextLogger_DurableSyncLocked(TextLoggerDurableType* pDurable)
+{
+   // bytes counted before the sync are covered by it
+   uint64_t writtenByteCount = atomic_load(&pDurable->writtenByteCount);
+   if (writtenByteCount == pDurable->syncedByteCount) {
+      return;
+   }
+   if (0 > pDurable->fd || !TextLogger_DurableSyncFd(pDurable->fd)) {
+      pDurable->syncStatus = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pDurable->syncedByteCount = writtenByteCount;
+   pthread_cond_broadcast(&pDurable->syncDone);
+}
+
+/**
+ * @internal
+ *
+ * Sync thread: one sync per group commit window covers every record written during it.
+ *
+ * @param [in,out] pArg Pointer to durability state.
+ * @return NULL.
+ */
+static void* TextLogger_DurableSyncThread(void* pArg)
+{
+   TextLoggerDurableType* pDurable = (TextLoggerDurableType*) pArg;
+
+   pthread_mutex_lock(&pDurable->lock);
+   while (!pDurable->stopRequested) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec += pDurable->groupCommitWindowMs / 1000;
+      deadline.tv_nsec += (pDurable->groupCommitWindowMs % 1000) * 1000000L;
+      if (deadline.tv_nsec >= 1000000000L) {
+         deadline.tv_sec += 1;
+         deadline.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&pDurable->wakeSyncer, &pDurable->lock, &deadline);
+      TextLogger_DurableSyncLocked(pDurable);
+   }
+   pthread_mutex_unlock(&pDurable->lock);
+
+   return NULL;
+}
+
+TextLoggerStatusType TextLogger_DurableStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   if (TEXTLOGGER_DURABILITY_NONE > pConfig->durability || TEXTLOGGER_DURABILITY_GROUP_COMMIT < pConfig->durability ||
+       (TEXTLOGGER_DURABILITY_GROUP_COMMIT == pConfig->durability && 0 >= pConfig->groupCommitWindowMs)) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   TextLoggerDurableType* pDurable = (TextLoggerDurableType*) malloc(sizeof(TextLoggerDurableType));
+   if (NULL == pDurable) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pDurable->durability = pConfig->durability;
+   pDurable->groupCommitWindowMs = pConfig->groupCommitWindowMs;
+   pDurable->fd = -1;
+   atomic_init(&pDurable->writtenByteCount, 0);
+   pDurable->syncedByteCount = 0;
+   pDurable->syncStatus = TEXTLOGGER_SUCCESS;
+   pDurable->stopRequested = false;
+   pthread_mutex_init(&pDurable->lock, NULL);
+   pthread_cond_init(&pDurable->syncDone, NULL);
+   pthread_cond_init(&pDurable->wakeSyncer, NULL);
+
+   if (TEXTLOGGER_DURABILITY_GROUP_COMMIT == pDurable->durability &&
+       0 != pthread_create(&pDurable->syncThread, NULL, TextLogger_DurableSyncThread, pDurable)) {
+      pthread_cond_destroy(&pDurable->wakeSyncer);
+      pthread_cond_destroy(&pDurable->syncDone);
+      pthread_mutex_destroy(&pDurable->lock);
+      free(pDurable);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   pLoggerContext->pDurable = pDurable;
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_DurableStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDurableType* pDurable = pLoggerContext->pDurable;
+
+   if (TEXTLOGGER_DURABILITY_GROUP_COMMIT == pDurable->durability) {
+      pthread_mutex_lock(&pDurable->lock);
+      pDurable->stopRequested = true;
+      pthread_cond_signal(&pDurable->wakeSyncer);
+      pthread_mutex_unlock(&pDurable->lock);
+      pthread_join(pDurable->syncThread, NULL);
+   }
+
+   // last records of a durable log are synced too
+   pthread_mutex_lock(&pDurable->lock);
+   if (TEXTLOGGER_DURABILITY_NONE != pDurable->durability) {
+      TextLogger_DurableSyncLocked(pDurable);
+   }
+   TextLoggerStatusType status = pDurable->syncStatus;
+   pthread_mutex_unlock(&pDurable->lock);
+   if (0 <= pDurable->fd) {
+#ifdef _WIN32
+      _close(pDurable->fd);
+#else
+      close(pDurable->fd);
+#endif
+   }
+
+   pthread_cond_destroy(&pDurable->wakeSyncer);
+   pthread_cond_destroy(&pDurable->syncDone);
+   pthread_mutex_destroy(&pDurable->lock);
+   free(pDurable);
+   pLoggerContext->pDurable = NULL;
+
+   return status;
+}
+
+void TextLogger_DurableSetFile(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDurableType* pDurable = pLoggerContext->pDurable;
+
+   pthread_mutex_lock(&pDurable->lock);
+
+   // the previous file is finished: make it durable before letting go of it
+   if (0 <= pDurable->fd) {
+      if (TEXTLOGGER_DURABILITY_NONE != pDurable->durability) {
+         TextLogger_DurableSyncLocked(pDurable);
+      }
+#ifdef _WIN32
+      _close(pDurable->fd);
+#else
+      close(pDurable->fd);
+#endif
+   }
+
+#ifdef _WIN32
+   pDurable->fd = _dup(_fileno(pLoggerContext->pLogFile));
+#else
+   pDurable->fd = dup(fileno(pLoggerContext->pLogFile));
+#endif
+   pDurable->syncedByteCount = atomic_load(&pDurable->writtenByteCount);
+   pthread_cond_broadcast(&pDurable->syncDone);
+
+   pthread_mutex_unlock(&pDurable->lock);
+}
+
+void TextLogger_DurableAddWritten(LoggerContextType* pLoggerContext, size_t length)
+{
+   atomic_fetch_add_explicit(&pLoggerContext->pDurable->writtenByteCount, length, memory_order_relaxed);
+}
+
+TextLoggerStatusType TextLogger_DurableSync(LoggerContextType* pLoggerContext)
+{
+   TextLoggerDurableType* pDurable = pLoggerContext->pDurable;
+
+   pthread_mutex_lock(&pDurable->lock);
+   if (TEXTLOGGER_DURABILITY_GROUP_COMMIT == pDurable->durability) {
+      // the next group commit covers everything written so far
+      uint64_t targetByteCount = atomic_load(&pDurable->writtenByteCount);
+      while (pDurable->syncedByteCount < targetByteCount) {
+         pthread_cond_wait(&pDurable->syncDone, &pDurable->lock);
+      }
+   } else {
+      TextLogger_DurableSyncLocked(pDurable);
+   }
+   TextLoggerStatusType status = pDurable->syncStatus;
+   pthread_mutex_unlock(&pDurable->lock);
+
+   return status;
+}
@@ -0,0 +1,426 @@
+#define _POSIX_C_SOURCE 200809L // pwrite, O_CLOEXEC
+
+/* system headers */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the flush thread state of a logger context.
+ *
+ * The context fills one of bufferCount buffers while the flush thread writes
+ * the ones handed to it, oldest first. Buffer N of the sequence is
+ * ppBuffers[N % bufferCount]; submittedCount buffers have been handed over
+ * and writtenCount of them written, both only change under lock.
+ */
+struct TextLoggerFlusher{
+   char** ppBuffers;
+   int* pLengths; // bytes to write in each handed over buffer
+   int bufferCount;
+   uint64_t submittedCount;
+   uint64_t writtenCount;
+   TextLoggerStatusType writeStatus; // last error of the flush thread, reported on the next submit or wait
+   bool stopRequested;
+
+   // TEXTLOGGER_BACKEND_IO_URING: buffers are written at their own offset, several at once
+   TextLoggerWriteBackendType backend;
+   int fd; // log file opened without append mode, only used by the io_uring backend
+   TextLoggerUringType* pUring; // NULL falls back to pwrite
+   long int* pOffsets; // file offset of each handed over buffer
+   bool* pIsWritten; // buffers of the batch that completed, touched by the flush thread only
+   uint64_t issuedCount; // handed to the backend, between writtenCount and submittedCount
+
+   pthread_t flushThread;
+   pthread_mutex_t lock;
+   pthread_cond_t bufferSubmitted; // signaled when submittedCount moves or stop is requested
+   pthread_cond_t bufferWritten; // broadcast when writtenCount moves
+};
+
+/**
+ * @brief This is the structure type of the buffers the flush thread passed to the io_uring backend at once.
+ */
+typedef struct {
+   LoggerContextType* pLoggerContext;
+   int fd;
+   TextLoggerStatusType status; // first error of the batch
+} TextLoggerFlushBatchType;
+
+/*
+ * Code
+ */
+
+#ifndef _WIN32
+
+/**
+ * @internal
+ *
+ * Opens the log file for writes at explicit offsets: pwrite ignores the offset in append mode.
+ *
+ * @param [in] pFilePath Full file path.
+ * @return file descriptor, or -1 if the file cannot be opened.
+ */
+static int TextLogger_FlusherOpenFile(const char* pFilePath)
+{
+   return open(pFilePath, O_WRONLY | O_CLOEXEC);
+}
+
+/**
+ * @internal
+ *
+ * Writes every byte at a file offset, resuming after short writes.
+ *
+ * @param [in] fd File descriptor.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @param [in] offset File offset of the first byte.
+ * @return true if successful.
+ */
+static bool TextLogger_FlusherWriteAt(int fd, const char* pData, size_t length, long int offset)
+{
+   while (0 < length) {
+      ssize_t bytesWritten = pwrite(fd, pData, length, (off_t) offset);
+      if (0 > bytesWritten && EINTR == errno) {
+         continue;
+      }
+      if (0 >= bytesWritten) {
+         return false;
+      }
+      pData += bytesWritten;
+      length -= (size_t) bytesWritten;
+      offset += (long int) bytesWritten;
+   }
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Completion of one buffer write: finishes short writes with pwrite and marks the buffer written.
+ *
+ * @param [in,out] pArg Pointer to TextLoggerFlushBatchType.
+ * @param [in] userData Sequence number of the buffer.
+ * @param [in] result Bytes written or negative errno.
+ */
+static void TextLogger_FlusherCompleteWrite(void* pArg, uint64_t userData, int result)
+{
+   TextLoggerFlushBatchType* pBatch = (TextLoggerFlushBatchType*) pArg;
+   TextLoggerFlusherType* pFlusher = pBatch->pLoggerContext->pFlusher;
+   int index = (int) (userData % (uint64_t) pFlusher->bufferCount);
+   int length = pFlusher->pLengths[index];
+
+   if (0 > result || (result < length && !TextLogger_FlusherWriteAt(pBatch->fd, pFlusher->ppBuffers[index] + result,
+                                                                    length - result, pFlusher->pOffsets[index] + result))) {
+      pBatch->status = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   TextLogger_DurableAddWritten(pBatch->pLoggerContext, length);
+   pFlusher->pIsWritten[index] = true;
+}
+
+/**
+ * @internal
+ *
+ * Flush thread of the io_uring backend: every handed over buffer is passed to
+ * the kernel right away, at its own offset, and counted as written once it and
+ * all older buffers completed. Without io_uring each buffer is written with pwrite.
+ *
+ * @param [in,out] pArg Pointer to logger context.
+ * @return NULL.
+ */
+static void* TextLogger_FlushThreadAtOffsets(void* pArg)
+{
+   LoggerContextType* pLoggerContext = (LoggerContextType*) pArg;
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+
+   pthread_mutex_lock(&pFlusher->lock);
+   while (true) {
+      while (pFlusher->issuedCount == pFlusher->submittedCount && pFlusher->writtenCount == pFlusher->issuedCount && !pFlusher->stopRequested) {
+         pthread_cond_wait(&pFlusher->bufferSubmitted, &pFlusher->lock);
+      }
+      if (pFlusher->writtenCount == pFlusher->submittedCount) {
+         break; // stopped and nothing left to write
+      }
+      uint64_t firstCount = pFlusher->issuedCount;
+      uint64_t lastCount = pFlusher->submittedCount;
+      pFlusher->issuedCount = lastCount;
+      TextLoggerFlushBatchType batch = { pLoggerContext, pFlusher->fd, TEXTLOGGER_SUCCESS };
+      pthread_mutex_unlock(&pFlusher->lock);
+
+      // queue new buffers, then wait for at least one write in flight
+      for (uint64_t count = firstCount; count < lastCount; count++) {
+         int index = (int) (count % (uint64_t) pFlusher->bufferCount);
+         if (NULL == pFlusher->pUring ||
+             !TextLogger_UringQueueWrite(pFlusher->pUring, batch.fd, pFlusher->ppBuffers[index], pFlusher->pLengths[index], pFlusher->pOffsets[index], count)) {
+            bool isWritten = TextLogger_FlusherWriteAt(batch.fd, pFlusher->ppBuffers[index], pFlusher->pLengths[index], pFlusher->pOffsets[index]);
+            TextLogger_FlusherCompleteWrite(&batch, count, isWritten ? pFlusher->pLengths[index] : -1);
+         }
+      }
+      if (NULL != pFlusher->pUring && !TextLogger_UringWait(pFlusher->pUring, TextLogger_FlusherCompleteWrite, &batch)) {
+         // ring is unusable: write what it did not take with pwrite from now on
+         TextLogger_UringDestroy(pFlusher->pUring);
+         pFlusher->pUring = NULL;
+         for (uint64_t count = pFlusher->writtenCount; count < lastCount; count++) {
+            int index = (int) (count % (uint64_t) pFlusher->bufferCount);
+            if (!pFlusher->pIsWritten[index]) {
+               bool isWritten = TextLogger_FlusherWriteAt(batch.fd, pFlusher->ppBuffers[index], pFlusher->pLengths[index], pFlusher->pOffsets[index]);
+               TextLogger_FlusherCompleteWrite(&batch, count, isWritten ? pFlusher->pLengths[index] : -1);
+            }
+         }
+      }
+
+      // buffers count as written oldest first, like with the stdio backend
+      pthread_mutex_lock(&pFlusher->lock);
+      if (TEXTLOGGER_SUCCESS != batch.status) {
+         pFlusher->writeStatus = batch.status;
+      }
+      bool isAdvanced = false;
+      while (pFlusher->writtenCount < pFlusher->issuedCount && pFlusher->pIsWritten[pFlusher->writtenCount % (uint64_t) pFlusher->bufferCount]) {
+         pFlusher->pIsWritten[pFlusher->writtenCount % (uint64_t) pFlusher->bufferCount] = false;
+         pFlusher->writtenCount++;
+         isAdvanced = true;
+      }
+      if (isAdvanced) {
+         pthread_cond_broadcast(&pFlusher->bufferWritten);
+      }
+   }
+   pthread_mutex_unlock(&pFlusher->lock);
+
+   return NULL;
+}
+
+#endif // _WIN32
+
+/**
+ * @internal
+ *
+ * Flush thread: writes handed over buffers to file in order until stopped.
+ *
+ * @param [in,out] pArg Pointer to logger context.
+ * @return NULL.
+ */
+static void* TextLogger_FlushThread(void* pArg)
+{
+   LoggerContextType* pLoggerContext = (LoggerContextType*) pArg;
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+
+   pthread_mutex_lock(&pFlusher->lock);
+   while (true) {
+      while (pFlusher->writtenCount == pFlusher->submittedCount && !pFlusher->stopRequested) {
+         pthread_cond_wait(&pFlusher->bufferSubmitted, &pFlusher->lock);
+      }
+      if (pFlusher->writtenCount == pFlusher->submittedCount) {
+         break; // stopped and nothing left to write
+      }
+      int index = (int) (pFlusher->writtenCount % (uint64_t) pFlusher->bufferCount);
+      pthread_mutex_unlock(&pFlusher->lock);
+
+      // the context never touches a handed over buffer, nor the file while buffers are in flight
+      TextLoggerStatusType status;
+      if (pLoggerContext->circularFile) {
+         status = TextLogger_CircularWrite(pLoggerContext, pFlusher->ppBuffers[index], pFlusher->pLengths[index]);
+         TextLogger_DurableAddWritten(pLoggerContext, pFlusher->pLengths[index]);
+      } else {
+         size_t bytesWritten = fwrite(pFlusher->ppBuffers[index], sizeof(char), pFlusher->pLengths[index], pLoggerContext->pLogFile);
+         TextLogger_DurableAddWritten(pLoggerContext, bytesWritten);
+         status = (bytesWritten == (size_t) pFlusher->pLengths[index]) ? TEXTLOGGER_SUCCESS : TEXTLOGGER_ERR_FILE_ERROR;
+      }
+
+      pthread_mutex_lock(&pFlusher->lock);
+      if (TEXTLOGGER_SUCCESS != status) {
+         pFlusher->writeStatus = status;
+      }
+      pFlusher->writtenCount++;
+      pthread_cond_broadcast(&pFlusher->bufferWritten);
+   }
+   pthread_mutex_unlock(&pFlusher->lock);
+
+   return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Frees the buffers of a flusher, except the one the context is filling.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in,out] pFlusher Pointer to flush thread state.
+ */
+static void TextLogger_FlusherFree(LoggerContextType* pLoggerContext, TextLoggerFlusherType* pFlusher)
+{
+   for (int index = 0; NULL != pFlusher->ppBuffers && index < pFlusher->bufferCount; index++) {
+      if (pFlusher->ppBuffers[index] != pLoggerContext->pTextBuffer) {
+         free(pFlusher->ppBuffers[index]);
+      }
+   }
+   if (NULL != pFlusher->pUring) {
+      TextLogger_UringDestroy(pFlusher->pUring);
+   }
+#ifndef _WIN32
+   if (0 <= pFlusher->fd) {
+      close(pFlusher->fd);
+   }
+#endif
+   free(pFlusher->ppBuffers);
+   free(pFlusher->pLengths);
+   free(pFlusher->pOffsets);
+   free(pFlusher->pIsWritten);
+   free(pFlusher);
+}
+
+TextLoggerStatusType TextLogger_FlusherStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   int bufferCount = pConfig->flushBufferCount;
+   TextLoggerFlusherType* pFlusher = (TextLoggerFlusherType*) calloc(1, sizeof(TextLoggerFlusherType));
+   if (NULL == pFlusher) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pFlusher->fd = -1;
+   pFlusher->bufferCount = bufferCount;
+   pFlusher->ppBuffers = (char**) calloc(bufferCount, sizeof(char*));
+   pFlusher->pLengths = (int*) calloc(bufferCount, sizeof(int));
+   pFlusher->pOffsets = (long int*) calloc(bufferCount, sizeof(long int));
+   pFlusher->pIsWritten = (bool*) calloc(bufferCount, sizeof(bool));
+   if (NULL == pFlusher->ppBuffers || NULL == pFlusher->pLengths || NULL == pFlusher->pOffsets || NULL == pFlusher->pIsWritten) {
+      TextLogger_FlusherFree(pLoggerContext, pFlusher);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   // the context's own buffer is the first one
+   pFlusher->ppBuffers[0] = pLoggerContext->pTextBuffer;
+   for (int index = 1; index < bufferCount; index++) {
+      pFlusher->ppBuffers[index] = (char*) malloc(sizeof(char) * pLoggerContext->maxBufferByteSize);
+      if (NULL == pFlusher->ppBuffers[index]) {
+         TextLogger_FlusherFree(pLoggerContext, pFlusher);
+         return TEXTLOGGER_ERR_INVALID_INPUT;
+      }
+   }
+
+   // without pwrite (Windows) every backend writes through stdio
+   void* (*pFlushThread)(void*) = TextLogger_FlushThread;
+#ifndef _WIN32
+   if (TEXTLOGGER_BACKEND_IO_URING == pConfig->writeBackend) {
+      pFlusher->backend = TEXTLOGGER_BACKEND_IO_URING;
+      pFlusher->fd = TextLogger_FlusherOpenFile(pLoggerContext->pFilePath);
+      if (0 > pFlusher->fd) {
+         TextLogger_FlusherFree(pLoggerContext, pFlusher);
+         return TEXTLOGGER_ERR_FILE_ERROR;
+      }
+      pFlusher->pUring = TextLogger_UringCreate((unsigned int) bufferCount);
+      pFlushThread = TextLogger_FlushThreadAtOffsets;
+   }
+#endif
+
+   pFlusher->writeStatus = TEXTLOGGER_SUCCESS;
+   pthread_mutex_init(&pFlusher->lock, NULL);
+   pthread_cond_init(&pFlusher->bufferSubmitted, NULL);
+   pthread_cond_init(&pFlusher->bufferWritten, NULL);
+
+   pLoggerContext->pFlusher = pFlusher;
+   if (0 != pthread_create(&pFlusher->flushThread, NULL, pFlushThread, pLoggerContext)) {
+      pthread_cond_destroy(&pFlusher->bufferWritten);
+      pthread_cond_destroy(&pFlusher->bufferSubmitted);
+      pthread_mutex_destroy(&pFlusher->lock);
+      TextLogger_FlusherFree(pLoggerContext, pFlusher);
+      pLoggerContext->pFlusher = NULL;
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_FlusherStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+
+   // flush thread exits only once every buffer is written
+   pthread_mutex_lock(&pFlusher->lock);
+   pFlusher->stopRequested = true;
+   pthread_cond_signal(&pFlusher->bufferSubmitted);
+   pthread_mutex_unlock(&pFlusher->lock);
+   pthread_join(pFlusher->flushThread, NULL);
+   TextLoggerStatusType status = pFlusher->writeStatus;
+
+   pthread_cond_destroy(&pFlusher->bufferWritten);
+   pthread_cond_destroy(&pFlusher->bufferSubmitted);
+   pthread_mutex_destroy(&pFlusher->lock);
+   TextLogger_FlusherFree(pLoggerContext, pFlusher);
+   pLoggerContext->pFlusher = NULL;
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_FlusherSubmit(LoggerContextType* pLoggerContext)
+{
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+
+   pthread_mutex_lock(&pFlusher->lock);
+   TextLoggerStatusType status = pFlusher->writeStatus;
+   if (TEXTLOGGER_SUCCESS == status) {
+      pFlusher->pLengths[pFlusher->submittedCount % (uint64_t) pFlusher->bufferCount] = pLoggerContext->currBytePos;
+      pFlusher->pOffsets[pFlusher->submittedCount % (uint64_t) pFlusher->bufferCount] = pLoggerContext->currFileSize;
+      pFlusher->submittedCount++;
+      pthread_cond_signal(&pFlusher->bufferSubmitted);
+
+      // continue in the next buffer, waiting only while every other one is in flight
+      while (pFlusher->submittedCount - pFlusher->writtenCount >= (uint64_t) pFlusher->bufferCount) {
+         pthread_cond_wait(&pFlusher->bufferWritten, &pFlusher->lock);
+      }
+      pLoggerContext->pTextBuffer = pFlusher->ppBuffers[pFlusher->submittedCount % (uint64_t) pFlusher->bufferCount];
+   }
+   pthread_mutex_unlock(&pFlusher->lock);
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_FlusherSetFile(LoggerContextType* pLoggerContext)
+{
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+   if (TEXTLOGGER_BACKEND_IO_URING != pFlusher->backend) {
+      return TEXTLOGGER_SUCCESS; // stdio backend writes through pLogFile
+   }
+
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+#ifndef _WIN32
+   pthread_mutex_lock(&pFlusher->lock);
+   if (0 <= pFlusher->fd) {
+      close(pFlusher->fd);
+   }
+   pFlusher->fd = TextLogger_FlusherOpenFile(pLoggerContext->pFilePath);
+   if (0 > pFlusher->fd) {
+      status = TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pthread_mutex_unlock(&pFlusher->lock);
+#endif
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_FlusherWait(LoggerContextType* pLoggerContext)
+{
+   TextLoggerFlusherType* pFlusher = pLoggerContext->pFlusher;
+
+   pthread_mutex_lock(&pFlusher->lock);
+   uint64_t targetCount = pFlusher->submittedCount;
+   while (pFlusher->writtenCount < targetCount) {
+      pthread_cond_wait(&pFlusher->bufferWritten, &pFlusher->lock);
+   }
+   TextLoggerStatusType status = pFlusher->writeStatus;
+   pthread_mutex_unlock(&pFlusher->lock);
+
+   return status;
+}
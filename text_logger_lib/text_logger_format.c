@@ -0,0 +1,412 @@
+#define _POSIX_C_SOURCE 200809L // strnlen
+
+/* system headers */
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+#define MAX_SPEC_SIZE            (32) // longest single conversion specification accepted, e.g. "%-+#0123.456llx"
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the enum type for
+ * the C type an argument is passed as, after default promotions.
+ */
+typedef enum {
+   ARG_TYPE_NONE = 0, // "%%"
+   ARG_TYPE_INT,
+   ARG_TYPE_LONG,
+   ARG_TYPE_LONG_LONG,
+   ARG_TYPE_INTMAX,
+   ARG_TYPE_SIZE,
+   ARG_TYPE_PTRDIFF,
+   ARG_TYPE_DOUBLE,
+   ARG_TYPE_LONG_DOUBLE,
+   ARG_TYPE_POINTER,
+   ARG_TYPE_STRING,
+   ARG_TYPE_UNSUPPORTED // "%n", wide characters or malformed specification
+} ArgType;
+
+/**
+ * @brief This is the structure type of one parsed conversion specification.
+ */
+typedef struct {
+   const char* pStart; // points at '%'
+   int length; // length of the whole specification
+   int starCount; // number of '*' for width and precision
+   bool precisionIsStar; // precision is the last '*' argument
+   int precision; // literal precision, -1 if none or given by '*'
+   ArgType argType;
+} FormatSpecType;
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Parses the conversion specification starting at pFormat.
+ *
+ * @param [in] pFormat Pointer to '%'.
+ * @param [out] pSpec Parsed specification.
+ */
+static void TextLogger_ParseSpec(const char* pFormat, FormatSpecType* pSpec)
+{
+   const char* pCursor = pFormat + 1;
+   pSpec->pStart = pFormat;
+   pSpec->starCount = 0;
+   pSpec->precisionIsStar = false;
+   pSpec->precision = -1;
+   pSpec->argType = ARG_TYPE_UNSUPPORTED;
+
+   // flags, width and precision
+   while (NULL != strchr("-+ #0", *pCursor) && '\0' != *pCursor) {
+      pCursor++;
+   }
+   if ('*' == *pCursor) {
+      pSpec->starCount++;
+      pCursor++;
+   }
+   while ('0' <= *pCursor && '9' >= *pCursor) {
+      pCursor++;
+   }
+   if ('.' == *pCursor) {
+      pCursor++;
+      if ('*' == *pCursor) {
+         pSpec->starCount++;
+         pSpec->precisionIsStar = true;
+         pCursor++;
+      } else {
+         pSpec->precision = 0; // "." alone is a precision of 0
+      }
+      while ('0' <= *pCursor && '9' >= *pCursor) {
+         if (!pSpec->precisionIsStar && INT_MAX / 10 > pSpec->precision) {
+            pSpec->precision = pSpec->precision * 10 + (*pCursor - '0');
+         }
+         pCursor++;
+      }
+   }
+
+   // length modifier
+   char lengthModifier = '\0';
+   if ('h' == *pCursor) {
+      lengthModifier = 'h';
+      pCursor += ('h' == pCursor[1]) ? 2 : 1;
+   } else if ('l' == *pCursor) {
+      lengthModifier = ('l' == pCursor[1]) ? 'q' : 'l'; // 'q' stands for "ll"
+      pCursor += ('l' == pCursor[1]) ? 2 : 1;
+   } else if (NULL != strchr("jztL", *pCursor) && '\0' != *pCursor) {
+      lengthModifier = *pCursor;
+      pCursor++;
+   }
+
+   // conversion
+   char conversion = *pCursor;
+   if ('\0' != conversion) {
+      pCursor++;
+   }
+   pSpec->length = (int) (pCursor - pFormat);
+
+   if ('%' == conversion) {
+      pSpec->argType = ARG_TYPE_NONE;
+   } else if (NULL != strchr("diouxXc", conversion) && '\0' != conversion) {
+      if ('c' == conversion && 'l' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_UNSUPPORTED; // wint_t
+      } else if ('l' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_LONG;
+      } else if ('q' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_LONG_LONG;
+      } else if ('j' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_INTMAX;
+      } else if ('z' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_SIZE;
+      } else if ('t' == lengthModifier) {
+         pSpec->argType = ARG_TYPE_PTRDIFF;
+      } else if ('L' != lengthModifier) {
+         pSpec->argType = ARG_TYPE_INT; // char and short are promoted to int
+      }
+   } else if (NULL != strchr("fFeEgGaA", conversion) && '\0' != conversion) {
+      pSpec->argType = ('L' == lengthModifier) ? ARG_TYPE_LONG_DOUBLE : ARG_TYPE_DOUBLE;
+   } else if ('p' == conversion) {
+      pSpec->argType = ARG_TYPE_POINTER;
+   } else if ('s' == conversion && '\0' == lengthModifier) {
+      pSpec->argType = ARG_TYPE_STRING;
+   }
+
+   if (MAX_SPEC_SIZE <= pSpec->length) {
+      pSpec->argType = ARG_TYPE_UNSUPPORTED;
+   }
+}
+
+/**
+ * @internal
+ *
+ * Appends bytes to the capture buffer.
+ *
+ * @param [in,out] pDest Capture buffer.
+ * @param [in,out] pUsed Bytes already used in pDest.
+ * @param [in] destSize Size of pDest.
+ * @param [in] pSource Bytes to append.
+ * @param [in] byteSize Number of bytes to append.
+ * @return true if the bytes fit.
+ */
+static bool TextLogger_CaptureBytes(char* pDest, size_t* pUsed, size_t destSize, const void* pSource, size_t byteSize)
+{
+   if (destSize - *pUsed < byteSize) {
+      return false;
+   }
+   memcpy(pDest + *pUsed, pSource, byteSize);
+   *pUsed += byteSize;
+   return true;
+}
+
+/**
+ * @internal
+ *
+ * Reads a value stored by TextLogger_CaptureBytes.
+ *
+ * @param [in,out] ppCursor Read position, moved past the value.
+ * @param [out] pValue Value to fill.
+ * @param [in] byteSize Size of value.
+ */
+static void TextLogger_ReadCaptured(const char** ppCursor, void* pValue, size_t byteSize)
+{
+   memcpy(pValue, *ppCursor, byteSize);
+   *ppCursor += byteSize;
+}
+
+int TextLogger_CaptureArgs(char* pDest, int destSize, const char* pFormat, va_list args)
+{
+   size_t used = 0;
+
+   // the format string itself comes first, so callers may pass a temporary
+   if (!TextLogger_CaptureBytes(pDest, &used, destSize, pFormat, strlen(pFormat) + 1)) {
+      return -1;
+   }
+
+   for (const char* pCursor = strchr(pFormat, '%'); NULL != pCursor; pCursor = strchr(pCursor, '%')) {
+      FormatSpecType spec;
+      TextLogger_ParseSpec(pCursor, &spec);
+      pCursor += spec.length;
+
+      int precision = spec.precision;
+      for (int star = 0; star < spec.starCount; star++) {
+         int starValue = va_arg(args, int);
+         if (!TextLogger_CaptureBytes(pDest, &used, destSize, &starValue, sizeof(starValue))) {
+            return -1;
+         }
+         if (spec.precisionIsStar && star == spec.starCount - 1) {
+            precision = starValue; // negative means no precision
+         }
+      }
+
+      bool fits = true;
+      switch (spec.argType) {
+         case ARG_TYPE_NONE: {
+            break;
+         }
+         case ARG_TYPE_INT: {
+            int value = va_arg(args, int);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_LONG: {
+            long value = va_arg(args, long);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_LONG_LONG: {
+            long long value = va_arg(args, long long);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_INTMAX: {
+            intmax_t value = va_arg(args, intmax_t);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_SIZE: {
+            size_t value = va_arg(args, size_t);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_PTRDIFF: {
+            ptrdiff_t value = va_arg(args, ptrdiff_t);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_DOUBLE: {
+            double value = va_arg(args, double);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_LONG_DOUBLE: {
+            long double value = va_arg(args, long double);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_POINTER: {
+            void* value = va_arg(args, void*);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, &value, sizeof(value));
+            break;
+         }
+         case ARG_TYPE_STRING: {
+            // the string may not outlive the call, so copy it
+            const char* value = va_arg(args, const char*);
+            if (NULL == value) {
+               value = "(null)";
+            }
+            // with a precision the string need not be terminated, printf reads no further
+            size_t valueLength = (0 <= precision) ? strnlen(value, (size_t) precision) : strlen(value);
+            fits = TextLogger_CaptureBytes(pDest, &used, destSize, value, valueLength) &&
+                   TextLogger_CaptureBytes(pDest, &used, destSize, "", 1);
+            break;
+         }
+         default: {
+            return -1; // caller formats right away instead
+         }
+      }
+      if (!fits) {
+         return -1;
+      }
+   }
+
+   return (int) used;
+}
+
+int TextLogger_FormatCapturedArgs(char* pDest, int destSize, const char* pCaptured)
+{
+   const char* pFormat = pCaptured;
+   const char* pArgs = pCaptured + strlen(pFormat) + 1;
+   int used = 0;
+
+   while ('\0' != *pFormat && used < destSize - 1) {
+      // copy literal text up to the next specification
+      const char* pSpecStart = strchr(pFormat, '%');
+      int literalLength = (NULL == pSpecStart) ? (int) strlen(pFormat) : (int) (pSpecStart - pFormat);
+      if (literalLength > destSize - 1 - used) {
+         literalLength = destSize - 1 - used;
+      }
+      memcpy(pDest + used, pFormat, literalLength);
+      used += literalLength;
+      if (NULL == pSpecStart) {
+         break;
+      }
+
+      FormatSpecType spec;
+      TextLogger_ParseSpec(pSpecStart, &spec);
+      pFormat = pSpecStart + spec.length;
+
+      // rebuild the specification with '*' replaced by the captured numbers
+      char pSpec[MAX_SPEC_SIZE * 2];
+      int specLength = 0;
+      for (int index = 0; index < spec.length; index++) {
+         if ('*' == spec.pStart[index]) {
+            int starValue;
+            TextLogger_ReadCaptured(&pArgs, &starValue, sizeof(starValue));
+            if ('.' == spec.pStart[index - 1] && 0 > starValue) {
+               specLength--; // negative precision means no precision
+            } else {
+               specLength += snprintf(pSpec + specLength, sizeof(pSpec) - specLength, "%d", starValue);
+            }
+         } else {
+            pSpec[specLength++] = spec.pStart[index];
+         }
+      }
+      pSpec[specLength] = '\0';
+
+      char* pOut = pDest + used;
+      size_t outSize = destSize - used;
+      int written = 0;
+      switch (spec.argType) {
+         case ARG_TYPE_NONE: {
+            written = snprintf(pOut, outSize, "%%");
+            break;
+         }
+         case ARG_TYPE_INT: {
+            int value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_LONG: {
+            long value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_LONG_LONG: {
+            long long value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_INTMAX: {
+            intmax_t value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_SIZE: {
+            size_t value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_PTRDIFF: {
+            ptrdiff_t value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_DOUBLE: {
+            double value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_LONG_DOUBLE: {
+            long double value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_POINTER: {
+            void* value;
+            TextLogger_ReadCaptured(&pArgs, &value, sizeof(value));
+            written = snprintf(pOut, outSize, pSpec, value);
+            break;
+         }
+         case ARG_TYPE_STRING: {
+            written = snprintf(pOut, outSize, pSpec, pArgs);
+            pArgs += strlen(pArgs) + 1;
+            break;
+         }
+         default: {
+            break; // rejected by TextLogger_CaptureArgs
+         }
+      }
+
+      // snprintf returns the untruncated length
+      used += (0 > written) ? 0 : ((written < (int) outSize) ? written : (int) outSize - 1);
+   }
+
+   pDest[used] = '\0';
+   return used;
+}
@@ -0,0 +1,178 @@
+#define _XOPEN_SOURCE 700 // writev, IOV_MAX, fileno
+
+/* system headers */
+#include <errno.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+// most slices handed to the kernel in one writev
+#if defined(IOV_MAX)
+#define GATHER_MAX_SLICES        (IOV_MAX)
+#else
+#define GATHER_MAX_SLICES        (16) // _XOPEN_IOV_MAX, the least POSIX allows
+#endif
+
+/*
+ * Structures
+ */
+
+#ifdef _WIN32
+typedef struct {
+   void* iov_base;
+   size_t iov_len;
+} TextLoggerSliceType; // same fields as struct iovec, written one by one
+#else
+typedef struct iovec TextLoggerSliceType;
+#endif
+
+/**
+ * @brief This is the structure type of the records gathered for one writev.
+ *
+ * Timestamps, tags and small records stay in pTextBuffer, while the messages
+ * of gathered records are only referenced: the slices alternate between the
+ * part of pTextBuffer written since the previous message and a message.
+ * Messages belong to the caller, so the slices are written before the
+ * logging call returns.
+ */
+struct TextLoggerGather{
+   TextLoggerSliceType pSlices[GATHER_MAX_SLICES];
+   int sliceCount;
+   int bufferStart; // first byte of pTextBuffer not covered by a slice yet
+   long int messageByteCount; // bytes of the referenced messages
+};
+
+/*
+ * Code
+ */
+
+TextLoggerStatusType TextLogger_GatherStart(LoggerContextType* pLoggerContext)
+{
+   TextLoggerGatherType* pGather = (TextLoggerGatherType*) malloc(sizeof(TextLoggerGatherType));
+   if (NULL == pGather) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pGather->sliceCount = 0;
+   pGather->bufferStart = 0;
+   pGather->messageByteCount = 0;
+
+   pLoggerContext->pGather = pGather;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_GatherStop(LoggerContextType* pLoggerContext)
+{
+   free(pLoggerContext->pGather);
+   pLoggerContext->pGather = NULL;
+}
+
+bool TextLogger_GatherHasRoom(LoggerContextType* pLoggerContext)
+{
+   // a message takes two slices, the end of pTextBuffer one more when written
+   return (pLoggerContext->pGather->sliceCount + 3 <= GATHER_MAX_SLICES);
+}
+
+void TextLogger_GatherMessage(LoggerContextType* pLoggerContext, const char* pLogText, int textLength)
+{
+   TextLoggerGatherType* pGather = pLoggerContext->pGather;
+
+   if (pGather->bufferStart < pLoggerContext->currBytePos) {
+      pGather->pSlices[pGather->sliceCount].iov_base = pLoggerContext->pTextBuffer + pGather->bufferStart;
+      pGather->pSlices[pGather->sliceCount].iov_len = pLoggerContext->currBytePos - pGather->bufferStart;
+      pGather->sliceCount++;
+      pGather->bufferStart = pLoggerContext->currBytePos;
+   }
+   if (0 < textLength) {
+      pGather->pSlices[pGather->sliceCount].iov_base = (void*) pLogText;
+      pGather->pSlices[pGather->sliceCount].iov_len = textLength;
+      pGather->sliceCount++;
+      pGather->messageByteCount += textLength;
+   }
+}
+
+long int TextLogger_GatherPendingSize(LoggerContextType* pLoggerContext)
+{
+   return pLoggerContext->pGather->messageByteCount;
+}
+
+bool TextLogger_GatherIsPending(LoggerContextType* pLoggerContext)
+{
+   return (0 < pLoggerContext->pGather->sliceCount);
+}
+
+void TextLogger_GatherClear(LoggerContextType* pLoggerContext)
+{
+   pLoggerContext->pGather->sliceCount = 0;
+   pLoggerContext->pGather->bufferStart = 0;
+   pLoggerContext->pGather->messageByteCount = 0;
+}
+
+TextLoggerStatusType TextLogger_GatherFlush(LoggerContextType* pLoggerContext)
+{
+   TextLoggerGatherType* pGather = pLoggerContext->pGather;
+
+   // rest of pTextBuffer after the last message
+   if (pGather->bufferStart < pLoggerContext->currBytePos) {
+      pGather->pSlices[pGather->sliceCount].iov_base = pLoggerContext->pTextBuffer + pGather->bufferStart;
+      pGather->pSlices[pGather->sliceCount].iov_len = pLoggerContext->currBytePos - pGather->bufferStart;
+      pGather->sliceCount++;
+   }
+
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+#ifdef _WIN32
+   for (int index = 0; index < pGather->sliceCount; index++) {
+      TextLoggerSliceType* pSlice = &pGather->pSlices[index];
+      size_t bytesWritten = fwrite(pSlice->iov_base, sizeof(char), pSlice->iov_len, pLoggerContext->pLogFile);
+      pLoggerContext->currFileSize += bytesWritten;
+      TextLogger_DurableAddWritten(pLoggerContext, bytesWritten);
+      if (bytesWritten != pSlice->iov_len) {
+         status = TEXTLOGGER_ERR_FILE_ERROR;
+         break;
+      }
+   }
+#else
+   // pLogFile is unbuffered and in append mode, so writing to its descriptor keeps the order
+   int fd = fileno(pLoggerContext->pLogFile);
+   TextLoggerSliceType* pSlice = pGather->pSlices;
+   TextLoggerSliceType* pEnd = pGather->pSlices + pGather->sliceCount;
+   while (pSlice < pEnd) {
+      ssize_t bytesWritten = writev(fd, pSlice, (int) (pEnd - pSlice));
+      if (0 > bytesWritten && EINTR == errno) {
+         continue;
+      }
+      if (0 >= bytesWritten) {
+         status = TEXTLOGGER_ERR_FILE_ERROR;
+         break;
+      }
+      pLoggerContext->currFileSize += bytesWritten;
+      TextLogger_DurableAddWritten(pLoggerContext, (size_t) bytesWritten);
+
+      // skip what was written, a short write resumes in the middle of a slice
+      while (pSlice < pEnd && (size_t) bytesWritten >= pSlice->iov_len) {
+         bytesWritten -= (ssize_t) pSlice->iov_len;
+         pSlice++;
+      }
+      if (pSlice < pEnd) {
+         pSlice->iov_base = (char*) pSlice->iov_base + bytesWritten;
+         pSlice->iov_len -= (size_t) bytesWritten;
+      }
+   }
+#endif
+
+   TextLogger_GatherClear(pLoggerContext);
+   return status;
+}
@@ -0,0 +1,1021 @@
+/**
+ * @addtogroup TextLogger
+ * @{
+ */
+
+/**
+ * @brief Internal declarations shared between the text_logger_lib source files.
+ * Not to be included by users of the module.
+ */
+
+#ifndef _TEXT_LOGGER_INTERNAL_H_
+#define _TEXT_LOGGER_INTERNAL_H_
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "text_logger.h"
+
+/*
+ * Defines
+ */
+
+#define MAX_STR_SIZE             (128)
+#define LOG_TAG_STR_LENGTH       (5) // "[E]: "
+#define LOG_EXTRA_STR_LENGTH     (LOG_TAG_STR_LENGTH + 1) // LOG_EXTRA_STR_LENGTH accounts for adding "[E]: \n" with the log message
+#define TIMESTAMP_STR_LENGTH     (24) // "[YYYY-MM-DD | HH:MM:SS] "
+#define CIRCULAR_HEADER_SIZE     (32) // header in front of the data region of a circular log file
+#define ROTATED_PATH_SUFFIX_SIZE (16) // ".<int>", ARCHIVE_FILE_SUFFIX and null terminator
+#define ARCHIVE_FILE_SUFFIX      ".tlz" // rotated files compressed in the background, TEXTLOGGER_LZ_MAGIC blocks rather than an lz4 frame
+#define TEXTLOGGER_LZ_HASH_LOG   (12) // 4096 match finder entries, like LZ4's default
+
+/*
+ * Structures
+ */
+
+typedef struct TextLoggerAsync TextLoggerAsyncType; // defined in text_logger_async.c
+typedef struct TextLoggerPerThread TextLoggerPerThreadType; // defined in text_logger_per_thread.c
+typedef struct TextLoggerFlusher TextLoggerFlusherType; // defined in text_logger_flush.c
+typedef struct TextLoggerDurable TextLoggerDurableType; // defined in text_logger_durable.c
+typedef struct TextLoggerUring TextLoggerUringType; // defined in text_logger_uring.c
+typedef struct TextLoggerMmap TextLoggerMmapType; // defined in text_logger_mmap.c
+typedef struct TextLoggerGather TextLoggerGatherType; // defined in text_logger_gather.c
+typedef struct TextLoggerCompress TextLoggerCompressType; // defined in text_logger_compress.c
+typedef struct TextLoggerArchive TextLoggerArchiveType; // defined in text_logger_archive.c
+typedef struct TextLoggerRecorder TextLoggerRecorderType; // defined in text_logger_recorder.c
+typedef struct TextLoggerCrash TextLoggerCrashType; // defined in text_logger_crash.c
+typedef struct TextLoggerPersist TextLoggerPersistType; // defined in text_logger_persist.c
+typedef struct TextLoggerDaemon TextLoggerDaemonType; // defined in text_logger_daemon.c
+
+/**
+ * @brief This is the structure type of the match finder of an LZ4 block compressor.
+ *
+ * The hash table maps the first four bytes at a position to the last position
+ * they were seen at. Positions count on across blocks, so entries from previous
+ * blocks are told apart without clearing the table for every block.
+ */
+typedef struct {
+   uint32_t pTable[1 << TEXTLOGGER_LZ_HASH_LOG];
+   uint32_t tableBase; // position of the first byte of the current block, starts at 1 so empty entries are never valid
+} TextLoggerLzTableType;
+
+/**
+ * @brief This is the function type called for each reaped io_uring completion.
+ * result is the number of bytes written or a negative errno.
+ */
+typedef void (*TextLoggerUringCompletionType)(void* pArg, uint64_t userData, int result);
+
+/**
+ * @brief This is the structure type of a logger context.
+ *
+ * User needs to provide strings containing
+ * 1) Full path to file and
+ * 2) Error message for if max file size has been reached.
+ *
+ * User needs to also specify
+ * 1) minimum log level to filter log messages,
+ * 2) max buffer size to store messages before flushing, and
+ * 3) max file size allowed to contain all log messages.
+ */
+struct LoggerContext{
+   TextLoggerFilterType filter; // must stay the first member, read by the TLOG_* macros
+   FILE* pLogFile;
+   char* pTextBuffer;
+   char* pFilePath;
+   char* pErrMsg;
+   int maxBufferByteSize;
+   int maxFileSize; // size of the data region for a circular file
+   int currBytePos; // starts 0
+   int totalBytesStored; // starts at 0
+   long int currFileSize; // tracked file offset, read once when the file is opened
+   bool fileLimitIsReached; // starts at false, never set with rotation enabled or a circular file
+   bool fileSizeIsLimited; // false with rotation enabled or a circular file, logging then never stops at maxFileSize
+   time_t fileOpenTime; // for time based rotation
+   int rotationMaxFiles; // 0 disables rotation
+   int rotationIntervalSec; // 0 disables time based rotation
+   bool circularFile; // overwrite the oldest bytes of a preallocated file, see text_logger_circular.c
+   long int circularWriteHead; // offset in the data region where the next flush goes
+   bool circularHasWrapped; // data region has been filled at least once
+   TextLoggerModeType mode;
+   TextLoggerFormatType format;
+   time_t lastBinaryTimeStamp; // base for the timestamp delta of the next binary record
+   time_t cachedTimeStamp; // time of pCachedTimeStamp, only touched by the thread formatting into pTextBuffer
+   time_t cachedMinuteStart; // time at which pCachedTimeStamp's minute started
+   char pCachedTimeStamp[TIMESTAMP_STR_LENGTH + 1];
+   TextLoggerAsyncType* pAsync; // only used in TEXTLOGGER_MODE_ASYNC
+   TextLoggerPerThreadType* pPerThread; // only used in TEXTLOGGER_MODE_PER_THREAD
+   TextLoggerFlusherType* pFlusher; // only used with more than one flush buffer
+   TextLoggerDurableType* pDurable; // sync state, in every durability mode
+   TextLoggerMmapType* pMmap; // only used with TEXTLOGGER_BACKEND_MMAP, pTextBuffer then points into the mapped file
+   TextLoggerGatherType* pGather; // only used in TEXTLOGGER_MODE_SYNC appending through stdio with one buffer
+   int gatherMinTextSize; // messages at least this long are gathered, 0 only those larger than pTextBuffer
+   TextLoggerCompressType* pCompress; // only used with TEXTLOGGER_COMPRESSION_LZ4
+   TextLoggerArchiveType* pArchive; // only used with rotationCompressThreads, compresses rotated files in the background
+   TextLoggerRecorderType* pRecorder; // only used with flightRecorderSize, filter.logLevel then lets every level through
+   int fileLogLevel; // least important level written to the file right away, less important ones go to pRecorder
+   TextLoggerCrashType* pCrash; // only used with crashDump, registers the context with the signal handler
+   TextLoggerPersistType* pPersist; // only used with pBufferFilePath, pTextBuffer then points into the mapped buffer file
+   TextLoggerDaemonType* pDaemon; // only used in TEXTLOGGER_MODE_DAEMON, the context then has no file, buffer or other module
+   TextLoggerDurabilityType durability;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/*
+ * text_logger.c
+ */
+
+/**
+ * Opens log file in append mode and reads its current size.
+ * The file stays open until TextLogger_Destroy, TextLogger_ReopenFile or rotation.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if error occurs when opening the file.
+ */
+TextLoggerStatusType TextLogger_OpenFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Closes log file, trimming the preallocated tail of a mapped file.
+ * Does nothing if no file is open.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be trimmed or closed.
+ */
+TextLoggerStatusType TextLogger_CloseFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Formats one log record (timestamp, tag and message) into pTextBuffer,
+ * flushing the buffer to file first if needed.
+ * In async mode this is only called from the writer thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] logLength Length of log message including LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if pointer input(s) is NULL.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_WriteToBuffer(LoggerContextType* pLoggerContext, const char* pLogText, int logLength, LogLevelType logLevel, time_t timeStamp);
+
+/**
+ * Writes the records kept by the flight recorder to pTextBuffer, oldest
+ * first, and empties it. Called by the thread formatting into pTextBuffer.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return same as TextLogger_WriteToBuffer.
+ */
+TextLoggerStatusType TextLogger_WriteFlightRecorder(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes pTextBuffer to file and resets it.
+ * In async mode this is only called from the writer thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_FlushBuffer(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_async.c
+ */
+
+/**
+ * Allocates the record queue and starts the writer thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Pointer to configuration used to create the context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if the queue cannot be created.
+ */
+TextLoggerStatusType TextLogger_AsyncStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Drains every queued record to the buffer, stops the writer thread and frees the queue.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_AsyncStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Appends a record to the queue. Blocks only while the queue is full, unless asyncFullPolicy drops the record.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message, without LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the writer thread failed to write to file since its last error was returned.
+ */
+TextLoggerStatusType TextLogger_AsyncPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel);
+
+/**
+ * Waits until every record queued before this call has been written to file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the writer thread failed to write to file since its last error was returned.
+ */
+TextLoggerStatusType TextLogger_AsyncFlush(LoggerContextType* pLoggerContext);
+
+/**
+ * Queues a request for the writer thread to write the flight recorder,
+ * behind the records queued so far. Waits for a free slot whatever the policy.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the writer thread failed to write to file since its last error was returned.
+ */
+TextLoggerStatusType TextLogger_AsyncPushRecorderDump(LoggerContextType* pLoggerContext);
+
+/**
+ * Appends a printf-style record to the queue without formatting it:
+ * the format string and raw arguments are copied and the writer thread formats them.
+ * Falls back to formatting right away if they do not fit in a slot.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pFormat printf-style format string.
+ * @param [in] args Arguments for pFormat.
+ * @param [in] logLevel Level of log message.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the record was dropped by asyncFullPolicy.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the writer thread failed to write to file since its last error was returned.
+ */
+TextLoggerStatusType TextLogger_AsyncPushFormat(LoggerContextType* pLoggerContext, const char* pFormat, va_list args, LogLevelType logLevel);
+
+/*
+ * text_logger_rotation.c
+ */
+
+/**
+ * Checks if the log file is older than rotationIntervalSec and must be
+ * rotated before pTextBuffer is written.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return true if rotation is enabled and needed.
+ */
+bool TextLogger_RotationIntervalHasElapsed(LoggerContextType* pLoggerContext);
+
+/**
+ * Rotates the log file before a record is added to pTextBuffer if the file
+ * would otherwise grow past maxFileSize, so records never straddle two files.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] recordLength Upper bound of the record size in bytes.
+ * @return TEXTLOGGER_SUCCESS if operation is successful or rotation is disabled.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_RotateBeforeRecord(LoggerContextType* pLoggerContext, int recordLength);
+
+/**
+ * Writes the path of a rotated file, "<pFilePath>.<index><pSuffix>",
+ * or pFilePath for index 0.
+ *
+ * @param [out] pDest Destination, strlen(pFilePath) + ROTATED_PATH_SUFFIX_SIZE bytes.
+ * @param [in] pFilePath Path of the active log file.
+ * @param [in] index Rotation index.
+ * @param [in] pSuffix "" or ARCHIVE_FILE_SUFFIX.
+ */
+void TextLogger_RotatedFilePath(char* pDest, const char* pFilePath, int index, const char* pSuffix);
+
+/**
+ * Closes the log file, renames file -> file.1 ... file.N-1 -> file.N
+ * (dropping the old file.N) and opens a new empty file. With background
+ * compression, file.N.tlz move along and file.1 is queued to be compressed.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the new file cannot be opened.
+ */
+TextLoggerStatusType TextLogger_RotateFile(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_circular.c
+ */
+
+/**
+ * Opens a circular log file for writing in place, resuming from its header
+ * if it was written by a context with the same maxFileSize.
+ * Any other file at that path is replaced by an empty, preallocated one.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be opened or preallocated.
+ */
+TextLoggerStatusType TextLogger_CircularOpenFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes bytes at the write head of a circular log file, wrapping around
+ * to the start of the data region, then updates the header.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_CircularWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length);
+
+/*
+ * text_logger_format.c
+ */
+
+/**
+ * Copies a format string and the raw values of its arguments into pDest.
+ * Strings passed for "%s" are copied too, so nothing needs to outlive the call.
+ *
+ * @param [out] pDest Destination buffer.
+ * @param [in] destSize Size of pDest.
+ * @param [in] pFormat printf-style format string.
+ * @param [in] args Arguments for pFormat.
+ * @return number of bytes used in pDest.
+ * @return -1 if they do not fit or pFormat uses "%n", wide characters or a malformed specification.
+ */
+int TextLogger_CaptureArgs(char* pDest, int destSize, const char* pFormat, va_list args);
+
+/**
+ * Formats what TextLogger_CaptureArgs stored, truncating to destSize.
+ *
+ * @param [out] pDest Destination buffer, null-terminated on return.
+ * @param [in] destSize Size of pDest.
+ * @param [in] pCaptured Buffer filled by TextLogger_CaptureArgs.
+ * @return length of formatted text.
+ */
+int TextLogger_FormatCapturedArgs(char* pDest, int destSize, const char* pCaptured);
+
+/*
+ * text_logger_flush.c
+ */
+
+/**
+ * Allocates flushBufferCount - 1 more buffers of maxBufferByteSize, sets up
+ * the write backend and starts the flush thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Pointer to configuration used to create the context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails or the thread cannot be started.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the write backend cannot open the file.
+ */
+TextLoggerStatusType TextLogger_FlusherStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Writes every handed over buffer, stops the flush thread and frees the
+ * buffers except the one pTextBuffer points to.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if every buffer was written.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the flush thread failed to write to file.
+ */
+TextLoggerStatusType TextLogger_FlusherStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Hands the first currBytePos bytes of pTextBuffer to the flush thread and
+ * points pTextBuffer to the next buffer, waiting only while all others are in flight.
+ * Called from the thread that owns pTextBuffer.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the flush thread failed to write an earlier buffer.
+ */
+TextLoggerStatusType TextLogger_FlusherSubmit(LoggerContextType* pLoggerContext);
+
+/**
+ * Points the flush thread to a newly opened pLogFile.
+ * @pre no buffer is in flight.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the write backend cannot open the file.
+ */
+TextLoggerStatusType TextLogger_FlusherSetFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Waits until every buffer handed over before this call has been written,
+ * so the caller can use the file directly. Can be called from any thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the flush thread failed to write to file.
+ */
+TextLoggerStatusType TextLogger_FlusherWait(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_uring.c
+ */
+
+/**
+ * Sets up an io_uring instance with at least entryCount submission entries.
+ *
+ * @param [in] entryCount Most writes in flight at once.
+ * @return pointer to io_uring instance.
+ * @return NULL if io_uring is not available on this system.
+ */
+TextLoggerUringType* TextLogger_UringCreate(unsigned int entryCount);
+
+/**
+ * Waits for the writes in flight and frees the io_uring instance.
+ *
+ * @param [in,out] pUring Pointer to io_uring instance.
+ */
+void TextLogger_UringDestroy(TextLoggerUringType* pUring);
+
+/**
+ * Queues a write at a file offset, passed to the kernel by the next TextLogger_UringWait.
+ * pData must stay valid until its completion is reaped.
+ *
+ * @param [in,out] pUring Pointer to io_uring instance.
+ * @param [in] fd File to write to, not opened in append mode.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @param [in] offset File offset of the first byte.
+ * @param [in] userData Value handed back with the completion.
+ * @return true if queued, false if entryCount writes are already in flight.
+ */
+bool TextLogger_UringQueueWrite(TextLoggerUringType* pUring, int fd, const char* pData, size_t length, uint64_t offset, uint64_t userData);
+
+/**
+ * Passes queued writes to the kernel, waits until at least one write in flight
+ * completes and calls pCompletion for every completion available.
+ *
+ * @param [in,out] pUring Pointer to io_uring instance.
+ * @param [in] pCompletion Function called per completion, may be NULL.
+ * @param [in,out] pArg Argument for pCompletion.
+ * @return true if successful, false if the kernel rejected the call.
+ */
+bool TextLogger_UringWait(TextLoggerUringType* pUring, TextLoggerUringCompletionType pCompletion, void* pArg);
+
+/*
+ * text_logger_mmap.c
+ */
+
+/**
+ * Creates the mapping state. The buffer allocated by the context is kept for
+ * pending bytes while no file is mapped.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Pointer to configuration used to create the context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if the platform has no mmap.
+ */
+TextLoggerStatusType TextLogger_MmapStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Frees the mapping state and points pTextBuffer back to the context's own buffer.
+ * @pre the file is closed.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_MmapStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Finds the end of the records of a newly opened file and maps pTextBuffer there.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be extended or mapped.
+ */
+TextLoggerStatusType TextLogger_MmapOpenFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Moves bytes not flushed yet out of the file, unmaps it and trims it to currFileSize.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be trimmed.
+ */
+TextLoggerStatusType TextLogger_MmapCloseFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Flushes pTextBuffer: adds currBytePos to currFileSize and maps the next buffer.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be extended or mapped.
+ */
+TextLoggerStatusType TextLogger_MmapCommit(LoggerContextType* pLoggerContext);
+
+/**
+ * Copies bytes to the mapped file at currFileSize, moving bytes not flushed yet after them.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be extended or mapped.
+ */
+TextLoggerStatusType TextLogger_MmapWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length);
+
+/*
+ * text_logger_gather.c
+ */
+
+/**
+ * Creates the gather state, used for writing messages from the caller's memory.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails.
+ */
+TextLoggerStatusType TextLogger_GatherStart(LoggerContextType* pLoggerContext);
+
+/**
+ * Frees the gather state.
+ * @pre nothing is gathered.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_GatherStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Checks if one more message can be gathered before the next TextLogger_GatherFlush.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return true if there is room for one more message.
+ */
+bool TextLogger_GatherHasRoom(LoggerContextType* pLoggerContext);
+
+/**
+ * Gathers a message after the bytes of pTextBuffer up to currBytePos, without copying it.
+ * pLogText must stay valid until TextLogger_GatherFlush or TextLogger_GatherClear.
+ * @pre TextLogger_GatherHasRoom returned true.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText Log message.
+ * @param [in] textLength Length of log message.
+ */
+void TextLogger_GatherMessage(LoggerContextType* pLoggerContext, const char* pLogText, int textLength);
+
+/**
+ * Gets the number of bytes gathered outside pTextBuffer.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return length of the gathered messages.
+ */
+long int TextLogger_GatherPendingSize(LoggerContextType* pLoggerContext);
+
+/**
+ * Checks if messages are gathered, so flushing pTextBuffer needs TextLogger_GatherFlush.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return true if at least one message is gathered.
+ */
+bool TextLogger_GatherIsPending(LoggerContextType* pLoggerContext);
+
+/**
+ * Forgets the gathered messages without writing them.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_GatherClear(LoggerContextType* pLoggerContext);
+
+/**
+ * Writes the first currBytePos bytes of pTextBuffer with the gathered messages
+ * in between, using as few writev calls as possible, and forgets the messages.
+ * Does not reset currBytePos.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_GatherFlush(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_compress.c
+ */
+
+/**
+ * Creates the compressor, with room for one compressed block of maxBufferByteSize.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails.
+ */
+TextLoggerStatusType TextLogger_CompressStart(LoggerContextType* pLoggerContext);
+
+/**
+ * Frees the compressor.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_CompressStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Compresses bytes into one block of a compressed file: header, then the LZ4
+ * data, or the bytes as they are if they do not shrink.
+ *
+ * @param [in,out] pTable Match finder, tableBase set to 1 before the first block.
+ * @param [in] pSource Bytes to compress.
+ * @param [in] length Number of bytes, at most TEXTLOGGER_LZ_MAX_BLOCK_SIZE.
+ * @param [out] pBlock Destination, TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + TEXTLOGGER_LZ_BOUND(length) bytes.
+ * @return length of the block.
+ */
+size_t TextLogger_CompressPutBlock(TextLoggerLzTableType* pTable, const unsigned char* pSource, size_t length, unsigned char* pBlock);
+
+/**
+ * Starts a newly opened file with the magic of compressed files, or checks it
+ * if the file is not empty: takes over the entries of its index block and
+ * removes it, or drops a last block cut short by a crash.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file is not a compressed log file or cannot be written.
+ */
+TextLoggerStatusType TextLogger_CompressOpenFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Ends the file with the index of its blocks, before it is closed.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the index cannot be written.
+ */
+TextLoggerStatusType TextLogger_CompressCloseFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Counts a record added to pTextBuffer, or written to the file next, in the
+ * index entry of the next block.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] logLevel Level of the record.
+ * @param [in] timeStamp Time at which the record was logged.
+ */
+void TextLogger_CompressAddRecord(LoggerContextType* pLoggerContext, LogLevelType logLevel, time_t timeStamp);
+
+/**
+ * Gets the size of the index block once it has an entry for one more block,
+ * which has to fit within maxFileSize too.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return size of the index block, 0 if the file gets none.
+ */
+long int TextLogger_CompressIndexSize(LoggerContextType* pLoggerContext);
+
+/**
+ * Compresses bytes into one block, kept until TextLogger_CompressWriteBlock
+ * or the next call.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pData Bytes to compress.
+ * @param [in] length Number of bytes, at most maxBufferByteSize.
+ * @return size of the block in the file, header included.
+ */
+long int TextLogger_CompressBlock(LoggerContextType* pLoggerContext, const char* pData, size_t length);
+
+/**
+ * Appends the block made by the last TextLogger_CompressBlock to the file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_CompressWriteBlock(LoggerContextType* pLoggerContext);
+
+/**
+ * Compresses and appends bytes, one block per maxBufferByteSize.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pData Bytes to write.
+ * @param [in] length Number of bytes to write.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_CompressWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length);
+
+/*
+ * text_logger_archive.c
+ */
+
+/**
+ * Starts rotationCompressThreads threads that compress rotated files.
+ * Rotated files left uncompressed by an earlier context are queued again,
+ * after removing what it had written of their compressed copies.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Options with rotationCompressThreads.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation or thread creation fails.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE without POSIX file I/O (Windows).
+ */
+TextLoggerStatusType TextLogger_ArchiveStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Waits until every queued file is compressed, then stops the threads.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_ArchiveStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Keeps the threads from opening or replacing rotated files while they are
+ * renamed, until TextLogger_ArchiveEndRotation.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_ArchiveBeginRotation(LoggerContextType* pLoggerContext);
+
+/**
+ * Moves the queued files along with the renames, gives up those that were
+ * dropped and queues the new file.1.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_ArchiveEndRotation(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_recorder.c
+ */
+
+/**
+ * Creates the flight recorder with a ring of flightRecorderSize bytes.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Options with flightRecorderSize.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails.
+ */
+TextLoggerStatusType TextLogger_RecorderStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Frees the flight recorder and the records still in it.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_RecorderStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Keeps a record in the flight recorder, overwriting the oldest ones if it is full.
+ * Messages longer than half the ring are cut.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText Log message, not null-terminated.
+ * @param [in] textLength Length of log message.
+ * @param [in] logLevel Level of log message.
+ * @param [in] timeStamp Time at which the message was logged.
+ */
+void TextLogger_RecorderAdd(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel, time_t timeStamp);
+
+/**
+ * Takes the oldest record out of the flight recorder.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [out] ppLogText Log message, valid until the next TextLogger_RecorderAdd.
+ * @param [out] pTextLength Length of log message.
+ * @param [out] pLogLevel Level of log message.
+ * @param [out] pTimeStamp Time at which the message was logged.
+ * @return false if the flight recorder is empty.
+ */
+bool TextLogger_RecorderNext(LoggerContextType* pLoggerContext, const char** ppLogText, int* pTextLength, LogLevelType* pLogLevel, time_t* pTimeStamp);
+
+/*
+ * text_logger_crash.c
+ */
+
+/**
+ * Registers the context with the handler of fatal signals, installing the
+ * handler the first time, and duplicates the descriptor of the open log file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails or too many contexts are registered.
+ */
+TextLoggerStatusType TextLogger_CrashStart(LoggerContextType* pLoggerContext);
+
+/**
+ * Unregisters the context from the handler of fatal signals and closes its descriptor.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_CrashStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Replaces the descriptor the handler writes to with one of the newly opened log file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_CrashSetFile(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_persist.c
+ */
+
+/**
+ * Maps the buffer file as pTextBuffer, creating it if needed. Records left in
+ * it by a process that was killed become the pending records of the context.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Options with pBufferFilePath, maxBufferByteSize and format.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be locked or mapped, or holds records of another format or more than fit in the buffer.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if not built for POSIX.
+ */
+TextLoggerStatusType TextLogger_PersistStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Unmaps the buffer file and sets pTextBuffer to NULL. The file is kept.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_PersistStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Marks the records up to currBytePos as complete in the buffer file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_PersistSetWriteHead(LoggerContextType* pLoggerContext);
+
+/**
+ * Marks the buffer file empty once its records are written to the log file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_PersistFlushed(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_daemon.c
+ */
+
+/**
+ * Creates the ring of the context in pDaemonDirPath, with the options the
+ * daemon opens the log file with. The daemon may start before or after.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Options with pDaemonDirPath, daemonRingSize and those of the log file.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if allocation fails or a path or pErrMsg does not fit in the ring header.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the ring file cannot be created or mapped.
+ * @return TEXTLOGGER_ERR_UNSUPPORTED_MODE if not built for POSIX.
+ */
+TextLoggerStatusType TextLogger_DaemonStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Waits until the daemon has written the records in the ring, marks the ring
+ * closed so the daemon removes it, and unmaps it.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return Status of the final flush, see TextLogger_DaemonFlush.
+ */
+TextLoggerStatusType TextLogger_DaemonStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Copies a record into the ring, waiting for room or dropping it as asyncFullPolicy says.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message, without LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @return Status of the last write of the daemon.
+ * @return TEXTLOGGER_ERR_QUEUE_FULL if the ring is full and the record was dropped.
+ */
+TextLoggerStatusType TextLogger_DaemonPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel);
+
+/**
+ * Waits until the daemon has written every record copied into the ring before this call.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return Status of the last write of the daemon.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if no daemon serves the ring.
+ */
+TextLoggerStatusType TextLogger_DaemonFlush(LoggerContextType* pLoggerContext);
+
+/**
+ * Waits until the daemon has written and synced every record copied into the ring before this call.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return Status of the sync of the daemon.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if no daemon serves the ring.
+ */
+TextLoggerStatusType TextLogger_DaemonSync(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_durable.c
+ */
+
+/**
+ * Creates the sync state and, with TEXTLOGGER_DURABILITY_GROUP_COMMIT, starts the sync thread.
+ * Called before the log file is opened.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pConfig Pointer to configuration used to create the context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if the durability options are invalid or the thread cannot be started.
+ */
+TextLoggerStatusType TextLogger_DurableStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig);
+
+/**
+ * Stops the sync thread, syncs the remaining bytes unless durability is
+ * TEXTLOGGER_DURABILITY_NONE and frees the sync state.
+ * @pre everything has been written to file.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if a sync failed.
+ */
+TextLoggerStatusType TextLogger_DurableStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Points the sync state to a newly opened pLogFile, syncing the previous file first.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_DurableSetFile(LoggerContextType* pLoggerContext);
+
+/**
+ * Counts bytes written to the log file. Can be called from any thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] length Number of bytes written.
+ */
+void TextLogger_DurableAddWritten(LoggerContextType* pLoggerContext, size_t length);
+
+/**
+ * Waits until every byte counted so far is synced: for the next group commit,
+ * or syncs right away in the other durability modes. Can be called from any thread.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if a sync failed.
+ */
+TextLoggerStatusType TextLogger_DurableSync(LoggerContextType* pLoggerContext);
+
+/*
+ * text_logger_per_thread.c
+ */
+
+/**
+ * Creates the thread-local key and the registry of thread buffers.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INVALID_INPUT if maxBufferByteSize is too small or allocation fails.
+ */
+TextLoggerStatusType TextLogger_PerThreadStart(LoggerContextType* pLoggerContext);
+
+/**
+ * Merges every thread buffer into pTextBuffer and frees them.
+ * @pre no other thread logs to the context anymore.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ */
+void TextLogger_PerThreadStop(LoggerContextType* pLoggerContext);
+
+/**
+ * Appends a record to the calling thread's buffer without locking.
+ * Merges all thread buffers to file first if the calling thread's buffer is full.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] pLogText String containing log message.
+ * @param [in] textLength Length of log message, without LOG_EXTRA_STR_LENGTH.
+ * @param [in] logLevel Level of log message.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_PerThreadPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel);
+
+/**
+ * Merges every thread buffer into the file in timestamp order.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+TextLoggerStatusType TextLogger_PerThreadFlush(LoggerContextType* pLoggerContext);
+
+/**
+ * Merges every thread buffer, then writes the flight recorder after them.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return same as TextLogger_PerThreadFlush.
+ */
+TextLoggerStatusType TextLogger_PerThreadWriteRecorder(LoggerContextType* pLoggerContext);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _TEXT_LOGGER_INTERNAL_H_
+
+/**
+ * @}
+ */
@@ -0,0 +1,305 @@
+/**
+ * @addtogroup TextLogger
+ * @{
+ */
+
+/**
+ * @brief On-disk layout of log files written with TEXTLOGGER_COMPRESSION_LZ4,
+ * shared by the logger and the textlog_decode tool.
+ *
+ * A file starts with TEXTLOGGER_LZ_MAGIC, followed by blocks, one per flushed buffer:
+ * 1) stored length of the block data as a 32-bit little endian value,
+ *    with TEXTLOGGER_LZ_STORED set if the data is not compressed,
+ * 2) length of the uncompressed data, 32-bit little endian,
+ * 3) TextLogger_LzChecksum of the uncompressed data, 32-bit little endian,
+ * 4) the data: LZ4 block format (sequences of a token, literals, a 16-bit
+ *    offset and a match length), or the uncompressed bytes.
+ * Every block is compressed on its own, so the file can be read up to its
+ * last complete block. Its uncompressed contents are what the file would
+ * hold without compression, e.g. text records or a binary log file.
+ *
+ * When the logger closes the file, it ends it with an index block, flagged
+ * with TEXTLOGGER_LZ_INDEX and stored uncompressed:
+ * 1) one entry of TEXTLOGGER_LZ_INDEX_ENTRY_SIZE bytes per block, in file
+ *    order, see TextLoggerLzIndexEntryType,
+ * 2) the number of entries, 32-bit little endian,
+ * 3) the offset of the first indexed block, 64-bit little endian; blocks
+ *    before it were written before a crash and are not indexed,
+ * 4) TEXTLOGGER_LZ_INDEX_MAGIC.
+ * The index therefore ends the file with a trailer of fixed size, from which
+ * a reader finds the whole index block. A file without one (still open, or
+ * cut short by a crash) is read from the start.
+ */
+
+#ifndef _TEXT_LOGGER_LZ_H_
+#define _TEXT_LOGGER_LZ_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Defines
+ */
+
+#define TEXTLOGGER_LZ_MAGIC                  "TLOGLZ4\001"
+#define TEXTLOGGER_LZ_MAGIC_LENGTH           (8)
+#define TEXTLOGGER_LZ_BLOCK_HEADER_SIZE      (12)
+#define TEXTLOGGER_LZ_STORED                 (0x80000000u) // flag in the stored length
+#define TEXTLOGGER_LZ_INDEX                  (0x40000000u) // flag in the stored length of the index block
+#define TEXTLOGGER_LZ_LENGTH_MASK            (0x3FFFFFFFu) // stored length without flags
+#define TEXTLOGGER_LZ_MAX_BLOCK_SIZE         (4 * 1024 * 1024) // uncompressed bytes, limits maxBufferByteSize
+#define TEXTLOGGER_LZ_MIN_MATCH              (4)
+#define TEXTLOGGER_LZ_BOUND(length)          ((length) + (length) / 255 + 16) // compressed size of incompressible data
+#define TEXTLOGGER_LZ_LEVEL_COUNT            (5) // error ... verbose
+#define TEXTLOGGER_LZ_INDEX_ENTRY_SIZE       (8 + 8 + 8 + 4 * TEXTLOGGER_LZ_LEVEL_COUNT)
+#define TEXTLOGGER_LZ_INDEX_MAGIC            "TLOGIDX\001"
+#define TEXTLOGGER_LZ_INDEX_MAGIC_LENGTH     (8)
+#define TEXTLOGGER_LZ_INDEX_TRAILER_SIZE     (4 + 8 + TEXTLOGGER_LZ_INDEX_MAGIC_LENGTH)
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of one entry of the block index.
+ *
+ * A block that starts no record, e.g. the middle of a record larger than
+ * a buffer, has no level counts and repeats the last timestamp of the
+ * block before it, so timestamps never decrease from entry to entry
+ * unless the clock went back.
+ */
+typedef struct {
+   uint64_t blockOffset; // file offset of the block header
+   int64_t firstTimeStamp; // seconds since the epoch, of the records starting in the block
+   int64_t lastTimeStamp;
+   uint32_t pLevelCounts[TEXTLOGGER_LZ_LEVEL_COUNT]; // records per level, LOG_LEVEL_ERROR first
+} TextLoggerLzIndexEntryType;
+
+/*
+ * Code
+ */
+
+/**
+ * Reads a 32-bit little endian value.
+ *
+ * @param [in] pSource Source bytes.
+ * @return value read.
+ */
+static inline uint32_t TextLogger_LzGet32(const unsigned char* pSource)
+{
+   return (uint32_t) pSource[0] | ((uint32_t) pSource[1] << 8) | ((uint32_t) pSource[2] << 16) | ((uint32_t) pSource[3] << 24);
+}
+
+/**
+ * Writes a 32-bit little endian value.
+ *
+ * @param [out] pDest Destination, 4 bytes.
+ * @param [in] value Value to write.
+ */
+static inline void TextLogger_LzPut32(unsigned char* pDest, uint32_t value)
+{
+   pDest[0] = (unsigned char) value;
+   pDest[1] = (unsigned char) (value >> 8);
+   pDest[2] = (unsigned char) (value >> 16);
+   pDest[3] = (unsigned char) (value >> 24);
+}
+
+/**
+ * Reads a 64-bit little endian value.
+ *
+ * @param [in] pSource Source bytes.
+ * @return value read.
+ */
+static inline uint64_t TextLogger_LzGet64(const unsigned char* pSource)
+{
+   return (uint64_t) TextLogger_LzGet32(pSource) | ((uint64_t) TextLogger_LzGet32(pSource + 4) << 32);
+}
+
+/**
+ * Writes a 64-bit little endian value.
+ *
+ * @param [out] pDest Destination, 8 bytes.
+ * @param [in] value Value to write.
+ */
+static inline void TextLogger_LzPut64(unsigned char* pDest, uint64_t value)
+{
+   TextLogger_LzPut32(pDest, (uint32_t) value);
+   TextLogger_LzPut32(pDest + 4, (uint32_t) (value >> 32));
+}
+
+/**
+ * Reads an index entry.
+ *
+ * @param [in] pSource TEXTLOGGER_LZ_INDEX_ENTRY_SIZE bytes.
+ * @param [out] pEntry Entry read.
+ */
+static inline void TextLogger_LzGetIndexEntry(const unsigned char* pSource, TextLoggerLzIndexEntryType* pEntry)
+{
+   pEntry->blockOffset = TextLogger_LzGet64(pSource);
+   pEntry->firstTimeStamp = (int64_t) TextLogger_LzGet64(pSource + 8);
+   pEntry->lastTimeStamp = (int64_t) TextLogger_LzGet64(pSource + 16);
+   for (int index = 0; index < TEXTLOGGER_LZ_LEVEL_COUNT; index++) {
+      pEntry->pLevelCounts[index] = TextLogger_LzGet32(pSource + 24 + 4 * index);
+   }
+}
+
+/**
+ * Writes an index entry.
+ *
+ * @param [out] pDest Destination, TEXTLOGGER_LZ_INDEX_ENTRY_SIZE bytes.
+ * @param [in] pEntry Entry to write.
+ */
+static inline void TextLogger_LzPutIndexEntry(unsigned char* pDest, const TextLoggerLzIndexEntryType* pEntry)
+{
+   TextLogger_LzPut64(pDest, pEntry->blockOffset);
+   TextLogger_LzPut64(pDest + 8, (uint64_t) pEntry->firstTimeStamp);
+   TextLogger_LzPut64(pDest + 16, (uint64_t) pEntry->lastTimeStamp);
+   for (int index = 0; index < TEXTLOGGER_LZ_LEVEL_COUNT; index++) {
+      TextLogger_LzPut32(pDest + 24 + 4 * index, pEntry->pLevelCounts[index]);
+   }
+}
+
+/**
+ * Rotates a 32-bit value left.
+ *
+ * @param [in] value Value to rotate.
+ * @param [in] count Number of bits, 1 to 31.
+ * @return rotated value.
+ */
+static inline uint32_t TextLogger_LzRotate(uint32_t value, int count)
+{
+   return (value << count) | (value >> (32 - count));
+}
+
+/**
+ * Computes the checksum of a block: 32-bit xxHash with seed 0.
+ *
+ * @param [in] pData Bytes to check.
+ * @param [in] length Number of bytes.
+ * @return checksum.
+ */
+static inline uint32_t TextLogger_LzChecksum(const unsigned char* pData, size_t length)
+{
+   const uint32_t prime1 = 0x9E3779B1u, prime2 = 0x85EBCA77u, prime3 = 0xC2B2AE3Du, prime4 = 0x27D4EB2Fu, prime5 = 0x165667B1u;
+   const unsigned char* pEnd = pData + length;
+   uint32_t hash;
+
+   if (16 <= length) {
+      uint32_t lane1 = prime1 + prime2;
+      uint32_t lane2 = prime2;
+      uint32_t lane3 = 0;
+      uint32_t lane4 = 0 - prime1;
+      do {
+         lane1 = TextLogger_LzRotate(lane1 + TextLogger_LzGet32(pData) * prime2, 13) * prime1;
+         lane2 = TextLogger_LzRotate(lane2 + TextLogger_LzGet32(pData + 4) * prime2, 13) * prime1;
+         lane3 = TextLogger_LzRotate(lane3 + TextLogger_LzGet32(pData + 8) * prime2, 13) * prime1;
+         lane4 = TextLogger_LzRotate(lane4 + TextLogger_LzGet32(pData + 12) * prime2, 13) * prime1;
+         pData += 16;
+      } while (pData + 16 <= pEnd);
+      hash = TextLogger_LzRotate(lane1, 1) + TextLogger_LzRotate(lane2, 7) + TextLogger_LzRotate(lane3, 12) + TextLogger_LzRotate(lane4, 18);
+   } else {
+      hash = prime5;
+   }
+   hash += (uint32_t) length;
+
+   while (pData + 4 <= pEnd) {
+      hash = TextLogger_LzRotate(hash + TextLogger_LzGet32(pData) * prime3, 17) * prime4;
+      pData += 4;
+   }
+   while (pData < pEnd) {
+      hash = TextLogger_LzRotate(hash + *pData * prime5, 11) * prime1;
+      pData++;
+   }
+
+   hash ^= hash >> 15;
+   hash *= prime2;
+   hash ^= hash >> 13;
+   hash *= prime3;
+   hash ^= hash >> 16;
+   return hash;
+}
+
+/**
+ * Reads the extra bytes of a literal or match length of 15 or more.
+ *
+ * @param [in] pSource Compressed data.
+ * @param [in] sourceLength Length of pSource.
+ * @param [in,out] pPos Read position in pSource.
+ * @param [in,out] pLength Length to add to.
+ * @return false if pSource ends first.
+ */
+static inline bool TextLogger_LzGetLength(const unsigned char* pSource, size_t sourceLength, size_t* pPos, size_t* pLength)
+{
+   unsigned char byte;
+   do {
+      if (*pPos >= sourceLength) {
+         return false;
+      }
+      byte = pSource[(*pPos)++];
+      *pLength += byte;
+   } while (255 == byte);
+   return true;
+}
+
+/**
+ * Decompresses LZ4 block data, checking every length and offset.
+ *
+ * @param [in] pSource Compressed data.
+ * @param [in] sourceLength Length of pSource.
+ * @param [out] pDest Destination.
+ * @param [in] destLength Uncompressed length.
+ * @return true if pSource decompresses to exactly destLength bytes.
+ */
+static inline bool TextLogger_LzDecompress(const unsigned char* pSource, size_t sourceLength, unsigned char* pDest, size_t destLength)
+{
+   size_t sourcePos = 0;
+   size_t destPos = 0;
+
+   while (sourcePos < sourceLength) {
+      unsigned char token = pSource[sourcePos++];
+
+      // literals
+      size_t length = token >> 4;
+      if (15 == length && !TextLogger_LzGetLength(pSource, sourceLength, &sourcePos, &length)) {
+         return false;
+      }
+      if (length > sourceLength - sourcePos || length > destLength - destPos) {
+         return false;
+      }
+      memcpy(pDest + destPos, pSource + sourcePos, length);
+      sourcePos += length;
+      destPos += length;
+      if (sourcePos == sourceLength) {
+         break; // last sequence has no match
+      }
+
+      // match, may overlap the bytes it produces
+      if (2 > sourceLength - sourcePos) {
+         return false;
+      }
+      size_t offset = (size_t) pSource[sourcePos] | ((size_t) pSource[sourcePos + 1] << 8);
+      sourcePos += 2;
+      length = token & 0x0F;
+      if (15 == length && !TextLogger_LzGetLength(pSource, sourceLength, &sourcePos, &length)) {
+         return false;
+      }
+      length += TEXTLOGGER_LZ_MIN_MATCH;
+      if (0 == offset || offset > destPos || length > destLength - destPos) {
+         return false;
+      }
+      for (size_t index = 0; index < length; index++) {
+         pDest[destPos + index] = pDest[destPos - offset + index];
+      }
+      destPos += length;
+   }
+
+   return (destPos == destLength);
+}
+
+#endif // _TEXT_LOGGER_LZ_H_
+
+/**
+ * @}
+ */
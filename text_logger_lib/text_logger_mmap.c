@@ -0,0 +1,307 @@
+#define _GNU_SOURCE // pread, posix_fallocate, fileno, MAP_POPULATE
+
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+#ifndef _WIN32
+
+/*
+ * Defines
+ */
+
+// fault the whole window in with one call instead of one fault per page while logging
+#ifdef MAP_POPULATE
+#define TEXTLOGGER_MAP_POPULATE  (MAP_POPULATE)
+#else
+#define TEXTLOGGER_MAP_POPULATE  (0)
+#endif
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the mapped window of a log file.
+ *
+ * The file is preallocated chunkSize bytes at a time and pTextBuffer points
+ * into the window at currFileSize, so records are formatted straight into the
+ * page cache and a flush only moves currFileSize. Bytes past currFileSize are
+ * zero until written and trimmed when the file is closed.
+ */
+struct TextLoggerMmap{
+   char* pHeapBuffer; // buffer allocated by the context, holds pending bytes while no window is mapped
+   char* pWindow; // NULL if nothing is mapped
+   long int windowOffset; // file offset of pWindow[0], page aligned
+   size_t windowSize;
+   size_t chunkSize; // multiple of the page size, holds at least one buffer wherever it starts
+   long int allocatedSize; // file size including preallocated bytes
+   long int pageSize;
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Finds the end of the records of a text log file: a file not closed by its
+ * context still ends with preallocated zero bytes, text records never do.
+ *
+ * @param [in] fd File descriptor.
+ * @param [in] fileSize Size of the file.
+ * @return size of the file without trailing zero bytes.
+ */
+static long int TextLogger_MmapDataEnd(int fd, long int fileSize)
+{
+   char pBlock[4096];
+   long int end = fileSize;
+   while (0 < end) {
+      long int start = (end > (long int) sizeof(pBlock)) ? end - (long int) sizeof(pBlock) : 0;
+      if ((ssize_t) (end - start) != pread(fd, pBlock, end - start, (off_t) start)) {
+         return end; // keep what cannot be checked
+      }
+      for (long int index = end - start - 1; index >= 0; index--) {
+         if ('\0' != pBlock[index]) {
+            return start + index + 1;
+         }
+      }
+      end = start;
+   }
+   return 0;
+}
+
+/**
+ * @internal
+ *
+ * Maps a window covering [offset, offset + length), preallocating the file
+ * if the window reaches past its end.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @param [in] offset First file offset that must be mapped.
+ * @param [in] length Number of bytes that must be mapped.
+ * @return pointer to the byte at offset.
+ * @return NULL if the file cannot be extended or mapped.
+ */
+static char* TextLogger_MmapMapWindow(LoggerContextType* pLoggerContext, long int offset, size_t length)
+{
+   TextLoggerMmapType* pMmap = pLoggerContext->pMmap;
+   if (NULL != pMmap->pWindow && offset >= pMmap->windowOffset &&
+       offset + (long int) length <= pMmap->windowOffset + (long int) pMmap->windowSize) {
+      return pMmap->pWindow + (offset - pMmap->windowOffset);
+   }
+
+   if (NULL != pMmap->pWindow) {
+      munmap(pMmap->pWindow, pMmap->windowSize);
+      pMmap->pWindow = NULL;
+   }
+
+   // a page aligned window of one chunk, the file must be at least that large or writes fault
+   int fd = fileno(pLoggerContext->pLogFile);
+   long int windowOffset = offset - offset % pMmap->pageSize;
+   long int windowEnd = windowOffset + (long int) pMmap->chunkSize;
+   if (windowEnd > pMmap->allocatedSize) {
+      // reserved blocks, so a full disk fails here instead of on a page fault; sparse where unsupported
+      if (0 != posix_fallocate(fd, (off_t) pMmap->allocatedSize, (off_t) (windowEnd - pMmap->allocatedSize)) &&
+          0 != ftruncate(fd, (off_t) windowEnd)) {
+         return NULL;
+      }
+      pMmap->allocatedSize = windowEnd;
+   }
+   void* pWindow = mmap(NULL, pMmap->chunkSize, PROT_READ | PROT_WRITE, MAP_SHARED | TEXTLOGGER_MAP_POPULATE, fd, (off_t) windowOffset);
+   if (MAP_FAILED == pWindow) {
+      return NULL;
+   }
+   pMmap->pWindow = (char*) pWindow;
+   pMmap->windowOffset = windowOffset;
+   pMmap->windowSize = pMmap->chunkSize;
+
+   return pMmap->pWindow + (offset - windowOffset);
+}
+
+/**
+ * @internal
+ *
+ * Points pTextBuffer to currFileSize in the mapped file, carrying over the currBytePos bytes not flushed yet.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if the file cannot be extended or mapped.
+ */
+static TextLoggerStatusType TextLogger_MmapPlaceBuffer(LoggerContextType* pLoggerContext)
+{
+   TextLoggerMmapType* pMmap = pLoggerContext->pMmap;
+
+   // pending bytes survive a remap in the heap buffer
+   bool windowIsCovering = (NULL != pMmap->pWindow && pLoggerContext->currFileSize >= pMmap->windowOffset &&
+                            pLoggerContext->currFileSize + pLoggerContext->maxBufferByteSize <= pMmap->windowOffset + (long int) pMmap->windowSize);
+   if (!windowIsCovering && 0 < pLoggerContext->currBytePos && pLoggerContext->pTextBuffer != pMmap->pHeapBuffer) {
+      memcpy(pMmap->pHeapBuffer, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+      pLoggerContext->pTextBuffer = pMmap->pHeapBuffer;
+   }
+
+   char* pTextBuffer = TextLogger_MmapMapWindow(pLoggerContext, pLoggerContext->currFileSize, pLoggerContext->maxBufferByteSize);
+   if (NULL == pTextBuffer) {
+      pLoggerContext->pTextBuffer = pMmap->pHeapBuffer; // logging continues in memory, the next flush fails
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   if (0 < pLoggerContext->currBytePos && pLoggerContext->pTextBuffer != pTextBuffer) {
+      memmove(pTextBuffer, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+   }
+   pLoggerContext->pTextBuffer = pTextBuffer;
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_MmapStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   TextLoggerMmapType* pMmap = (TextLoggerMmapType*) calloc(1, sizeof(TextLoggerMmapType));
+   if (NULL == pMmap) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pMmap->pHeapBuffer = pLoggerContext->pTextBuffer;
+   pMmap->pageSize = sysconf(_SC_PAGESIZE);
+
+   // whole pages, and room for a full buffer starting anywhere in the first page
+   size_t minChunkSize = (size_t) pLoggerContext->maxBufferByteSize + (size_t) pMmap->pageSize;
+   pMmap->chunkSize = (pConfig->mmapChunkSize > 0 && (size_t) pConfig->mmapChunkSize > minChunkSize) ? (size_t) pConfig->mmapChunkSize : minChunkSize;
+   pMmap->chunkSize = (pMmap->chunkSize + pMmap->pageSize - 1) / pMmap->pageSize * pMmap->pageSize;
+
+   pLoggerContext->pMmap = pMmap;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_MmapStop(LoggerContextType* pLoggerContext)
+{
+   // the context frees its own buffer
+   pLoggerContext->pTextBuffer = pLoggerContext->pMmap->pHeapBuffer;
+   free(pLoggerContext->pMmap);
+   pLoggerContext->pMmap = NULL;
+}
+
+TextLoggerStatusType TextLogger_MmapOpenFile(LoggerContextType* pLoggerContext)
+{
+   TextLoggerMmapType* pMmap = pLoggerContext->pMmap;
+
+   // records continue after the last one, not after the preallocated tail of an unclean shutdown
+   pMmap->allocatedSize = pLoggerContext->currFileSize;
+   pLoggerContext->currFileSize = TextLogger_MmapDataEnd(fileno(pLoggerContext->pLogFile), pLoggerContext->currFileSize);
+
+   return TextLogger_MmapPlaceBuffer(pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_MmapCloseFile(LoggerContextType* pLoggerContext)
+{
+   TextLoggerMmapType* pMmap = pLoggerContext->pMmap;
+
+   // bytes not flushed yet go to the next file
+   if (0 < pLoggerContext->currBytePos && pLoggerContext->pTextBuffer != pMmap->pHeapBuffer) {
+      memcpy(pMmap->pHeapBuffer, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+   }
+   pLoggerContext->pTextBuffer = pMmap->pHeapBuffer;
+
+   if (NULL != pMmap->pWindow) {
+      munmap(pMmap->pWindow, pMmap->windowSize);
+      pMmap->pWindow = NULL;
+   }
+
+   // drop the preallocated tail
+   if (pMmap->allocatedSize > pLoggerContext->currFileSize &&
+       0 != ftruncate(fileno(pLoggerContext->pLogFile), (off_t) pLoggerContext->currFileSize)) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pMmap->allocatedSize = pLoggerContext->currFileSize;
+
+   return TEXTLOGGER_SUCCESS;
+}
+
+TextLoggerStatusType TextLogger_MmapCommit(LoggerContextType* pLoggerContext)
+{
+   // the records are already in the file
+   pLoggerContext->currFileSize += pLoggerContext->currBytePos;
+   TextLogger_DurableAddWritten(pLoggerContext, pLoggerContext->currBytePos);
+   pLoggerContext->currBytePos = 0;
+
+   return TextLogger_MmapPlaceBuffer(pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_MmapWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length)
+{
+   TextLoggerMmapType* pMmap = pLoggerContext->pMmap;
+
+   // the window is overwritten from currFileSize on, keep pending bytes aside
+   if (0 < pLoggerContext->currBytePos && pLoggerContext->pTextBuffer != pMmap->pHeapBuffer) {
+      memcpy(pMmap->pHeapBuffer, pLoggerContext->pTextBuffer, pLoggerContext->currBytePos);
+      pLoggerContext->pTextBuffer = pMmap->pHeapBuffer;
+   }
+
+   while (0 < length) {
+      size_t chunkLength = (length < (size_t) pLoggerContext->maxBufferByteSize) ? length : (size_t) pLoggerContext->maxBufferByteSize;
+      char* pDest = TextLogger_MmapMapWindow(pLoggerContext, pLoggerContext->currFileSize, chunkLength);
+      if (NULL == pDest) {
+         return TEXTLOGGER_ERR_FILE_ERROR;
+      }
+      memcpy(pDest, pData, chunkLength);
+      pLoggerContext->currFileSize += chunkLength;
+      TextLogger_DurableAddWritten(pLoggerContext, chunkLength);
+      pData += chunkLength;
+      length -= chunkLength;
+   }
+
+   return TextLogger_MmapPlaceBuffer(pLoggerContext);
+}
+
+#else // no mmap on Windows
+
+TextLoggerStatusType TextLogger_MmapStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   (void) pLoggerContext;
+   (void) pConfig;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+void TextLogger_MmapStop(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+TextLoggerStatusType TextLogger_MmapOpenFile(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_MmapCloseFile(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_MmapCommit(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+TextLoggerStatusType TextLogger_MmapWrite(LoggerContextType* pLoggerContext, const char* pData, size_t length)
+{
+   (void) pLoggerContext;
+   (void) pData;
+   (void) length;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+#endif // _WIN32
@@ -0,0 +1,387 @@
+#define _POSIX_C_SOURCE 200809L // clock_gettime
+
+/* system headers */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+#define RECORD_ALIGNMENT         (16) // same as sizeof(TextLoggerThreadRecordType), so padding header always fits at the end of the ring
+#define RECORD_PADDING           (-1) // textLength of a record telling the reader to skip to the start of the ring
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the header in front of
+ * every message stored in a thread buffer.
+ */
+typedef struct {
+   uint64_t timeStampNs; // CLOCK_REALTIME, used to merge thread buffers in order
+   int32_t textLength; // RECORD_PADDING for the filler at the end of the ring
+   int32_t logLevel;
+} TextLoggerThreadRecordType;
+
+/**
+ * @brief This is the structure type of one thread's buffer.
+ *
+ * Single-producer/single-consumer byte ring: only the owning thread
+ * moves writePos, only the flushing thread (holding flushLock) moves readPos.
+ */
+typedef struct TextLoggerThreadBuffer{
+   struct TextLoggerThreadBuffer* pNext;
+   unsigned char* pRecords;
+   size_t capacity;
+   atomic_size_t writePos;
+   atomic_size_t readPos;
+   atomic_bool ownerHasExited; // set by the thread-local destructor, buffer is freed after its last flush
+} TextLoggerThreadBufferType;
+
+/**
+ * @brief This is the structure type of the per-thread state of a logger context.
+ */
+struct TextLoggerPerThread{
+   pthread_key_t bufferKey; // thread-local TextLoggerThreadBufferType*
+   TextLoggerThreadBufferType* pBuffers; // every registered thread buffer
+   pthread_mutex_t registryLock; // guards pBuffers
+   pthread_mutex_t flushLock; // guards pTextBuffer and the log file
+   size_t bufferByteSize;
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Rounds a record size up to RECORD_ALIGNMENT.
+ *
+ * @param [in] byteSize Size of header and text.
+ * @return aligned size.
+ */
+static size_t TextLogger_PerThreadAlign(size_t byteSize)
+{
+   return (byteSize + RECORD_ALIGNMENT - 1) & ~((size_t) RECORD_ALIGNMENT - 1);
+}
+
+/**
+ * @internal
+ *
+ * Thread-local destructor: marks the buffer of an exiting thread so the next flush frees it.
+ *
+ * @param [in,out] pArg Pointer to thread buffer.
+ */
+static void TextLogger_PerThreadOwnerExit(void* pArg)
+{
+   TextLoggerThreadBufferType* pBuffer = (TextLoggerThreadBufferType*) pArg;
+   atomic_store(&pBuffer->ownerHasExited, true);
+}
+
+/**
+ * @internal
+ *
+ * Returns the calling thread's buffer, registering a new one on first use.
+ *
+ * @param [in,out] pPerThread Pointer to per-thread state.
+ * @return pointer to thread buffer or NULL if allocation fails.
+ */
+static TextLoggerThreadBufferType* TextLogger_PerThreadGetBuffer(TextLoggerPerThreadType* pPerThread)
+{
+   TextLoggerThreadBufferType* pBuffer = (TextLoggerThreadBufferType*) pthread_getspecific(pPerThread->bufferKey);
+   if (NULL != pBuffer) {
+      return pBuffer;
+   }
+
+   pBuffer = (TextLoggerThreadBufferType*) malloc(sizeof(TextLoggerThreadBufferType));
+   if (NULL == pBuffer) {
+      return NULL;
+   }
+   pBuffer->pRecords = (unsigned char*) malloc(pPerThread->bufferByteSize);
+   if (NULL == pBuffer->pRecords) {
+      free(pBuffer);
+      return NULL;
+   }
+   pBuffer->capacity = pPerThread->bufferByteSize;
+   atomic_init(&pBuffer->writePos, 0);
+   atomic_init(&pBuffer->readPos, 0);
+   atomic_init(&pBuffer->ownerHasExited, false);
+
+   pthread_mutex_lock(&pPerThread->registryLock);
+   pBuffer->pNext = pPerThread->pBuffers;
+   pPerThread->pBuffers = pBuffer;
+   pthread_mutex_unlock(&pPerThread->registryLock);
+
+   pthread_setspecific(pPerThread->bufferKey, pBuffer);
+   return pBuffer;
+}
+
+/**
+ * @internal
+ *
+ * Returns the next unread record of a thread buffer, skipping the padding at the end of the ring.
+ *
+ * @param [in,out] pBuffer Pointer to thread buffer.
+ * @param [in,out] pReadPos Read position, moved past padding.
+ * @param [in] writePos Write position snapshot.
+ * @return pointer to record or NULL if nothing is left before writePos.
+ */
+static TextLoggerThreadRecordType* TextLogger_PerThreadPeek(TextLoggerThreadBufferType* pBuffer, size_t* pReadPos, size_t writePos)
+{
+   while (*pReadPos != writePos) {
+      size_t offset = *pReadPos % pBuffer->capacity;
+      TextLoggerThreadRecordType* pRecord = (TextLoggerThreadRecordType*) (pBuffer->pRecords + offset);
+      if (RECORD_PADDING != pRecord->textLength) {
+         return pRecord;
+      }
+      *pReadPos += pBuffer->capacity - offset;
+   }
+   return NULL;
+}
+
+/**
+ * @internal
+ *
+ * Merges all thread buffers into pTextBuffer in timestamp order and writes it to file.
+ * @pre flushLock is held.
+ *
+ * @param [in,out] pLoggerContext Pointer to logger context.
+ * @return TEXTLOGGER_SUCCESS if operation is successful.
+ * @return TEXTLOGGER_ERR_INSUFFICIENT_FILE_SPACE if max file size has been reached.
+ * @return TEXTLOGGER_ERR_FILE_ERROR if an error occurs during file-related operations.
+ */
+static TextLoggerStatusType TextLogger_PerThreadMerge(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPerThreadType* pPerThread = pLoggerContext->pPerThread;
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+
+   // snapshot registered buffers, new ones are only ever pushed at the head
+   pthread_mutex_lock(&pPerThread->registryLock);
+   TextLoggerThreadBufferType* pHead = pPerThread->pBuffers;
+   pthread_mutex_unlock(&pPerThread->registryLock);
+
+   int bufferCount = 0;
+   for (TextLoggerThreadBufferType* pBuffer = pHead; NULL != pBuffer; pBuffer = pBuffer->pNext) {
+      bufferCount++;
+   }
+   if (0 == bufferCount) {
+      return TextLogger_FlushBuffer(pLoggerContext);
+   }
+
+   TextLoggerThreadBufferType** ppBuffers = (TextLoggerThreadBufferType**) malloc(bufferCount * sizeof(TextLoggerThreadBufferType*));
+   size_t* pReadPos = (size_t*) malloc(bufferCount * sizeof(size_t));
+   size_t* pWritePos = (size_t*) malloc(bufferCount * sizeof(size_t));
+   if (NULL == ppBuffers || NULL == pReadPos || NULL == pWritePos) {
+      free(ppBuffers);
+      free(pReadPos);
+      free(pWritePos);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   int index = 0;
+   for (TextLoggerThreadBufferType* pBuffer = pHead; NULL != pBuffer; pBuffer = pBuffer->pNext) {
+      ppBuffers[index] = pBuffer;
+      pReadPos[index] = atomic_load_explicit(&pBuffer->readPos, memory_order_relaxed);
+      pWritePos[index] = atomic_load_explicit(&pBuffer->writePos, memory_order_acquire);
+      index++;
+   }
+
+   // k-way merge: always take the oldest pending record
+   while (true) {
+      int oldest = -1;
+      TextLoggerThreadRecordType* pOldest = NULL;
+      for (index = 0; index < bufferCount; index++) {
+         TextLoggerThreadRecordType* pRecord = TextLogger_PerThreadPeek(ppBuffers[index], &pReadPos[index], pWritePos[index]);
+         if (NULL != pRecord && (NULL == pOldest || pRecord->timeStampNs < pOldest->timeStampNs)) {
+            oldest = index;
+            pOldest = pRecord;
+         }
+      }
+      if (NULL == pOldest) {
+         break;
+      }
+
+      TextLoggerStatusType writeStatus = TextLogger_WriteToBuffer(pLoggerContext, (const char*) (pOldest + 1),
+                                                                  pOldest->textLength + LOG_EXTRA_STR_LENGTH,
+                                                                  (LogLevelType) pOldest->logLevel,
+                                                                  (time_t) (pOldest->timeStampNs / 1000000000ULL));
+      if (TEXTLOGGER_SUCCESS != writeStatus) {
+         status = writeStatus;
+      }
+
+      // give space back to the owning thread
+      pReadPos[oldest] += TextLogger_PerThreadAlign(sizeof(TextLoggerThreadRecordType) + pOldest->textLength);
+      atomic_store_explicit(&ppBuffers[oldest]->readPos, pReadPos[oldest], memory_order_release);
+   }
+   for (index = 0; index < bufferCount; index++) {
+      atomic_store_explicit(&ppBuffers[index]->readPos, pReadPos[index], memory_order_release);
+   }
+
+   free(ppBuffers);
+   free(pReadPos);
+   free(pWritePos);
+
+   TextLoggerStatusType flushStatus = TextLogger_FlushBuffer(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS != flushStatus) {
+      status = flushStatus;
+   }
+
+   // free buffers of exited threads that are now empty
+   pthread_mutex_lock(&pPerThread->registryLock);
+   TextLoggerThreadBufferType** ppLink = &pPerThread->pBuffers;
+   while (NULL != *ppLink) {
+      TextLoggerThreadBufferType* pBuffer = *ppLink;
+      if (atomic_load(&pBuffer->ownerHasExited) &&
+          atomic_load(&pBuffer->readPos) == atomic_load(&pBuffer->writePos)) {
+         *ppLink = pBuffer->pNext;
+         free(pBuffer->pRecords);
+         free(pBuffer);
+      } else {
+         ppLink = &pBuffer->pNext;
+      }
+   }
+   pthread_mutex_unlock(&pPerThread->registryLock);
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_PerThreadStart(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPerThreadType* pPerThread = (TextLoggerPerThreadType*) malloc(sizeof(TextLoggerPerThreadType));
+   if (NULL == pPerThread) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   if (0 != pthread_key_create(&pPerThread->bufferKey, TextLogger_PerThreadOwnerExit)) {
+      free(pPerThread);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pPerThread->pBuffers = NULL;
+   pPerThread->bufferByteSize = TextLogger_PerThreadAlign(pLoggerContext->maxBufferByteSize);
+   if (pPerThread->bufferByteSize < 4 * sizeof(TextLoggerThreadRecordType)) {
+      pthread_key_delete(pPerThread->bufferKey);
+      free(pPerThread);
+      return TEXTLOGGER_ERR_INVALID_INPUT; // maxBufferByteSize is too small
+   }
+   pthread_mutex_init(&pPerThread->registryLock, NULL);
+   pthread_mutex_init(&pPerThread->flushLock, NULL);
+
+   pLoggerContext->pPerThread = pPerThread;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_PerThreadStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPerThreadType* pPerThread = pLoggerContext->pPerThread;
+
+   // merge what is left, the caller flushes pTextBuffer afterwards
+   pthread_mutex_lock(&pPerThread->flushLock);
+   TextLogger_PerThreadMerge(pLoggerContext);
+   pthread_mutex_unlock(&pPerThread->flushLock);
+
+   pthread_key_delete(pPerThread->bufferKey);
+   while (NULL != pPerThread->pBuffers) {
+      TextLoggerThreadBufferType* pBuffer = pPerThread->pBuffers;
+      pPerThread->pBuffers = pBuffer->pNext;
+      free(pBuffer->pRecords);
+      free(pBuffer);
+   }
+
+   pthread_mutex_destroy(&pPerThread->flushLock);
+   pthread_mutex_destroy(&pPerThread->registryLock);
+   free(pPerThread);
+   pLoggerContext->pPerThread = NULL;
+}
+
+TextLoggerStatusType TextLogger_PerThreadPush(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel)
+{
+   TextLoggerPerThreadType* pPerThread = pLoggerContext->pPerThread;
+   TextLoggerThreadBufferType* pBuffer = TextLogger_PerThreadGetBuffer(pPerThread);
+   if (NULL == pBuffer) {
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // a record may take at most half the ring so it always fits after padding,
+   // larger ones are written after everything buffered so far instead of being truncated
+   size_t maxTextLength = pBuffer->capacity / 2 - sizeof(TextLoggerThreadRecordType);
+   if ((size_t) textLength > maxTextLength) {
+      pthread_mutex_lock(&pPerThread->flushLock);
+      TextLoggerStatusType status = TextLogger_PerThreadMerge(pLoggerContext);
+      if (TEXTLOGGER_SUCCESS == status) {
+         status = TextLogger_WriteToBuffer(pLoggerContext, pLogText, textLength + LOG_EXTRA_STR_LENGTH, logLevel, time(NULL));
+      }
+      pthread_mutex_unlock(&pPerThread->flushLock);
+      return status;
+   }
+   size_t recordByteSize = TextLogger_PerThreadAlign(sizeof(TextLoggerThreadRecordType) + textLength);
+
+   struct timespec now;
+   clock_gettime(CLOCK_REALTIME, &now);
+
+   size_t writePos = atomic_load_explicit(&pBuffer->writePos, memory_order_relaxed);
+   size_t offset = writePos % pBuffer->capacity;
+   size_t paddingByteSize = (pBuffer->capacity - offset < recordByteSize) ? (pBuffer->capacity - offset) : 0;
+
+   // make room: merge every thread buffer into the file
+   TextLoggerStatusType status = TEXTLOGGER_SUCCESS;
+   size_t readPos = atomic_load_explicit(&pBuffer->readPos, memory_order_acquire);
+   if (pBuffer->capacity - (writePos - readPos) < paddingByteSize + recordByteSize) {
+      pthread_mutex_lock(&pPerThread->flushLock);
+      status = TextLogger_PerThreadMerge(pLoggerContext);
+      pthread_mutex_unlock(&pPerThread->flushLock);
+      if (TEXTLOGGER_SUCCESS != status) {
+         return status;
+      }
+   }
+
+   if (0 != paddingByteSize) {
+      TextLoggerThreadRecordType* pPadding = (TextLoggerThreadRecordType*) (pBuffer->pRecords + offset);
+      pPadding->textLength = RECORD_PADDING;
+      writePos += paddingByteSize;
+      offset = 0;
+   }
+
+   TextLoggerThreadRecordType* pRecord = (TextLoggerThreadRecordType*) (pBuffer->pRecords + offset);
+   pRecord->timeStampNs = (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+   pRecord->textLength = textLength;
+   pRecord->logLevel = logLevel;
+   memcpy(pRecord + 1, pLogText, textLength);
+
+   atomic_store_explicit(&pBuffer->writePos, writePos + recordByteSize, memory_order_release);
+   return status;
+}
+
+TextLoggerStatusType TextLogger_PerThreadFlush(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPerThreadType* pPerThread = pLoggerContext->pPerThread;
+
+   pthread_mutex_lock(&pPerThread->flushLock);
+   TextLoggerStatusType status = TextLogger_PerThreadMerge(pLoggerContext);
+   pthread_mutex_unlock(&pPerThread->flushLock);
+
+   return status;
+}
+
+TextLoggerStatusType TextLogger_PerThreadWriteRecorder(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPerThreadType* pPerThread = pLoggerContext->pPerThread;
+
+   pthread_mutex_lock(&pPerThread->flushLock);
+   TextLoggerStatusType status = TextLogger_PerThreadMerge(pLoggerContext);
+   TextLoggerStatusType recorderStatus = TextLogger_WriteFlightRecorder(pLoggerContext);
+   pthread_mutex_unlock(&pPerThread->flushLock);
+
+   return (TEXTLOGGER_SUCCESS != status) ? status : recorderStatus;
+}
@@ -0,0 +1,182 @@
+#define _POSIX_C_SOURCE 200809L // pread, posix_fallocate, ftruncate
+
+/* system headers */
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+#include "text_logger_persist.h"
+
+#ifndef _WIN32
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the buffer file of a logger context.
+ *
+ * pTextBuffer points right after the header of the mapped file, so the page
+ * cache holds every formatted record and outlives the process. The header is
+ * updated as records are added and flushed, see text_logger_persist.h.
+ */
+struct TextLoggerPersist{
+   int fd; // kept open for its lock, so two processes never map the same buffer
+   TextLoggerPersistHeaderType* pHeader; // start of the mapping
+   size_t mappedSize;
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Reads the header of an existing buffer file and checks that the records
+ * it holds can be carried over to a context with this configuration.
+ *
+ * @param [in] fd File descriptor of the buffer file.
+ * @param [in] fileSize Size of the buffer file, not 0.
+ * @param [in] pConfig Options of the new context.
+ * @param [out] pHeader Header read.
+ * @return true if the records fit in the new buffer and have the same format.
+ */
+static bool TextLogger_PersistReadHeader(int fd, off_t fileSize, const TextLoggerConfigType* pConfig, TextLoggerPersistHeaderType* pHeader)
+{
+   if ((ssize_t) sizeof(TextLoggerPersistHeaderType) != pread(fd, pHeader, sizeof(TextLoggerPersistHeaderType), 0) ||
+       0 != memcmp(pHeader->pMagic, TEXTLOGGER_PERSIST_MAGIC, TEXTLOGGER_PERSIST_MAGIC_LENGTH)) {
+      return false;
+   }
+   if (pHeader->writeHead > pHeader->bufferSize || (off_t) (TEXTLOGGER_PERSIST_HEADER_SIZE + pHeader->bufferSize) > fileSize) {
+      return false;
+   }
+   return (uint32_t) pConfig->format == pHeader->format && (uint64_t) pConfig->maxBufferByteSize >= pHeader->writeHead;
+}
+
+TextLoggerStatusType TextLogger_PersistStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   TextLoggerPersistType* pPersist = (TextLoggerPersistType*) malloc(sizeof(TextLoggerPersistType));
+   if (NULL == pPersist) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pPersist->fd = open(pConfig->pBufferFilePath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+   if (0 > pPersist->fd) {
+      free(pPersist);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // a buffer file belongs to one process at a time, the lock goes away with it
+   struct flock lock;
+   memset(&lock, 0, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+   struct stat fileStatus;
+   if (-1 == fcntl(pPersist->fd, F_SETLK, &lock) || 0 != fstat(pPersist->fd, &fileStatus)) {
+      close(pPersist->fd);
+      free(pPersist);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // records left by a killed process stay at the start of the data; a file that cannot take them is left to textlog_decode
+   TextLoggerPersistHeaderType header;
+   memset(&header, 0, sizeof(header));
+   if (0 < fileStatus.st_size && !TextLogger_PersistReadHeader(pPersist->fd, fileStatus.st_size, pConfig, &header)) {
+      close(pPersist->fd);
+      free(pPersist);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // blocks are reserved now, so a full disk or /dev/shm fails here instead of raising SIGBUS while logging; sparse where unsupported
+   pPersist->mappedSize = TEXTLOGGER_PERSIST_HEADER_SIZE + (size_t) pConfig->maxBufferByteSize;
+   if (0 != ftruncate(pPersist->fd, (off_t) pPersist->mappedSize) || ENOSPC == posix_fallocate(pPersist->fd, 0, (off_t) pPersist->mappedSize)) {
+      close(pPersist->fd);
+      free(pPersist);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   void* pMapping = mmap(NULL, pPersist->mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, pPersist->fd, 0);
+   if (MAP_FAILED == pMapping) {
+      close(pPersist->fd);
+      free(pPersist);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+   pPersist->pHeader = (TextLoggerPersistHeaderType*) pMapping;
+
+   // the magic goes last, a file cut short before it is not taken for a buffer file
+   pPersist->pHeader->bufferSize = (uint32_t) pConfig->maxBufferByteSize;
+   pPersist->pHeader->format = (uint32_t) pConfig->format;
+   pPersist->pHeader->sequence = header.sequence;
+   pPersist->pHeader->writeHead = header.writeHead;
+   memcpy(pPersist->pHeader->pMagic, TEXTLOGGER_PERSIST_MAGIC, TEXTLOGGER_PERSIST_MAGIC_LENGTH);
+
+   pLoggerContext->pPersist = pPersist;
+   pLoggerContext->pTextBuffer = (char*) pMapping + TEXTLOGGER_PERSIST_HEADER_SIZE;
+   pLoggerContext->currBytePos = (int) header.writeHead;
+   pLoggerContext->totalBytesStored = (int) header.writeHead;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_PersistStop(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPersistType* pPersist = pLoggerContext->pPersist;
+
+   // the file is kept: it is empty after a successful flush, or holds what the next context writes first
+   munmap(pPersist->pHeader, pPersist->mappedSize);
+   close(pPersist->fd);
+   free(pPersist);
+   pLoggerContext->pPersist = NULL;
+   pLoggerContext->pTextBuffer = NULL;
+}
+
+void TextLogger_PersistSetWriteHead(LoggerContextType* pLoggerContext)
+{
+   // the records are in the mapping before the head covers them
+   atomic_thread_fence(memory_order_release);
+   pLoggerContext->pPersist->pHeader->writeHead = (uint64_t) pLoggerContext->currBytePos;
+}
+
+void TextLogger_PersistFlushed(LoggerContextType* pLoggerContext)
+{
+   TextLoggerPersistHeaderType* pHeader = pLoggerContext->pPersist->pHeader;
+   pHeader->writeHead = 0;
+   pHeader->sequence++;
+}
+
+#else
+
+TextLoggerStatusType TextLogger_PersistStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   (void) pLoggerContext;
+   (void) pConfig;
+   return TEXTLOGGER_ERR_UNSUPPORTED_MODE;
+}
+
+void TextLogger_PersistStop(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+void TextLogger_PersistSetWriteHead(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+void TextLogger_PersistFlushed(LoggerContextType* pLoggerContext)
+{
+   (void) pLoggerContext;
+}
+
+#endif // _WIN32
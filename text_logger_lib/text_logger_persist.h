@@ -0,0 +1,56 @@
+/**
+ * @addtogroup TextLogger
+ * @{
+ */
+
+/**
+ * @brief Layout of the buffer files of TextLoggerConfigType.pBufferFilePath,
+ * shared by the logger and the textlog_decode tool.
+ *
+ * The file is mapped by the process that logs, so it always holds the
+ * records not flushed yet, even after the process is killed:
+ * 1) a header of TEXTLOGGER_PERSIST_HEADER_SIZE bytes, see
+ *    TextLoggerPersistHeaderType, in the byte order of the machine that
+ *    wrote it,
+ * 2) the data: bufferSize bytes of which the first writeHead bytes are
+ *    records exactly as they are written to the log file (text lines, or
+ *    binary records of which the first has an absolute timestamp, without
+ *    TEXTLOGGER_BINARY_MAGIC), never compressed.
+ * writeHead only moves past a record once the record is complete, and is
+ * set back to 0, with sequence incremented, once the records are written
+ * to the log file.
+ */
+
+#ifndef _TEXT_LOGGER_PERSIST_H_
+#define _TEXT_LOGGER_PERSIST_H_
+
+#include <stdint.h>
+
+/*
+ * Defines
+ */
+
+#define TEXTLOGGER_PERSIST_MAGIC             "TLOGBUF\001"
+#define TEXTLOGGER_PERSIST_MAGIC_LENGTH      (8)
+#define TEXTLOGGER_PERSIST_HEADER_SIZE       (64) // data starts here, cache line aligned
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the header at the start of a buffer file.
+ */
+typedef struct {
+   char pMagic[TEXTLOGGER_PERSIST_MAGIC_LENGTH]; // TEXTLOGGER_PERSIST_MAGIC, written last when the file is created
+   uint32_t bufferSize; // bytes of data after the header
+   uint32_t format; // TextLoggerFormatType of the records: 0 text, 1 binary
+   uint64_t sequence; // number of times the records were written to the log file
+   uint64_t writeHead; // bytes of complete records at the start of the data, not written to the log file yet
+} TextLoggerPersistHeaderType;
+
+#endif // _TEXT_LOGGER_PERSIST_H_
+
+/**
+ * @}
+ */
@@ -0,0 +1,170 @@
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+/*
+ * Defines
+ */
+
+#define RECORD_ALIGNMENT         (16) // same as sizeof(TextLoggerRecorderEntryType), so padding header always fits at the end of the ring
+#define RECORD_PADDING           (-1) // textLength of an entry telling the reader to skip to the start of the ring
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the header in front of
+ * every message stored in the flight recorder.
+ */
+typedef struct {
+   int64_t timeStamp;
+   int32_t textLength; // RECORD_PADDING for the filler at the end of the ring
+   int32_t logLevel;
+} TextLoggerRecorderEntryType;
+
+/**
+ * @brief This is the structure type of the flight recorder of a logger context.
+ *
+ * Byte ring of the most recent records less important than the context's level.
+ * A new record overwrites the oldest ones until it fits. Only the thread that
+ * formats into pTextBuffer touches it, so it needs no lock.
+ */
+struct TextLoggerRecorder{
+   unsigned char* pEntries;
+   size_t capacity; // multiple of RECORD_ALIGNMENT
+   size_t readPos; // oldest entry
+   size_t writePos; // next entry, readPos == writePos when empty
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Rounds an entry size up to RECORD_ALIGNMENT.
+ *
+ * @param [in] byteSize Size of header and text.
+ * @return aligned size.
+ */
+static size_t TextLogger_RecorderAlign(size_t byteSize)
+{
+   return (byteSize + RECORD_ALIGNMENT - 1) & ~((size_t) RECORD_ALIGNMENT - 1);
+}
+
+/**
+ * @internal
+ *
+ * Drops the oldest entry, or the padding in front of it.
+ *
+ * @param [in,out] pRecorder Pointer to flight recorder.
+ */
+static void TextLogger_RecorderDropOldest(TextLoggerRecorderType* pRecorder)
+{
+   size_t offset = pRecorder->readPos % pRecorder->capacity;
+   TextLoggerRecorderEntryType* pEntry = (TextLoggerRecorderEntryType*) (pRecorder->pEntries + offset);
+   if (RECORD_PADDING == pEntry->textLength) {
+      pRecorder->readPos += pRecorder->capacity - offset;
+      return;
+   }
+   pRecorder->readPos += TextLogger_RecorderAlign(sizeof(TextLoggerRecorderEntryType) + pEntry->textLength);
+}
+
+TextLoggerStatusType TextLogger_RecorderStart(LoggerContextType* pLoggerContext, const TextLoggerConfigType* pConfig)
+{
+   TextLoggerRecorderType* pRecorder = (TextLoggerRecorderType*) calloc(1, sizeof(TextLoggerRecorderType));
+   if (NULL == pRecorder) {
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+   pRecorder->capacity = (size_t) pConfig->flightRecorderSize & ~((size_t) RECORD_ALIGNMENT - 1);
+   pRecorder->pEntries = (unsigned char*) malloc(pRecorder->capacity);
+   if (NULL == pRecorder->pEntries) {
+      free(pRecorder);
+      return TEXTLOGGER_ERR_INVALID_INPUT;
+   }
+
+   pLoggerContext->pRecorder = pRecorder;
+   return TEXTLOGGER_SUCCESS;
+}
+
+void TextLogger_RecorderStop(LoggerContextType* pLoggerContext)
+{
+   free(pLoggerContext->pRecorder->pEntries);
+   free(pLoggerContext->pRecorder);
+   pLoggerContext->pRecorder = NULL;
+}
+
+void TextLogger_RecorderAdd(LoggerContextType* pLoggerContext, const char* pLogText, int textLength, LogLevelType logLevel, time_t timeStamp)
+{
+   TextLoggerRecorderType* pRecorder = pLoggerContext->pRecorder;
+
+   // a record may take at most half the ring so it always fits after padding, longer ones are cut
+   int maxTextLength = (int) (pRecorder->capacity / 2 - sizeof(TextLoggerRecorderEntryType));
+   if (textLength > maxTextLength) {
+      textLength = maxTextLength;
+   }
+   size_t entryByteSize = TextLogger_RecorderAlign(sizeof(TextLoggerRecorderEntryType) + textLength);
+
+   // make room: overwrite the oldest records, an empty ring starts over at its beginning
+   size_t offset;
+   size_t paddingByteSize;
+   while (true) {
+      if (pRecorder->readPos == pRecorder->writePos) {
+         pRecorder->readPos = 0;
+         pRecorder->writePos = 0;
+      }
+      offset = pRecorder->writePos % pRecorder->capacity;
+      paddingByteSize = (pRecorder->capacity - offset < entryByteSize) ? (pRecorder->capacity - offset) : 0;
+      if (pRecorder->capacity - (pRecorder->writePos - pRecorder->readPos) >= paddingByteSize + entryByteSize) {
+         break;
+      }
+      TextLogger_RecorderDropOldest(pRecorder);
+   }
+
+   if (0 != paddingByteSize) {
+      TextLoggerRecorderEntryType* pPadding = (TextLoggerRecorderEntryType*) (pRecorder->pEntries + offset);
+      pPadding->textLength = RECORD_PADDING;
+      pRecorder->writePos += paddingByteSize;
+      offset = 0;
+   }
+
+   TextLoggerRecorderEntryType* pEntry = (TextLoggerRecorderEntryType*) (pRecorder->pEntries + offset);
+   pEntry->timeStamp = (int64_t) timeStamp;
+   pEntry->textLength = textLength;
+   pEntry->logLevel = logLevel;
+   memcpy(pEntry + 1, pLogText, textLength);
+   pRecorder->writePos += entryByteSize;
+}
+
+bool TextLogger_RecorderNext(LoggerContextType* pLoggerContext, const char** ppLogText, int* pTextLength, LogLevelType* pLogLevel, time_t* pTimeStamp)
+{
+   TextLoggerRecorderType* pRecorder = pLoggerContext->pRecorder;
+
+   while (pRecorder->readPos != pRecorder->writePos) {
+      size_t offset = pRecorder->readPos % pRecorder->capacity;
+      TextLoggerRecorderEntryType* pEntry = (TextLoggerRecorderEntryType*) (pRecorder->pEntries + offset);
+      if (RECORD_PADDING == pEntry->textLength) {
+         pRecorder->readPos += pRecorder->capacity - offset;
+         continue;
+      }
+
+      // entry stays in place until the next record is added
+      *ppLogText = (const char*) (pEntry + 1);
+      *pTextLength = pEntry->textLength;
+      *pLogLevel = (LogLevelType) pEntry->logLevel;
+      *pTimeStamp = (time_t) pEntry->timeStamp;
+      pRecorder->readPos += TextLogger_RecorderAlign(sizeof(TextLoggerRecorderEntryType) + pEntry->textLength);
+      return true;
+   }
+
+   return false;
+}
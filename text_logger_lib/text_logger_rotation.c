@@ -0,0 +1,146 @@
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_binary.h"
+#include "text_logger_internal.h"
+#include "text_logger_lz.h"
+
+/*
+ * Code
+ */
+
+void TextLogger_RotatedFilePath(char* pDest, const char* pFilePath, int index, const char* pSuffix)
+{
+   if (0 == index) {
+      strcpy(pDest, pFilePath);
+   } else {
+      sprintf(pDest, "%s.%d%s", pFilePath, index, pSuffix);
+   }
+}
+
+/**
+ * @internal
+ *
+ * Returns the size of a log file without any record.
+ *
+ * @param [in] pLoggerContext Pointer to logger context.
+ * @return size of file header.
+ */
+static long int TextLogger_EmptyFileSize(LoggerContextType* pLoggerContext)
+{
+   long int binaryMagicLength = (TEXTLOGGER_FORMAT_BINARY == pLoggerContext->format) ? TEXTLOGGER_BINARY_MAGIC_LENGTH : 0;
+
+   // compressed file: its magic, then the binary magic stored in a block of its own
+   if (NULL != pLoggerContext->pCompress) {
+      return TEXTLOGGER_LZ_MAGIC_LENGTH + ((0 < binaryMagicLength) ? TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + binaryMagicLength : 0);
+   }
+   return binaryMagicLength;
+}
+
+bool TextLogger_RotationIntervalHasElapsed(LoggerContextType* pLoggerContext)
+{
+   if (0 >= pLoggerContext->rotationMaxFiles || 0 >= pLoggerContext->rotationIntervalSec || NULL == pLoggerContext->pLogFile) {
+      return false;
+   }
+
+   // nothing to rotate away yet
+   if (pLoggerContext->currFileSize <= TextLogger_EmptyFileSize(pLoggerContext)) {
+      return false;
+   }
+
+   return (time(NULL) - pLoggerContext->fileOpenTime >= pLoggerContext->rotationIntervalSec);
+}
+
+TextLoggerStatusType TextLogger_RotateBeforeRecord(LoggerContextType* pLoggerContext, int recordLength)
+{
+   if (0 >= pLoggerContext->rotationMaxFiles) {
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   // record still fits in the current file
+   long int fileSizeAfterFlush = pLoggerContext->currFileSize + pLoggerContext->currBytePos;
+   if (NULL != pLoggerContext->pGather) {
+      fileSizeAfterFlush += TextLogger_GatherPendingSize(pLoggerContext);
+   }
+   long int indexLength = (NULL != pLoggerContext->pCompress) ? TextLogger_CompressIndexSize(pLoggerContext) : 0; // written when the file is closed
+   if (fileSizeAfterFlush + indexLength + recordLength <= pLoggerContext->maxFileSize) {
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   // a record larger than maxFileSize gets a file of its own
+   if (fileSizeAfterFlush <= TextLogger_EmptyFileSize(pLoggerContext)) {
+      return TEXTLOGGER_SUCCESS;
+   }
+
+   // finish the current file with what is buffered, then start a new one
+   TextLoggerStatusType status = TextLogger_FlushBuffer(pLoggerContext);
+   if (TEXTLOGGER_SUCCESS != status) {
+      return status;
+   }
+   if (pLoggerContext->currFileSize <= TextLogger_EmptyFileSize(pLoggerContext)) {
+      return TEXTLOGGER_SUCCESS; // flush already rotated on time
+   }
+   return TextLogger_RotateFile(pLoggerContext);
+}
+
+TextLoggerStatusType TextLogger_RotateFile(LoggerContextType* pLoggerContext)
+{
+   size_t pathSize = strlen(pLoggerContext->pFilePath) + ROTATED_PATH_SUFFIX_SIZE;
+   char* pOldPath = (char*) malloc(pathSize);
+   char* pNewPath = (char*) malloc(pathSize);
+   if (NULL == pOldPath || NULL == pNewPath) {
+      free(pOldPath);
+      free(pNewPath);
+      return TEXTLOGGER_ERR_FILE_ERROR;
+   }
+
+   // buffers in flight belong to the old file, a write error stays pending for the next flush
+   if (NULL != pLoggerContext->pFlusher) {
+      TextLogger_FlusherWait(pLoggerContext);
+   }
+
+   // close active file
+   TextLogger_CloseFile(pLoggerContext);
+
+   // drop the oldest file, then shift file.N-1 -> file.N ... file -> file.1
+   // compressed copies move along, the compressing threads wait for the renames
+   TextLoggerArchiveType* pArchive = pLoggerContext->pArchive;
+   if (NULL != pArchive) {
+      TextLogger_ArchiveBeginRotation(pLoggerContext);
+   }
+   TextLogger_RotatedFilePath(pNewPath, pLoggerContext->pFilePath, pLoggerContext->rotationMaxFiles, "");
+   remove(pNewPath);
+   if (NULL != pArchive) {
+      TextLogger_RotatedFilePath(pNewPath, pLoggerContext->pFilePath, pLoggerContext->rotationMaxFiles, ARCHIVE_FILE_SUFFIX);
+      remove(pNewPath);
+   }
+   for (int index = pLoggerContext->rotationMaxFiles - 1; index >= 0; index--) {
+      TextLogger_RotatedFilePath(pOldPath, pLoggerContext->pFilePath, index, "");
+      TextLogger_RotatedFilePath(pNewPath, pLoggerContext->pFilePath, index + 1, "");
+      rename(pOldPath, pNewPath); // missing files are skipped
+      if (NULL != pArchive && 0 < index) {
+         TextLogger_RotatedFilePath(pOldPath, pLoggerContext->pFilePath, index, ARCHIVE_FILE_SUFFIX);
+         TextLogger_RotatedFilePath(pNewPath, pLoggerContext->pFilePath, index + 1, ARCHIVE_FILE_SUFFIX);
+         rename(pOldPath, pNewPath);
+      }
+   }
+   if (NULL != pArchive) {
+      TextLogger_ArchiveEndRotation(pLoggerContext);
+   }
+
+   free(pOldPath);
+   free(pNewPath);
+
+   // pending buffer goes to the new file
+   pLoggerContext->totalBytesStored = pLoggerContext->currBytePos;
+   pLoggerContext->fileLimitIsReached = false;
+
+   return TextLogger_OpenFile(pLoggerContext);
+}
@@ -0,0 +1,258 @@
+#define _GNU_SOURCE // syscall
+
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* local headers */
+#include "text_logger.h"
+#include "text_logger_internal.h"
+
+#if defined(__linux__) && !defined(TEXTLOGGER_NO_IO_URING)
+
+/* system headers */
+#include <errno.h>
+#include <stdatomic.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of an io_uring instance used by the flush thread.
+ *
+ * Talks to the kernel through the raw system calls so no library is needed.
+ * Only the flush thread touches it.
+ */
+struct TextLoggerUring{
+   int ringFd;
+   unsigned int entryCount;
+   unsigned int pendingCount; // queued, not yet passed to the kernel
+   unsigned int inFlightCount; // queued or passed, completion not reaped yet
+
+   void* pSqRing;
+   size_t sqRingSize;
+   void* pCqRing; // same mapping as pSqRing with IORING_FEAT_SINGLE_MMAP
+   size_t cqRingSize;
+   struct io_uring_sqe* pSqes;
+   size_t sqesSize;
+
+   _Atomic unsigned int* pSqTail;
+   unsigned int* pSqMask;
+   unsigned int* pSqArray;
+   _Atomic unsigned int* pCqHead;
+   _Atomic unsigned int* pCqTail;
+   unsigned int* pCqMask;
+   struct io_uring_cqe* pCqes;
+
+   struct iovec* pIovecs; // one per submission slot, read by the kernel when the write is submitted
+};
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Unmaps the rings and closes the io_uring instance.
+ *
+ * @param [in,out] pUring Pointer to io_uring instance.
+ */
+static void TextLogger_UringFree(TextLoggerUringType* pUring)
+{
+   if (NULL != pUring->pSqes) {
+      munmap(pUring->pSqes, pUring->sqesSize);
+   }
+   if (NULL != pUring->pCqRing && pUring->pCqRing != pUring->pSqRing) {
+      munmap(pUring->pCqRing, pUring->cqRingSize);
+   }
+   if (NULL != pUring->pSqRing) {
+      munmap(pUring->pSqRing, pUring->sqRingSize);
+   }
+   if (0 <= pUring->ringFd) {
+      close(pUring->ringFd);
+   }
+   free(pUring->pIovecs);
+   free(pUring);
+}
+
+TextLoggerUringType* TextLogger_UringCreate(unsigned int entryCount)
+{
+   TextLoggerUringType* pUring = (TextLoggerUringType*) calloc(1, sizeof(TextLoggerUringType));
+   if (NULL == pUring) {
+      return NULL;
+   }
+   pUring->ringFd = -1;
+
+   // fails with ENOSYS on old kernels and EPERM where io_uring is disabled
+   struct io_uring_params params;
+   memset(&params, 0, sizeof(params));
+   pUring->ringFd = (int) syscall(__NR_io_uring_setup, entryCount, &params);
+   if (0 > pUring->ringFd) {
+      TextLogger_UringFree(pUring);
+      return NULL;
+   }
+   pUring->entryCount = params.sq_entries;
+
+   pUring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+   pUring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      if (pUring->cqRingSize > pUring->sqRingSize) {
+         pUring->sqRingSize = pUring->cqRingSize;
+      }
+      pUring->cqRingSize = pUring->sqRingSize;
+   }
+   pUring->pSqRing = mmap(NULL, pUring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pUring->ringFd, IORING_OFF_SQ_RING);
+   if (MAP_FAILED == pUring->pSqRing) {
+      pUring->pSqRing = NULL;
+      TextLogger_UringFree(pUring);
+      return NULL;
+   }
+   if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      pUring->pCqRing = pUring->pSqRing;
+   } else {
+      pUring->pCqRing = mmap(NULL, pUring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pUring->ringFd, IORING_OFF_CQ_RING);
+      if (MAP_FAILED == pUring->pCqRing) {
+         pUring->pCqRing = NULL;
+         TextLogger_UringFree(pUring);
+         return NULL;
+      }
+   }
+   pUring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+   pUring->pSqes = (struct io_uring_sqe*) mmap(NULL, pUring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pUring->ringFd, IORING_OFF_SQES);
+   if (MAP_FAILED == pUring->pSqes) {
+      pUring->pSqes = NULL;
+      TextLogger_UringFree(pUring);
+      return NULL;
+   }
+   pUring->pIovecs = (struct iovec*) calloc(params.sq_entries, sizeof(struct iovec));
+   if (NULL == pUring->pIovecs) {
+      TextLogger_UringFree(pUring);
+      return NULL;
+   }
+
+   char* pSqRing = (char*) pUring->pSqRing;
+   char* pCqRing = (char*) pUring->pCqRing;
+   pUring->pSqTail = (_Atomic unsigned int*) (pSqRing + params.sq_off.tail);
+   pUring->pSqMask = (unsigned int*) (pSqRing + params.sq_off.ring_mask);
+   pUring->pSqArray = (unsigned int*) (pSqRing + params.sq_off.array);
+   pUring->pCqHead = (_Atomic unsigned int*) (pCqRing + params.cq_off.head);
+   pUring->pCqTail = (_Atomic unsigned int*) (pCqRing + params.cq_off.tail);
+   pUring->pCqMask = (unsigned int*) (pCqRing + params.cq_off.ring_mask);
+   pUring->pCqes = (struct io_uring_cqe*) (pCqRing + params.cq_off.cqes);
+
+   return pUring;
+}
+
+void TextLogger_UringDestroy(TextLoggerUringType* pUring)
+{
+   // the kernel may still read buffers of writes in flight
+   while (0 < pUring->inFlightCount) {
+      if (!TextLogger_UringWait(pUring, NULL, NULL)) {
+         break;
+      }
+   }
+   TextLogger_UringFree(pUring);
+}
+
+bool TextLogger_UringQueueWrite(TextLoggerUringType* pUring, int fd, const char* pData, size_t length, uint64_t offset, uint64_t userData)
+{
+   if (pUring->inFlightCount == pUring->entryCount) {
+      return false;
+   }
+
+   // only this thread produces submissions, so the tail is read without ordering
+   unsigned int tail = atomic_load_explicit(pUring->pSqTail, memory_order_relaxed);
+   unsigned int slot = tail & *pUring->pSqMask;
+   pUring->pIovecs[slot].iov_base = (void*) pData;
+   pUring->pIovecs[slot].iov_len = length;
+
+   struct io_uring_sqe* pSqe = &pUring->pSqes[slot];
+   memset(pSqe, 0, sizeof(*pSqe));
+   pSqe->opcode = IORING_OP_WRITEV; // IORING_OP_WRITE needs 5.6, writev works since io_uring exists
+   pSqe->fd = fd;
+   pSqe->addr = (uint64_t) (uintptr_t) &pUring->pIovecs[slot];
+   pSqe->len = 1;
+   pSqe->off = offset;
+   pSqe->user_data = userData;
+   pUring->pSqArray[slot] = slot;
+   atomic_store_explicit(pUring->pSqTail, tail + 1, memory_order_release);
+
+   pUring->pendingCount++;
+   pUring->inFlightCount++;
+   return true;
+}
+
+bool TextLogger_UringWait(TextLoggerUringType* pUring, TextLoggerUringCompletionType pCompletion, void* pArg)
+{
+   if (0 == pUring->inFlightCount) {
+      return true;
+   }
+
+   // submit queued writes and block until at least one completes
+   int submittedCount;
+   do {
+      submittedCount = (int) syscall(__NR_io_uring_enter, pUring->ringFd, pUring->pendingCount, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+   } while (0 > submittedCount && EINTR == errno);
+   if (0 > submittedCount) {
+      return false;
+   }
+   pUring->pendingCount -= (unsigned int) submittedCount;
+
+   // reap every completion available
+   unsigned int head = atomic_load_explicit(pUring->pCqHead, memory_order_relaxed);
+   unsigned int tail = atomic_load_explicit(pUring->pCqTail, memory_order_acquire);
+   while (head != tail) {
+      struct io_uring_cqe* pCqe = &pUring->pCqes[head & *pUring->pCqMask];
+      if (NULL != pCompletion) {
+         pCompletion(pArg, pCqe->user_data, pCqe->res);
+      }
+      head++;
+      pUring->inFlightCount--;
+   }
+   atomic_store_explicit(pUring->pCqHead, head, memory_order_release);
+
+   return true;
+}
+
+#else // no io_uring: the flush thread uses pwrite
+
+TextLoggerUringType* TextLogger_UringCreate(unsigned int entryCount)
+{
+   (void) entryCount;
+   return NULL;
+}
+
+void TextLogger_UringDestroy(TextLoggerUringType* pUring)
+{
+   (void) pUring;
+}
+
+bool TextLogger_UringQueueWrite(TextLoggerUringType* pUring, int fd, const char* pData, size_t length, uint64_t offset, uint64_t userData)
+{
+   (void) pUring;
+   (void) fd;
+   (void) pData;
+   (void) length;
+   (void) offset;
+   (void) userData;
+   return false;
+}
+
+bool TextLogger_UringWait(TextLoggerUringType* pUring, TextLoggerUringCompletionType pCompletion, void* pArg)
+{
+   (void) pUring;
+   (void) pCompletion;
+   (void) pArg;
+   return false;
+}
+
+#endif // __linux__
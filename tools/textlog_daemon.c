@@ -0,0 +1,59 @@
+#define _POSIX_C_SOURCE 200809L // sigaction
+
+/* system headers */
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+/* local headers */
+#include "../text_logger_lib/text_logger.h"
+
+/*
+ * Code
+ */
+
+/**
+ * @internal
+ *
+ * Handler of SIGINT and SIGTERM: the daemon writes what the rings hold, then exits.
+ *
+ * @param [in] signalNumber Signal being handled.
+ */
+static void Daemon_HandleStop(int signalNumber)
+{
+   (void) signalNumber;
+   TextLogger_StopDaemon();
+}
+
+/**
+ * main runs the collector of TEXTLOGGER_MODE_DAEMON contexts: every process
+ * created with pDaemonDirPath set to the directory only copies its records
+ * into a shared-memory ring there, this process formats and writes them.
+ * Run it as the user of the logging processes, it opens the files they name.
+ *
+ * usage: textlog_daemon <directory>
+ *
+ * @return 0 once stopped by SIGINT or SIGTERM.
+ * @return -1 if the directory cannot be served.
+ */
+int main(int argc, char* argv[])
+{
+   if (2 != argc) {
+      fprintf(stderr, "usage: %s <directory>\n", argv[0]);
+      return -1;
+   }
+
+   struct sigaction action;
+   memset(&action, 0, sizeof(action));
+   action.sa_handler = Daemon_HandleStop;
+   sigemptyset(&action.sa_mask);
+   sigaction(SIGINT, &action, NULL);
+   sigaction(SIGTERM, &action, NULL);
+
+   TextLoggerStatusType status = TextLogger_RunDaemon(argv[1]);
+   if (TEXTLOGGER_SUCCESS != status) {
+      fprintf(stderr, "textlog_daemon: cannot serve %s (status %d), is another daemon running?\n", argv[1], (int) status);
+      return -1;
+   }
+   return 0;
+}
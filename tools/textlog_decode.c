@@ -0,0 +1,669 @@
+#define _POSIX_C_SOURCE 200809L // localtime_r
+
+/* system headers */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* local headers */
+#include "../text_logger_lib/text_logger_binary.h"
+#include "../text_logger_lib/text_logger_lz.h"
+#include "../text_logger_lib/text_logger_persist.h"
+
+/*
+ * Defines
+ */
+
+#define READ_CHUNK_SIZE          (64 * 1024)
+#define TIMESTAMP_STR_LENGTH     (24) // "[YYYY-MM-DD | HH:MM:SS] " of text records
+
+/*
+ * Structures
+ */
+
+/**
+ * @brief This is the structure type of the input reader.
+ *
+ * Holds a window of the input file so records can be
+ * parsed without loading the whole file in memory.
+ * A compressed file is read one block at a time, the window
+ * and offsets then refer to the decompressed contents. Of a buffer
+ * file only the records before its write head are read.
+ */
+typedef struct {
+   FILE* pFile;
+   unsigned char* pData;
+   size_t capacity;
+   size_t length; // bytes in pData
+   size_t pos; // parse position in pData
+   long int fileOffset; // file offset of pData[0], for error messages
+   bool isCompressed; // file starts with TEXTLOGGER_LZ_MAGIC
+   bool isBufferFile; // file starts with TEXTLOGGER_PERSIST_MAGIC
+   uint64_t unreadLength; // bytes of the buffer file's records not read yet
+   bool blockIsBad; // a compressed block is truncated or corrupt, nothing after it is read
+   long int blockOffset; // file offset of the next compressed block
+   unsigned char* pBlock; // decompressed block
+   size_t blockLength;
+   size_t blockPos;
+   unsigned char* pCompressed; // compressed block as read from the file
+   long int stopOffset; // blocks from this file offset on are not read, 0 reads every block
+   bool rangeIsSet; // only records logged from fromTimeStamp to toTimeStamp are printed
+   int64_t fromTimeStamp;
+   int64_t toTimeStamp;
+} DecodeReaderType;
+
+/**
+ * @brief This is the structure type of the block index read from a compressed file.
+ */
+typedef struct {
+   TextLoggerLzIndexEntryType* pEntries;
+   uint32_t entryCount;
+   long int firstIndexedOffset; // blocks before it are not indexed
+   long int indexOffset; // file offset of the index block, the end of the blocks
+} DecodeIndexType;
+
+/*
+ * Static
+ */
+
+static const char* spLevelTags[] = { NULL, "[E]: ", "[W]: ", "[I]: ", "[D]: ", "[V]: " };
+
+/*
+ * Codes
+ */
+
+/**
+ * Reads and decompresses the next block of a compressed file into pBlock.
+ *
+ * @param [in,out] pReader Pointer to reader.
+ * @return true if a block was read, false at the end of the file or at a bad block.
+ */
+static bool Decode_NextBlock(DecodeReaderType* pReader)
+{
+   if (0 != pReader->stopOffset && pReader->blockOffset >= pReader->stopOffset) {
+      return false;
+   }
+   unsigned char pHeader[TEXTLOGGER_LZ_BLOCK_HEADER_SIZE];
+   size_t headerLength = fread(pHeader, 1, TEXTLOGGER_LZ_BLOCK_HEADER_SIZE, pReader->pFile);
+   if (0 == headerLength) {
+      return false;
+   }
+
+   // the index ends the blocks
+   if (TEXTLOGGER_LZ_BLOCK_HEADER_SIZE == headerLength && 0 != (TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_INDEX)) {
+      pReader->stopOffset = pReader->blockOffset;
+      return false;
+   }
+
+   uint32_t storedLength = TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_LENGTH_MASK;
+   uint32_t rawLength = TextLogger_LzGet32(pHeader + 4);
+   bool isStored = (0 != (TextLogger_LzGet32(pHeader) & TEXTLOGGER_LZ_STORED));
+   if (TEXTLOGGER_LZ_BLOCK_HEADER_SIZE != headerLength || TEXTLOGGER_LZ_MAX_BLOCK_SIZE < rawLength ||
+       TEXTLOGGER_LZ_BOUND(rawLength) < storedLength || (isStored && storedLength != rawLength)) {
+      fprintf(stderr, "textlog_decode: truncated or corrupt block at offset %ld\n", pReader->blockOffset);
+      pReader->blockIsBad = true;
+      return false;
+   }
+
+   // buffers grow to the largest block seen
+   if (NULL == pReader->pBlock) {
+      pReader->pBlock = (unsigned char*) malloc(TEXTLOGGER_LZ_MAX_BLOCK_SIZE);
+      pReader->pCompressed = (unsigned char*) malloc(TEXTLOGGER_LZ_BOUND(TEXTLOGGER_LZ_MAX_BLOCK_SIZE));
+      if (NULL == pReader->pBlock || NULL == pReader->pCompressed) {
+         fprintf(stderr, "textlog_decode: out of memory\n");
+         pReader->blockIsBad = true;
+         return false;
+      }
+   }
+
+   bool blockIsRead = (storedLength == fread(pReader->pCompressed, 1, storedLength, pReader->pFile));
+   if (blockIsRead && isStored) {
+      memcpy(pReader->pBlock, pReader->pCompressed, rawLength);
+   } else if (blockIsRead) {
+      blockIsRead = TextLogger_LzDecompress(pReader->pCompressed, storedLength, pReader->pBlock, rawLength);
+   }
+   if (!blockIsRead || TextLogger_LzGet32(pHeader + 8) != TextLogger_LzChecksum(pReader->pBlock, rawLength)) {
+      fprintf(stderr, "textlog_decode: truncated or corrupt block at offset %ld\n", pReader->blockOffset);
+      pReader->blockIsBad = true;
+      return false;
+   }
+
+   pReader->blockOffset += TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + storedLength;
+   pReader->blockLength = rawLength;
+   pReader->blockPos = 0;
+   return true;
+}
+
+/**
+ * Reads input bytes, decompressing them if the file is compressed.
+ *
+ * @param [in,out] pReader Pointer to reader.
+ * @param [out] pDest Destination.
+ * @param [in] length Number of bytes wanted.
+ * @return number of bytes read, less than length at the end of the input.
+ */
+static size_t Decode_Read(DecodeReaderType* pReader, unsigned char* pDest, size_t length)
+{
+   if (pReader->isBufferFile) {
+      if (length > pReader->unreadLength) {
+         length = (size_t) pReader->unreadLength;
+      }
+      size_t bytesRead = fread(pDest, 1, length, pReader->pFile);
+      pReader->unreadLength -= bytesRead;
+      return bytesRead;
+   }
+   if (!pReader->isCompressed) {
+      return fread(pDest, 1, length, pReader->pFile);
+   }
+
+   size_t bytesRead = 0;
+   while (bytesRead < length) {
+      if (pReader->blockPos == pReader->blockLength && (pReader->blockIsBad || !Decode_NextBlock(pReader))) {
+         break;
+      }
+      size_t copyLength = pReader->blockLength - pReader->blockPos;
+      if (copyLength > length - bytesRead) {
+         copyLength = length - bytesRead;
+      }
+      memcpy(pDest + bytesRead, pReader->pBlock + pReader->blockPos, copyLength);
+      pReader->blockPos += copyLength;
+      bytesRead += copyLength;
+   }
+   return bytesRead;
+}
+
+/**
+ * Makes sure at least byteCount unparsed bytes are in the window, unless the file ends first.
+ *
+ * @param [in,out] pReader Pointer to reader.
+ * @param [in] byteCount Number of bytes needed.
+ * @return number of unparsed bytes available.
+ */
+static size_t Decode_Fill(DecodeReaderType* pReader, size_t byteCount)
+{
+   if (pReader->length - pReader->pos >= byteCount) {
+      return pReader->length - pReader->pos;
+   }
+
+   // move unparsed bytes to the front
+   if (0 != pReader->pos) {
+      memmove(pReader->pData, pReader->pData + pReader->pos, pReader->length - pReader->pos);
+      pReader->fileOffset += pReader->pos;
+      pReader->length -= pReader->pos;
+      pReader->pos = 0;
+   }
+
+   // grow for records larger than the window
+   if (pReader->capacity < byteCount + READ_CHUNK_SIZE) {
+      unsigned char* pData = (unsigned char*) realloc(pReader->pData, byteCount + READ_CHUNK_SIZE);
+      if (NULL == pData) {
+         return pReader->length;
+      }
+      pReader->pData = pData;
+      pReader->capacity = byteCount + READ_CHUNK_SIZE;
+   }
+
+   pReader->length += Decode_Read(pReader, pReader->pData + pReader->length, pReader->capacity - pReader->length);
+   return pReader->length;
+}
+
+/**
+ * Reads a varint from the window.
+ *
+ * @param [in,out] pReader Pointer to reader.
+ * @param [out] pValue Value read.
+ * @return true if a complete varint was read.
+ */
+static bool Decode_ReadVarint(DecodeReaderType* pReader, uint64_t* pValue)
+{
+   size_t available = Decode_Fill(pReader, TEXTLOGGER_BINARY_MAX_VARINT_LENGTH);
+   size_t length = TextLogger_BinaryGetVarint(pReader->pData + pReader->pos, available, pValue);
+   pReader->pos += length;
+   return (0 != length);
+}
+
+/**
+ * Writes "[YYYY-MM-DD | HH:MM:SS] " for a timestamp, in local time like the logger does.
+ *
+ * @param [in] timeStamp Seconds since the epoch.
+ * @param [in,out] pOutput Output stream.
+ */
+static void Decode_PrintTimeStamp(time_t timeStamp, FILE* pOutput)
+{
+   struct tm timeinfo;
+   localtime_r(&timeStamp, &timeinfo);
+   fprintf(pOutput, "[%04d-%02d-%02d | %02d:%02d:%02d] ",
+           (timeinfo.tm_year) + 1900, (timeinfo.tm_mon) + 1, timeinfo.tm_mday,   // tm_year is years since 1900, tm_mon values are from 0-11
+           timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+}
+
+/**
+ * Checks if a record is to be printed.
+ *
+ * @param [in] pReader Pointer to reader.
+ * @param [in] timeStamp Time of the record, or of the record before it for lines without one.
+ * @return true if no range is set or timeStamp is in it.
+ */
+static bool Decode_IsInRange(const DecodeReaderType* pReader, int64_t timeStamp)
+{
+   return !pReader->rangeIsSet || (timeStamp >= pReader->fromTimeStamp && timeStamp <= pReader->toTimeStamp);
+}
+
+/**
+ * Decodes every record of a binary log file to text.
+ *
+ * @param [in,out] pReader Pointer to reader positioned after the magic.
+ * @param [in,out] pOutput Output stream.
+ * @return 0 if the whole file was decoded.
+ * @return 1 if the file ends with a truncated or malformed record.
+ */
+static int Decode_Records(DecodeReaderType* pReader, FILE* pOutput)
+{
+   int64_t lastTimeStamp = 0;
+
+   while (0 < Decode_Fill(pReader, 1)) {
+      long int recordOffset = pReader->fileOffset + (long int) pReader->pos;
+      unsigned char tag = pReader->pData[pReader->pos++];
+      unsigned char level = tag & TEXTLOGGER_BINARY_LEVEL_MASK;
+      if (5 < level) {
+         fprintf(stderr, "textlog_decode: invalid record tag 0x%02x at offset %ld\n", tag, recordOffset);
+         return 1;
+      }
+
+      // timestamp
+      uint64_t value;
+      if (TEXTLOGGER_BINARY_LEVEL_RAW_TEXT != level) {
+         if (!Decode_ReadVarint(pReader, &value)) {
+            fprintf(stderr, "textlog_decode: truncated record at offset %ld\n", recordOffset);
+            return 1;
+         }
+         if (0 != (tag & TEXTLOGGER_BINARY_ABSOLUTE_TIME)) {
+            lastTimeStamp = (int64_t) value;
+         } else {
+            lastTimeStamp += TextLogger_BinaryZigzagDecode(value);
+         }
+      }
+
+      // payload
+      if (!Decode_ReadVarint(pReader, &value) || Decode_Fill(pReader, value) < value) {
+         fprintf(stderr, "textlog_decode: truncated record at offset %ld\n", recordOffset);
+         return 1;
+      }
+      if (Decode_IsInRange(pReader, lastTimeStamp)) {
+         if (TEXTLOGGER_BINARY_LEVEL_RAW_TEXT != level) {
+            Decode_PrintTimeStamp((time_t) lastTimeStamp, pOutput);
+            fputs(spLevelTags[level], pOutput);
+         }
+         fwrite(pReader->pData + pReader->pos, 1, value, pOutput);
+         if (TEXTLOGGER_BINARY_LEVEL_RAW_TEXT != level) {
+            fputc('\n', pOutput);
+         }
+      }
+      pReader->pos += value;
+   }
+
+   return 0;
+}
+
+/**
+ * Reads the timestamp a text record line starts with.
+ *
+ * @param [in] pLine Start of the line.
+ * @param [in] length Length of the line.
+ * @param [out] pTimeStamp Seconds since the epoch, in local time like the logger writes them.
+ * @return true if the line starts with "[YYYY-MM-DD | HH:MM:SS] ".
+ */
+static bool Decode_ParseTimeStamp(const unsigned char* pLine, size_t length, int64_t* pTimeStamp)
+{
+   char pText[TIMESTAMP_STR_LENGTH + 1];
+   if (TIMESTAMP_STR_LENGTH > length || '[' != pLine[0] || ']' != pLine[TIMESTAMP_STR_LENGTH - 2]) {
+      return false;
+   }
+   memcpy(pText, pLine, TIMESTAMP_STR_LENGTH);
+   pText[TIMESTAMP_STR_LENGTH] = '\0';
+
+   struct tm timeinfo = { 0 };
+   if (6 != sscanf(pText, "[%4d-%2d-%2d | %2d:%2d:%2d]", &timeinfo.tm_year, &timeinfo.tm_mon, &timeinfo.tm_mday,
+                   &timeinfo.tm_hour, &timeinfo.tm_min, &timeinfo.tm_sec)) {
+      return false;
+   }
+   timeinfo.tm_year -= 1900;
+   timeinfo.tm_mon -= 1;
+   timeinfo.tm_isdst = -1;
+   *pTimeStamp = (int64_t) mktime(&timeinfo);
+   return true;
+}
+
+/**
+ * Copies the decompressed contents of a compressed text log file, or the
+ * records of a text buffer file. With a range set, lines are printed if
+ * the record they belong to is in it.
+ *
+ * @param [in,out] pReader Pointer to reader.
+ * @param [in,out] pOutput Output stream.
+ */
+static void Decode_Text(DecodeReaderType* pReader, FILE* pOutput)
+{
+   if (!pReader->rangeIsSet) {
+      while (0 < Decode_Fill(pReader, 1)) {
+         fwrite(pReader->pData + pReader->pos, 1, pReader->length - pReader->pos, pOutput);
+         pReader->pos = pReader->length;
+      }
+      return;
+   }
+
+   int64_t timeStamp = pReader->fromTimeStamp - 1; // lines before the first record are skipped
+   size_t available = Decode_Fill(pReader, 1);
+   while (0 < available) {
+      // whole line in the window, or the rest of the input
+      const unsigned char* pLine = pReader->pData + pReader->pos;
+      const unsigned char* pEnd = (const unsigned char*) memchr(pLine, '\n', available);
+      if (NULL == pEnd) {
+         size_t moreAvailable = Decode_Fill(pReader, available + 1);
+         if (moreAvailable > available) {
+            available = moreAvailable;
+            continue;
+         }
+      }
+      size_t lineLength = (NULL != pEnd) ? (size_t) (pEnd - pLine) + 1 : available;
+
+      Decode_ParseTimeStamp(pLine, lineLength, &timeStamp);
+      if (Decode_IsInRange(pReader, timeStamp)) {
+         fwrite(pLine, 1, lineLength, pOutput);
+      }
+      pReader->pos += lineLength;
+      available = Decode_Fill(pReader, 1);
+   }
+}
+
+/**
+ * Reads the index block at the end of a compressed file.
+ *
+ * @param [in,out] pFile Compressed log file.
+ * @param [out] pIndex Index read, pEntries to be freed by the caller.
+ * @return true if the file ends with a complete index block.
+ */
+static bool Decode_ReadIndex(FILE* pFile, DecodeIndexType* pIndex)
+{
+   unsigned char pTrailer[TEXTLOGGER_LZ_INDEX_TRAILER_SIZE];
+   if (0 != fseek(pFile, 0L, SEEK_END)) {
+      return false;
+   }
+   long int fileSize = ftell(pFile);
+   if (TEXTLOGGER_LZ_MAGIC_LENGTH + TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + TEXTLOGGER_LZ_INDEX_TRAILER_SIZE > fileSize ||
+       0 != fseek(pFile, fileSize - TEXTLOGGER_LZ_INDEX_TRAILER_SIZE, SEEK_SET) ||
+       TEXTLOGGER_LZ_INDEX_TRAILER_SIZE != fread(pTrailer, 1, TEXTLOGGER_LZ_INDEX_TRAILER_SIZE, pFile) ||
+       0 != memcmp(pTrailer + 12, TEXTLOGGER_LZ_INDEX_MAGIC, TEXTLOGGER_LZ_INDEX_MAGIC_LENGTH)) {
+      return false;
+   }
+
+   // trailer gives the size of the whole index block
+   uint32_t entryCount = TextLogger_LzGet32(pTrailer);
+   size_t dataLength = (size_t) entryCount * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE + TEXTLOGGER_LZ_INDEX_TRAILER_SIZE;
+   if ((size_t) fileSize < TEXTLOGGER_LZ_MAGIC_LENGTH + TEXTLOGGER_LZ_BLOCK_HEADER_SIZE + dataLength) {
+      return false;
+   }
+   pIndex->indexOffset = fileSize - TEXTLOGGER_LZ_BLOCK_HEADER_SIZE - (long int) dataLength;
+   pIndex->firstIndexedOffset = (long int) TextLogger_LzGet64(pTrailer + 4);
+
+   unsigned char pHeader[TEXTLOGGER_LZ_BLOCK_HEADER_SIZE];
+   unsigned char* pData = (unsigned char*) malloc(dataLength);
+   pIndex->pEntries = (TextLoggerLzIndexEntryType*) malloc((entryCount + 1) * sizeof(TextLoggerLzIndexEntryType));
+   bool indexIsValid = (NULL != pData && NULL != pIndex->pEntries && 0 == fseek(pFile, pIndex->indexOffset, SEEK_SET) &&
+                        TEXTLOGGER_LZ_BLOCK_HEADER_SIZE == fread(pHeader, 1, TEXTLOGGER_LZ_BLOCK_HEADER_SIZE, pFile) &&
+                        dataLength == fread(pData, 1, dataLength, pFile));
+   indexIsValid = indexIsValid && (TEXTLOGGER_LZ_STORED | TEXTLOGGER_LZ_INDEX | (uint32_t) dataLength) == TextLogger_LzGet32(pHeader) &&
+                  TextLogger_LzGet32(pHeader + 8) == TextLogger_LzChecksum(pData, dataLength);
+   if (indexIsValid) {
+      for (uint32_t index = 0; index < entryCount; index++) {
+         TextLogger_LzGetIndexEntry(pData + index * TEXTLOGGER_LZ_INDEX_ENTRY_SIZE, &pIndex->pEntries[index]);
+      }
+      pIndex->entryCount = entryCount;
+   } else {
+      free(pIndex->pEntries);
+      pIndex->pEntries = NULL;
+   }
+
+   free(pData);
+   return indexIsValid;
+}
+
+/**
+ * Counts the records starting in a block.
+ *
+ * @param [in] pEntry Index entry of the block.
+ * @return number of records.
+ */
+static uint32_t Decode_RecordCount(const TextLoggerLzIndexEntryType* pEntry)
+{
+   uint32_t recordCount = 0;
+   for (int index = 0; index < TEXTLOGGER_LZ_LEVEL_COUNT; index++) {
+      recordCount += pEntry->pLevelCounts[index];
+   }
+   return recordCount;
+}
+
+/**
+ * Limits reading to the blocks that can hold records of the range: binary
+ * search for the first block that ends at or after fromTimeStamp, then up to
+ * the first block that starts after toTimeStamp.
+ * Leaves the reader as it is if blocks that are not indexed may be in the range.
+ *
+ * @param [in,out] pReader Pointer to reader, still at the first block.
+ * @param [in] pIndex Index of the file.
+ */
+static void Decode_SeekRange(DecodeReaderType* pReader, const DecodeIndexType* pIndex)
+{
+   const TextLoggerLzIndexEntryType* pEntries = pIndex->pEntries;
+   if (TEXTLOGGER_LZ_MAGIC_LENGTH < pIndex->firstIndexedOffset &&
+       (0 == pIndex->entryCount || pReader->fromTimeStamp < pEntries[0].firstTimeStamp)) {
+      return;
+   }
+
+   uint32_t low = 0;
+   uint32_t high = pIndex->entryCount;
+   while (low < high) {
+      uint32_t middle = low + (high - low) / 2;
+      if (pEntries[middle].lastTimeStamp < pReader->fromTimeStamp) {
+         low = middle + 1;
+      } else {
+         high = middle;
+      }
+   }
+   long int startOffset = (low < pIndex->entryCount) ? (long int) pEntries[low].blockOffset : pIndex->indexOffset;
+
+   pReader->stopOffset = pIndex->indexOffset;
+   for (uint32_t index = low; index < pIndex->entryCount; index++) {
+      if (pEntries[index].firstTimeStamp > pReader->toTimeStamp && 0 < Decode_RecordCount(&pEntries[index])) {
+         pReader->stopOffset = (long int) pEntries[index].blockOffset;
+         break;
+      }
+   }
+
+   // drop what was read from the first block, the window starts over at startOffset
+   pReader->pos = 0;
+   pReader->length = 0;
+   pReader->fileOffset = 0;
+   pReader->blockPos = 0;
+   pReader->blockLength = 0;
+   pReader->blockOffset = startOffset;
+   fseek(pReader->pFile, startOffset, SEEK_SET);
+}
+
+/**
+ * Prints the block index of a compressed file, one line per block.
+ *
+ * @param [in] pIndex Index of the file.
+ * @param [in,out] pOutput Output stream.
+ */
+static void Decode_PrintIndex(const DecodeIndexType* pIndex, FILE* pOutput)
+{
+   if (TEXTLOGGER_LZ_MAGIC_LENGTH < pIndex->firstIndexedOffset) {
+      fprintf(pOutput, "blocks before offset %ld are not indexed\n", pIndex->firstIndexedOffset);
+   }
+   fprintf(pOutput, "offset,first,last,errors,warnings,info,debug,verbose\n");
+   for (uint32_t index = 0; index < pIndex->entryCount; index++) {
+      const TextLoggerLzIndexEntryType* pEntry = &pIndex->pEntries[index];
+      fprintf(pOutput, "%llu,%lld,%lld", (unsigned long long) pEntry->blockOffset,
+              (long long) pEntry->firstTimeStamp, (long long) pEntry->lastTimeStamp);
+      for (int level = 0; level < TEXTLOGGER_LZ_LEVEL_COUNT; level++) {
+         fprintf(pOutput, ",%u", (unsigned int) pEntry->pLevelCounts[level]);
+      }
+      fputc('\n', pOutput);
+   }
+}
+
+/**
+ * Parses a time given on the command line.
+ *
+ * @param [in] pText Seconds since the epoch, or a negative number of seconds before now.
+ * @param [out] pTimeStamp Seconds since the epoch.
+ * @return true if pText is a number.
+ */
+static bool Decode_ParseTime(const char* pText, int64_t* pTimeStamp)
+{
+   char* pEnd;
+   long long value = strtoll(pText, &pEnd, 10);
+   if (pEnd == pText || '\0' != *pEnd) {
+      return false;
+   }
+   *pTimeStamp = (0 > value) ? (int64_t) time(NULL) + value : (int64_t) value;
+   return true;
+}
+
+/**
+ * main decodes a TEXTLOGGER_FORMAT_BINARY log file back to the text format,
+ * and decompresses log files written with TEXTLOGGER_COMPRESSION_LZ4.
+ * Timestamps are printed in the local timezone, set TZ to the writer's timezone if it differs.
+ *
+ * usage: textlog_decode [-f from] [-t to] [-i] <binary or compressed log file> [output text file]
+ * -f and -t print only the records logged in that range, given in seconds since the epoch
+ * or as negative seconds before now: "-f -300" prints the last five minutes. A compressed
+ * file with an index is only decompressed from the first block that can hold the range.
+ * -i prints the block index of a compressed file instead.
+ *
+ * @return 0 if the whole file was decoded.
+ * @return 1 if the file is truncated or malformed.
+ * @return -1 if an error occurs during file-related operations.
+ */
+int main(int argc, char* argv[])
+{
+   DecodeReaderType reader = { 0 };
+   reader.fromTimeStamp = INT64_MIN;
+   reader.toTimeStamp = INT64_MAX;
+   bool indexIsPrinted = false;
+   bool argumentsAreValid = true;
+   int option;
+   while (-1 != (option = getopt(argc, argv, "f:t:i"))) {
+      if ('f' == option) {
+         argumentsAreValid = argumentsAreValid && Decode_ParseTime(optarg, &reader.fromTimeStamp);
+         reader.rangeIsSet = true;
+      } else if ('t' == option) {
+         argumentsAreValid = argumentsAreValid && Decode_ParseTime(optarg, &reader.toTimeStamp);
+         reader.rangeIsSet = true;
+      } else if ('i' == option) {
+         indexIsPrinted = true;
+      } else {
+         argumentsAreValid = false;
+      }
+   }
+   if (!argumentsAreValid || 1 > argc - optind || 2 < argc - optind) {
+      fprintf(stderr, "usage: %s [-f from] [-t to] [-i] <binary, compressed or buffer file> [output text file]\n", argv[0]);
+      return -1;
+   }
+   const char* pInputPath = argv[optind];
+   const char* pOutputPath = (2 == argc - optind) ? argv[optind + 1] : NULL;
+
+   reader.pFile = fopen(pInputPath, "rb");
+   if (NULL == reader.pFile) {
+      fprintf(stderr, "textlog_decode: cannot open %s\n", pInputPath);
+      return -1;
+   }
+
+   FILE* pOutput = stdout;
+   if (NULL != pOutputPath) {
+      pOutput = fopen(pOutputPath, "wb");
+      if (NULL == pOutput) {
+         fprintf(stderr, "textlog_decode: cannot open %s\n", pOutputPath);
+         fclose(reader.pFile);
+         return -1;
+      }
+   }
+
+   // compressed file holds a text or binary log file in its blocks
+   unsigned char pMagic[TEXTLOGGER_LZ_MAGIC_LENGTH];
+   size_t magicLength = fread(pMagic, 1, TEXTLOGGER_LZ_MAGIC_LENGTH, reader.pFile);
+   if (TEXTLOGGER_LZ_MAGIC_LENGTH == magicLength && 0 == memcmp(pMagic, TEXTLOGGER_LZ_MAGIC, TEXTLOGGER_LZ_MAGIC_LENGTH)) {
+      reader.isCompressed = true;
+      reader.blockOffset = TEXTLOGGER_LZ_MAGIC_LENGTH;
+   } else {
+      rewind(reader.pFile);
+   }
+
+   // buffer file left by a killed process holds its records not written to the log file yet
+   TextLoggerPersistHeaderType bufferHeader;
+   if (TEXTLOGGER_PERSIST_MAGIC_LENGTH == magicLength && 0 == memcmp(pMagic, TEXTLOGGER_PERSIST_MAGIC, TEXTLOGGER_PERSIST_MAGIC_LENGTH)) {
+      if (1 != fread(&bufferHeader, sizeof(bufferHeader), 1, reader.pFile) || bufferHeader.writeHead > bufferHeader.bufferSize) {
+         fprintf(stderr, "textlog_decode: %s has a corrupt header\n", pInputPath);
+         fclose(reader.pFile);
+         if (stdout != pOutput) {
+            fclose(pOutput);
+         }
+         return -1;
+      }
+      reader.isBufferFile = true;
+      reader.unreadLength = bufferHeader.writeHead;
+      fseek(reader.pFile, TEXTLOGGER_PERSIST_HEADER_SIZE, SEEK_SET);
+   }
+
+   // index is read before anything else moves the file position
+   DecodeIndexType index = { 0 };
+   bool indexIsRead = reader.isCompressed && (indexIsPrinted || reader.rangeIsSet) && Decode_ReadIndex(reader.pFile, &index);
+   if (reader.isCompressed) {
+      fseek(reader.pFile, TEXTLOGGER_LZ_MAGIC_LENGTH, SEEK_SET);
+   }
+
+   // the first bytes tell binary from text, seeking to the range comes after
+   int result = 0;
+   size_t available = Decode_Fill(&reader, TEXTLOGGER_BINARY_MAGIC_LENGTH);
+   bool isBinary = (available >= TEXTLOGGER_BINARY_MAGIC_LENGTH && 0 == memcmp(reader.pData, TEXTLOGGER_BINARY_MAGIC, TEXTLOGGER_BINARY_MAGIC_LENGTH));
+   if (reader.isBufferFile) {
+      isBinary = (0 != bufferHeader.format); // records only, no magic
+   } else if (isBinary) {
+      reader.pos = TEXTLOGGER_BINARY_MAGIC_LENGTH;
+   }
+   if (indexIsRead && reader.rangeIsSet && !indexIsPrinted) {
+      Decode_SeekRange(&reader, &index);
+   }
+
+   if (indexIsPrinted && indexIsRead) {
+      Decode_PrintIndex(&index, pOutput);
+   } else if (indexIsPrinted) {
+      fprintf(stderr, "textlog_decode: %s has no block index\n", pInputPath);
+      result = 1;
+   } else if (isBinary) {
+      result = Decode_Records(&reader, pOutput);
+   } else if (reader.isCompressed || reader.isBufferFile) {
+      Decode_Text(&reader, pOutput);
+   } else {
+      fprintf(stderr, "textlog_decode: %s is not a binary, compressed or buffer file\n", pInputPath);
+      result = 1;
+   }
+   if (reader.blockIsBad) {
+      result = 1;
+   }
+
+   free(index.pEntries);
+   free(reader.pBlock);
+   free(reader.pCompressed);
+   free(reader.pData);
+   fclose(reader.pFile);
+   if (stdout != pOutput) {
+      fclose(pOutput);
+   }
+   return result;
+}